@@ -0,0 +1,46 @@
+QT       += core gui
+
+#mesh.h includes QApplication (QtWidgets in Qt 5)
+greaterThan(QT_MAJOR_VERSION, 4): QT += widgets
+
+CONFIG += c++11 console
+CONFIG -= app_bundle
+
+TARGET = Real3DBenchmark
+TEMPLATE = app
+
+SOURCES += benchmark/main.cpp \
+    maths/imageprocessing.cpp \
+    maths/environmentmap.cpp \
+    maths/mathfunctions.cpp \
+    maths/meshsimplification.cpp \
+    opengl/mesh.cpp \
+    opengl/compressedmesh.cpp \
+    other/PFMReadWrite.cpp \
+    other/HDRReadWrite.cpp \
+    other/datacache.cpp
+
+HEADERS  += \
+    maths/imageprocessing.h \
+    maths/environmentmap.h \
+    maths/mathfunctions.h \
+    maths/meshsimplification.h \
+    opengl/mesh.h \
+    opengl/compressedmesh.h \
+    opengl/openglheaders.h \
+    other/PFMReadWrite.h \
+    other/HDRReadWrite.h \
+    other/datacache.h \
+    other/parallel.h
+
+#The mesh uses the OpenGL types of GLEW
+win32:{
+
+    INCLUDEPATH += "C:/glew-1.13.0/include"
+    LIBS += "C:/glew-1.13.0/lib/Release/x64/glew32.lib"
+}
+else:unix{
+    LIBS += -lGLEW
+}
+
+include(opencv.pri)
@@ -0,0 +1,602 @@
+/*
+ *     Real3D
+ *
+ *     Author:  Antoine TOISOUL LE CANN
+ *
+ *     Copyright © 2016 Antoine TOISOUL LE CANN, Imperial College London
+ *              All rights reserved
+ *
+ *
+ * Real3D is free software: you can redistribute it and/or modify
+ *
+ * it under the terms of the GNU Lesser General Public License as published by
+ *
+ * the Free Software Foundation, either version 3 of the License, or
+ *
+ * (at your option) any later version.
+ *
+ * Real3D is distributed in the hope that it will be useful,
+ *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ *
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * \file main.cpp
+ * \brief Benchmark of the CPU side of Real3D.
+ * \author Antoine Toisoul Le Cann
+ * \date October, 16th, 2026
+ *
+ * Times the image loaders and writers, the image processing functions and the mesh loader
+ * on synthetic inputs of several sizes. The results are printed as a table, CSV or JSON.
+ * Usage : Real3DBenchmark [--csv | --json] [--output filePath] [--runs numberOfRuns] [--directory temporaryDirectory]
+ */
+
+#include "maths/imageprocessing.h"
+#include "maths/environmentmap.h"
+#include "other/datacache.h"
+#include "opengl/mesh.h"
+#include "other/parallel.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <cstdio>
+#include <sstream>
+
+using namespace std;
+using namespace cv;
+
+/**
+ * Time and throughput of a benchmarked function for a given input size.
+ */
+struct BenchmarkResult
+{
+    string name; /*!< Name of the benchmarked function. */
+    string size; /*!< Size of the input. */
+    double milliseconds; /*!< Best time of the runs in milliseconds. */
+    double throughput; /*!< Amount of data processed per second. */
+    string unit; /*!< Unit of the throughput (MB/s or triangles/s). */
+};
+
+/**
+ * Returns the best time in milliseconds of numberOfRuns calls to function.
+ * @brief bestTime
+ * @param function
+ * @param numberOfRuns
+ * @return
+ */
+template<typename Function>
+static double bestTime(Function function, int numberOfRuns)
+{
+    double best = 0.0;
+
+    for(int k = 0 ; k<numberOfRuns ; ++k)
+    {
+        chrono::high_resolution_clock::time_point start = chrono::high_resolution_clock::now();
+        function();
+        chrono::high_resolution_clock::time_point end = chrono::high_resolution_clock::now();
+
+        double time = chrono::duration<double, milli>(end-start).count();
+
+        if(k == 0 || time<best)
+            best = time;
+    }
+
+    return best;
+}
+
+/**
+ * Adds the result of a benchmark. The throughput is amount/second in the given unit.
+ * @brief addResult
+ * @param results
+ * @param name
+ * @param size
+ * @param milliseconds
+ * @param amount
+ * @param unit
+ */
+static void addResult(vector<BenchmarkResult>& results, const string name, const string size, double milliseconds, double amount, const string unit)
+{
+    BenchmarkResult result;
+    result.name = name;
+    result.size = size;
+    result.milliseconds = milliseconds;
+    result.throughput = (milliseconds > 0.0) ? amount/(milliseconds/1000.0) : 0.0;
+    result.unit = unit;
+
+    results.push_back(result);
+}
+
+/**
+ * Returns true if both images have the same size, type and pixels.
+ * @brief identicalImages
+ * @param image1
+ * @param image2
+ * @return
+ */
+static bool identicalImages(const Mat& image1, const Mat& image2)
+{
+    if(image1.rows != image2.rows || image1.cols != image2.cols || image1.type() != image2.type())
+        return false;
+
+    for(int i = 0 ; i<image1.rows ; ++i)
+    {
+        if(memcmp(image1.ptr(i), image2.ptr(i), image1.cols*image1.elemSize()) != 0)
+            return false;
+    }
+
+    return true;
+}
+
+/**
+ * Times the PFM and HDR loaders and writers and the image processing functions on a synthetic width x height HDR image.
+ * Returns false if an image is not loaded back identically.
+ * @brief benchmarkImages
+ * @param width
+ * @param height
+ * @param numberOfRuns
+ * @param directory
+ * @param results
+ * @return
+ */
+static bool benchmarkImages(int width, int height, int numberOfRuns, const string directory, vector<BenchmarkResult>& results)
+{
+    //Synthetic HDR latitude longitude map
+    Mat image(height, width, CV_32FC3);
+    Mat image8U(height, width, CV_8UC3);
+
+    for(int i = 0 ; i<height ; ++i)
+    {
+        float* row = image.ptr<float>(i);
+        unsigned char* row8U = image8U.ptr<unsigned char>(i);
+
+        for(int j = 0 ; j<3*width ; ++j)
+        {
+            row[j] = (float) ((i*31+j*17)%1000)/100.0f;
+            row8U[j] = (unsigned char) ((i*31+j*17)%256);
+        }
+    }
+
+    ostringstream sizeStream;
+    sizeStream << width << "x" << height;
+    const string size = sizeStream.str();
+
+    const double sizeMB = (double) width*height*3*sizeof(float)/(1024.0*1024.0);
+    const double size8UMB = (double) width*height*3/(1024.0*1024.0);
+
+    const string PFMFilePath = directory + "/benchmark.pfm";
+    const string HDRFilePath = directory + "/benchmark.hdr";
+
+    bool saved = true;
+    addResult(results, "savePFM", size, bestTime([&]() { saved = saved && savePFM(image, PFMFilePath); }, numberOfRuns), sizeMB, "MB/s");
+    addResult(results, "saveHDR", size, bestTime([&]() { saved = saved && saveHDR(image, HDRFilePath); }, numberOfRuns), sizeMB, "MB/s");
+
+    if(!saved)
+    {
+        cerr << "Could not save the benchmark images in " << directory << endl;
+        return false;
+    }
+
+    //The files are in the page cache after being saved : the times measure the decoding cost
+    Mat result, resultParallel, resultHDR;
+    addResult(results, "loadPFM", size, bestTime([&]() { result = loadPFM(PFMFilePath); }, numberOfRuns), sizeMB, "MB/s");
+    addResult(results, "loadPFMParallel", size, bestTime([&]() { resultParallel = loadPFMParallel(PFMFilePath); }, numberOfRuns), sizeMB, "MB/s");
+    addResult(results, "loadHDR", size, bestTime([&]() { resultHDR = loadHDR(HDRFilePath); }, numberOfRuns), sizeMB, "MB/s");
+
+    //A cache entry is mapped in memory : hashFile is measured on the saved PFM (the hash is kept in memory afterwards)
+    DataCache cache(directory + "/BenchmarkCache");
+    const uint64_t key = cacheKey(hashData(image.data, image.total()*image.elemSize()), "benchmark");
+    Mat resultCache;
+    addResult(results, "DataCache::store", size, bestTime([&]() { saved = saved && cache.store(key, vector<Mat>(1, image)); }, numberOfRuns), sizeMB, "MB/s");
+    addResult(results, "DataCache::load", size, bestTime([&]() { DataCacheEntry entry; if(cache.load(key, entry)) resultCache = entry.getImage(0); }, numberOfRuns), sizeMB, "MB/s");
+    addResult(results, "hashFile", size, bestTime([&]() { hashFile(PFMFilePath); }, 1), sizeMB, "MB/s");
+
+    remove(PFMFilePath.c_str());
+    remove(HDRFilePath.c_str());
+    DataCache(cache.getDirectory(), 0).evict();
+
+    Mat imageWithGamma, imageWithoutGamma, flippedImage = image.clone();
+    addResult(results, "gammaCorrection", size, bestTime([&]() { gammaCorrection(image, imageWithGamma, 2.2); }, numberOfRuns), sizeMB, "MB/s");
+    Mat imageFloat = image.clone();
+    unsigned int imageWidth(width), imageHeight(height), numberOfComponents(3);
+    addResult(results, "gammaCorrection (float*)", size, bestTime([&]() { gammaCorrection((float*) imageFloat.data, imageWidth, imageHeight, numberOfComponents, 2.2f); }, numberOfRuns), sizeMB, "MB/s");
+    addResult(results, "removeGammaCorrection", size, bestTime([&]() { removeGammaCorrection(image8U, imageWithoutGamma, 2.2); }, numberOfRuns), size8UMB, "MB/s");
+    Mat EMDiffuse;
+    addResult(results, "diffuseConvolution", size, bestTime([&]() { EMDiffuse = diffuseConvolution(image); }, numberOfRuns), sizeMB, "MB/s");
+    vector<Mat> EMRough;
+    addResult(results, "prefilterSpecular", size, bestTime([&]() { prefilterSpecular(image, EMRough, EM_SPECULAR_PREVIEW_SAMPLES); }, numberOfRuns), sizeMB, "MB/s");
+    Mat EMCubemap;
+    addResult(results, "latLongToCubemap", size, bestTime([&]() { EMCubemap = latLongToCubemap(image, cubemapFaceSize(image)); }, numberOfRuns), sizeMB, "MB/s");
+    addResult(results, "inverseYAxis", size, bestTime([&]() { inverseYAxis(image, flippedImage); }, numberOfRuns), sizeMB, "MB/s");
+
+    bool identical = identicalImages(image, result) && identicalImages(image, resultParallel) && identicalImages(image, resultCache)
+            && resultHDR.rows == height && resultHDR.cols == width;
+
+    if(!identical)
+    {
+        cerr << "The images loaded are different from the images saved (" << size << ")" << endl;
+    }
+
+    return identical;
+}
+
+/**
+ * Writes a square grid of numberOfQuadsPerSide x numberOfQuadsPerSide quads (two triangles each) in the OFF format.
+ * Returns false if the file cannot be written.
+ * @brief writeGridOFF
+ * @param filePath
+ * @param numberOfQuadsPerSide
+ * @return
+ */
+static bool writeGridOFF(const string filePath, int numberOfQuadsPerSide)
+{
+    ofstream file(filePath.c_str(), ios::out | ios::trunc);
+
+    if(!file)
+        return false;
+
+    const int n = numberOfQuadsPerSide;
+
+    file << "OFF" << '\n';
+    file << (n+1)*(n+1) << " " << 2*n*n << " 0" << '\n';
+
+    //Vertices of a gently curved surface
+    for(int i = 0 ; i<=n ; ++i)
+    {
+        for(int j = 0 ; j<=n ; ++j)
+        {
+            float x = (float) j/n-0.5f;
+            float y = (float) i/n-0.5f;
+            file << x << " " << y << " " << 0.1f*sin(6.0f*x)*cos(6.0f*y) << '\n';
+        }
+    }
+
+    for(int i = 0 ; i<n ; ++i)
+    {
+        for(int j = 0 ; j<n ; ++j)
+        {
+            int v0 = i*(n+1)+j;
+            file << "3 " << v0 << " " << v0+1 << " " << v0+n+2 << '\n';
+            file << "3 " << v0 << " " << v0+n+2 << " " << v0+n+1 << '\n';
+        }
+    }
+
+    return (bool) file;
+}
+
+/**
+ * Writes the grid of writeGridOFF in the binary little endian PLY format, with texture coordinates,
+ * and in the OBJ format, with a texture coordinate per vertex.
+ * Returns false if a file cannot be written.
+ * @brief writeGridPLYAndOBJ
+ * @param plyFilePath
+ * @param objFilePath
+ * @param numberOfQuadsPerSide
+ * @return
+ */
+static bool writeGridPLYAndOBJ(const string plyFilePath, const string objFilePath, int numberOfQuadsPerSide)
+{
+    ofstream plyFile(plyFilePath.c_str(), ios::out | ios::trunc | ios::binary);
+    ofstream objFile(objFilePath.c_str(), ios::out | ios::trunc);
+
+    if(!plyFile || !objFile)
+        return false;
+
+    const int n = numberOfQuadsPerSide;
+
+    plyFile << "ply\nformat binary_little_endian 1.0\n";
+    plyFile << "element vertex " << (n+1)*(n+1) << "\nproperty float x\nproperty float y\nproperty float z\nproperty float u\nproperty float v\n";
+    plyFile << "element face " << 2*n*n << "\nproperty list uchar int vertex_indices\nend_header\n";
+
+    //The benchmark runs on little endian machines
+    for(int i = 0 ; i<=n ; ++i)
+    {
+        for(int j = 0 ; j<=n ; ++j)
+        {
+            float vertex[5] = {(float) j/n-0.5f, (float) i/n-0.5f, 0.0f, (float) j/n, (float) i/n};
+            vertex[2] = 0.1f*sin(6.0f*vertex[0])*cos(6.0f*vertex[1]);
+            plyFile.write((const char*) vertex, sizeof(vertex));
+            objFile << "v " << vertex[0] << " " << vertex[1] << " " << vertex[2] << '\n';
+            objFile << "vt " << vertex[3] << " " << vertex[4] << '\n';
+        }
+    }
+
+    for(int i = 0 ; i<n ; ++i)
+    {
+        for(int j = 0 ; j<n ; ++j)
+        {
+            int v0 = i*(n+1)+j;
+            int triangles[2][3] = {{v0, v0+1, v0+n+2}, {v0, v0+n+2, v0+n+1}};
+
+            for(int k = 0 ; k<2 ; ++k)
+            {
+                const unsigned char numberOfVertices = 3;
+                plyFile.write((const char*) &numberOfVertices, 1);
+                plyFile.write((const char*) triangles[k], sizeof(triangles[k]));
+                objFile << "f " << triangles[k][0]+1 << "/" << triangles[k][0]+1 << " " << triangles[k][1]+1 << "/" << triangles[k][1]+1
+                        << " " << triangles[k][2]+1 << "/" << triangles[k][2]+1 << '\n';
+            }
+        }
+    }
+
+    return (bool) plyFile && (bool) objFile;
+}
+
+/**
+ * Times the OFF, PLY and OBJ readers, the mesh cache, the reordering of the triangles and the computation of the normals and tangents on a synthetic grid.
+ * Returns false if the mesh is not read correctly.
+ * @brief benchmarkMesh
+ * @param numberOfQuadsPerSide
+ * @param numberOfRuns
+ * @param directory
+ * @param results
+ * @return
+ */
+static bool benchmarkMesh(int numberOfQuadsPerSide, int numberOfRuns, const string directory, vector<BenchmarkResult>& results)
+{
+    const string filePath = directory + "/benchmark.off";
+    const string plyFilePath = directory + "/benchmark.ply";
+    const string objFilePath = directory + "/benchmark.obj";
+
+    if(!writeGridOFF(filePath, numberOfQuadsPerSide) || !writeGridPLYAndOBJ(plyFilePath, objFilePath, numberOfQuadsPerSide))
+    {
+        cerr << "Could not write the files : " << filePath << endl;
+        return false;
+    }
+
+    const int numberOfTriangles = 2*numberOfQuadsPerSide*numberOfQuadsPerSide;
+
+    ostringstream sizeStream;
+    sizeStream << numberOfTriangles << " triangles";
+    const string size = sizeStream.str();
+
+    Mesh mesh;
+    addResult(results, "Mesh::offReader", size, bestTime([&]() { mesh = Mesh(); mesh.offReader(filePath); }, numberOfRuns), numberOfTriangles, "triangles/s");
+    addResult(results, "Mesh::computeNormals", size, bestTime([&]() { mesh.computeNormals(); }, numberOfRuns), numberOfTriangles, "triangles/s");
+
+    Mesh plyMesh;
+    Mesh objMesh;
+    addResult(results, "Mesh::plyReader", size, bestTime([&]() { plyMesh = Mesh(); plyMesh.plyReader(plyFilePath); }, numberOfRuns), numberOfTriangles, "triangles/s");
+    addResult(results, "Mesh::objReader", size, bestTime([&]() { objMesh = Mesh(); objMesh.objReader(objFilePath); }, numberOfRuns), numberOfTriangles, "triangles/s");
+
+    //Tangents of the grid (u along x) : no vertex is split, the tangents are in the plane of the normals and point towards x
+    Mesh tangentMesh;
+    addResult(results, "Mesh::computeTangents", size, bestTime([&]() { tangentMesh = plyMesh; tangentMesh.computeTangents(); }, numberOfRuns), numberOfTriangles, "triangles/s");
+
+    const QVector<QVector4D> tangents = tangentMesh.getVertexTangents();
+    const QVector<QVector3D> tangentNormals = tangentMesh.getVertexNormals();
+    bool tangentsCorrect = (tangents.size() == plyMesh.getNumberOfVertices());
+
+    for(int v = 0 ; v<tangents.size() && tangentsCorrect ; v++)
+    {
+        tangentsCorrect = tangents[v].w() == 1.0f && tangents[v].x() > 0.8f && fabs(QVector3D::dotProduct(tangents[v].toVector3D(), tangentNormals[v])) < 1e-4f;
+    }
+
+    if(!tangentsCorrect)
+    {
+        cerr << "The tangents were not computed correctly (" << size << ")" << endl;
+        return false;
+    }
+
+    //Triangle reordering, on a copy of the mesh in the order of the file
+    Mesh optimizedMesh;
+    const float ratio = mesh.getAverageCacheMissRatio();
+    addResult(results, "Mesh::optimizeIndices", size, bestTime([&]() { optimizedMesh = mesh; optimizedMesh.optimizeIndices(); }, numberOfRuns), numberOfTriangles, "triangles/s");
+
+    if(!(optimizedMesh.getAverageCacheMissRatio() < ratio) || optimizedMesh.getNumberOfIndices() != 3*numberOfTriangles)
+    {
+        cerr << "The triangles were not reordered correctly (" << size << ")" << endl;
+        return false;
+    }
+
+    //Simplification to a quarter of the triangles (the first level of detail of an object)
+    Mesh simplifiedMesh;
+    const int targetNumberOfTriangles = numberOfTriangles/4;
+    addResult(results, "Mesh::simplify", size, bestTime([&]() { simplifiedMesh = mesh.simplify(targetNumberOfTriangles); }, numberOfRuns), numberOfTriangles, "triangles/s");
+
+    if(simplifiedMesh.getNumberOfIndices() > 3*targetNumberOfTriangles || simplifiedMesh.getNumberOfIndices() < 3*targetNumberOfTriangles/2)
+    {
+        cerr << "The mesh was not simplified correctly (" << size << ")" << endl;
+        return false;
+    }
+
+    //Compact vertex format : the float arrays are released, less than half the size of the vertices, positions within half a quantization step,
+    //normals and tangents within a degree
+    Mesh compressedMesh;
+    addResult(results, "Mesh::compress", size, bestTime([&]() { compressedMesh = tangentMesh; compressedMesh.compress(); }, numberOfRuns), numberOfTriangles, "triangles/s");
+
+    const CompressedMesh* compressed = compressedMesh.getCompressedMesh();
+    const QVector<QVector3D> vertices = tangentMesh.getVertices();
+    const QVector<QVector3D> vertexNormals = tangentMesh.getVertexNormals();
+    bool compressedCorrectly = (compressedMesh.getVertexData() == NULL) && (compressedMesh.getNumberOfVertices() == vertices.size())
+                               && (compressed->getNumberOfVertices() == vertices.size()) && (compressed->getNumberOfIndices() == tangentMesh.getNumberOfIndices())
+                               && (2*compressed->getNumberOfVertices()*sizeof(CompressedVertex) < vertices.size()*(2*sizeof(QVector3D)+sizeof(QVector2D)+sizeof(QVector4D)));
+
+    for(int v = 0 ; v<vertices.size() && compressedCorrectly ; v++)
+    {
+        const CompressedVertex& vertex = compressed->getVertexData()[v];
+        const QVector3D positionError = compressed->decodePosition(vertex)-vertices[v];
+        const QVector3D step = compressed->getPositionExtent()/65535.0f;
+
+        compressedCorrectly = fabs(positionError.x()) <= 0.51f*step.x()+1e-7f && fabs(positionError.y()) <= 0.51f*step.y()+1e-7f
+                              && fabs(positionError.z()) <= 0.51f*step.z()+1e-7f
+                              && QVector3D::dotProduct(compressed->decodeNormal(vertex), vertexNormals[v].normalized()) > cos(M_PI/180.0)
+                              && QVector3D::dotProduct(compressed->decodeTangent(vertex).toVector3D(), tangents[v].toVector3D()) > cos(M_PI/180.0)
+                              && compressed->decodeTangent(vertex).w() == tangents[v].w();
+    }
+
+    if(!compressedCorrectly)
+    {
+        cerr << "The mesh was not compressed correctly (" << size << ")" << endl;
+        return false;
+    }
+
+    //Mesh cache : written once, then mapped (readFile gives the vertices of .off files a texture coordinate and a tangent)
+    const string cacheFilePath = filePath + string(MESH_CACHE_EXTENSION);
+    Mesh cachedMesh;
+    mesh.setTextureCoordinates(QVector<QVector2D>(mesh.getNumberOfVertices()));
+    mesh.computeTangents();
+    bool correct = mesh.writeCache(cacheFilePath, filePath) && cachedMesh.readCache(cacheFilePath, filePath, true)
+                   && cachedMesh.getVertices() == mesh.getVertices() && cachedMesh.getVertexNormals() == mesh.getVertexNormals();
+
+    addResult(results, "Mesh::readCache", size, bestTime([&]() { cachedMesh = Mesh(); cachedMesh.readCache(cacheFilePath, filePath); }, numberOfRuns), numberOfTriangles, "triangles/s");
+
+    remove(filePath.c_str());
+    remove(plyFilePath.c_str());
+    remove(objFilePath.c_str());
+    remove(cacheFilePath.c_str());
+
+    //The OBJ reader numbers the vertices in the order of the faces
+    correct = correct && (plyMesh.getIndicesArray() == mesh.getIndicesArray());
+    const Mesh* meshes[3] = {&mesh, &plyMesh, &objMesh};
+
+    for(int k = 0 ; k<3 ; ++k)
+    {
+        correct = correct && meshes[k]->getIndicesArray().size() == 3*numberOfTriangles
+                          && meshes[k]->getVertexNormals().size() == (numberOfQuadsPerSide+1)*(numberOfQuadsPerSide+1);
+    }
+
+    if(!correct)
+    {
+        cerr << "The mesh was not read correctly (" << size << ")" << endl;
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * Prints the results as an aligned table.
+ * @brief printTable
+ * @param output
+ * @param results
+ */
+static void printTable(FILE* output, const vector<BenchmarkResult>& results)
+{
+    fprintf(output, "%-24s %-18s %12s %16s\n", "Function", "Size", "Time (ms)", "Throughput");
+
+    for(size_t k = 0 ; k<results.size() ; ++k)
+    {
+        fprintf(output, "%-24s %-18s %12.3f %16.1f %s\n", results[k].name.c_str(), results[k].size.c_str(),
+                results[k].milliseconds, results[k].throughput, results[k].unit.c_str());
+    }
+}
+
+/**
+ * Prints the results in the CSV format with a header line.
+ * @brief printCSV
+ * @param output
+ * @param results
+ */
+static void printCSV(FILE* output, const vector<BenchmarkResult>& results)
+{
+    fprintf(output, "name,size,milliseconds,throughput,unit\n");
+
+    for(size_t k = 0 ; k<results.size() ; ++k)
+    {
+        fprintf(output, "%s,%s,%.6f,%.3f,%s\n", results[k].name.c_str(), results[k].size.c_str(),
+                results[k].milliseconds, results[k].throughput, results[k].unit.c_str());
+    }
+}
+
+/**
+ * Prints the results in the JSON format.
+ * @brief printJSON
+ * @param output
+ * @param results
+ */
+static void printJSON(FILE* output, const vector<BenchmarkResult>& results)
+{
+    fprintf(output, "{\n  \"threads\": %d,\n  \"results\": [\n", numberOfCores());
+
+    for(size_t k = 0 ; k<results.size() ; ++k)
+    {
+        fprintf(output, "    {\"name\": \"%s\", \"size\": \"%s\", \"milliseconds\": %.6f, \"throughput\": %.3f, \"unit\": \"%s\"}%s\n",
+                results[k].name.c_str(), results[k].size.c_str(), results[k].milliseconds, results[k].throughput,
+                results[k].unit.c_str(), (k+1 < results.size()) ? "," : "");
+    }
+
+    fprintf(output, "  ]\n}\n");
+}
+
+int main(int argc, char *argv[])
+{
+    enum OutputFormat {TABLE, CSV, JSON};
+
+    OutputFormat format = TABLE;
+    string outputFilePath;
+    string directory = ".";
+    int numberOfRuns = 3;
+
+    for(int k = 1 ; k<argc ; ++k)
+    {
+        string argument(argv[k]);
+
+        if(argument == "--csv")
+            format = CSV;
+        else if(argument == "--json")
+            format = JSON;
+        else if(argument == "--output" && k+1<argc)
+            outputFilePath = argv[++k];
+        else if(argument == "--runs" && k+1<argc)
+            numberOfRuns = max(1, atoi(argv[++k]));
+        else if(argument == "--directory" && k+1<argc)
+            directory = argv[++k];
+        else
+        {
+            cerr << "Usage : " << argv[0] << " [--csv | --json] [--output filePath] [--runs numberOfRuns] [--directory temporaryDirectory]" << endl;
+            return EXIT_FAILURE;
+        }
+    }
+
+    vector<BenchmarkResult> results;
+    bool correct = true;
+
+    //Latitude longitude maps of increasing resolution
+    const int imageSizes[3][2] = {{512, 256}, {2048, 1024}, {8192, 4096}};
+
+    for(int k = 0 ; k<3 ; ++k)
+    {
+        correct = benchmarkImages(imageSizes[k][0], imageSizes[k][1], numberOfRuns, directory, results) && correct;
+    }
+
+    //Grids of 512, 8192, 32768 and 524288 triangles
+    const int gridSizes[4] = {16, 64, 128, 512};
+
+    for(int k = 0 ; k<4 ; ++k)
+    {
+        correct = benchmarkMesh(gridSizes[k], numberOfRuns, directory, results) && correct;
+    }
+
+    FILE* output = stdout;
+
+    if(!outputFilePath.empty())
+    {
+        output = fopen(outputFilePath.c_str(), "w");
+
+        if(!output)
+        {
+            cerr << "Could not open the file : " << outputFilePath << endl;
+            return EXIT_FAILURE;
+        }
+    }
+
+    if(format == CSV)
+        printCSV(output, results);
+    else if(format == JSON)
+        printJSON(output, results);
+    else
+        printTable(output, results);
+
+    if(output != stdout)
+        fclose(output);
+
+    return correct ? EXIT_SUCCESS : EXIT_FAILURE;
+}
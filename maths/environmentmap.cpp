@@ -0,0 +1,1037 @@
+/*
+ *     Real3D
+ *
+ *     Author:  Antoine TOISOUL LE CANN
+ *
+ *     Copyright © 2016 Antoine TOISOUL LE CANN, Imperial College London
+ *              All rights reserved
+ *
+ *
+ * Real3D is free software: you can redistribute it and/or modify
+ *
+ * it under the terms of the GNU Lesser General Public License as published by
+ *
+ * the Free Software Foundation, either version 3 of the License, or
+ *
+ * (at your option) any later version.
+ *
+ * Real3D is distributed in the hope that it will be useful,
+ *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ *
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * \file environmentmap.cpp
+ * \brief Precomputation of the environment maps used for image based lighting.
+ * \author Antoine Toisoul Le Cann
+ * \date October, 16th, 2026
+ *
+ * Computes the diffuse convolution of a latitude longitude environment map with spherical harmonics.
+ */
+
+#include "maths/environmentmap.h"
+#include "other/parallel.h"
+
+#include <mutex>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define ENVIRONMENTMAP_USE_SSE2
+#endif
+
+using namespace std;
+using namespace cv;
+
+/*
+ * Normalisation constants of the real spherical harmonics of order 0, 1 and 2.
+ */
+#define SH_Y00 0.282095f
+#define SH_Y1 0.488603f
+#define SH_Y2 1.092548f
+#define SH_Y20 0.315392f
+#define SH_Y22 0.546274f
+
+/**
+ * Number of sums per color channel computed on each row : the radiance times 1, cos(phi), sin(phi), sin(phi)^2 and sin(phi)cos(phi).
+ */
+#define SH_ROW_SUMS 5
+
+/**
+ * Adds to rowSums the sums over the pixels of a row of the radiance times 1, cos(phi), sin(phi), sin(phi)^2 and sin(phi)cos(phi)
+ * for each color channel. The spherical harmonics are products of these functions of phi and of functions of theta :
+ * the functions of theta are applied once per row.
+ * @brief sumRow
+ * @param row
+ * @param width
+ * @param azimuthFactors
+ * @param rowSums
+ */
+static void sumRow(const float* row, int width, const vector<float> azimuthFactors[SH_ROW_SUMS], double rowSums[3][SH_ROW_SUMS])
+{
+    int j = 0;
+    float sums[3][SH_ROW_SUMS] = {{0.0f}};
+
+#ifdef ENVIRONMENTMAP_USE_SSE2
+    __m128 accumulators[3][SH_ROW_SUMS];
+
+    for(int c = 0 ; c<3 ; ++c)
+    {
+        for(int k = 0 ; k<SH_ROW_SUMS ; ++k)
+        {
+            accumulators[c][k] = _mm_setzero_ps();
+        }
+    }
+
+    for( ; j+4<=width ; j += 4)
+    {
+        //b0 g0 r0 b1 | g1 r1 b2 g2 | r2 b3 g3 r3 to b0 b1 b2 b3 | g0 g1 g2 g3 | r0 r1 r2 r3
+        __m128 p0 = _mm_loadu_ps(row+3*j);
+        __m128 p1 = _mm_loadu_ps(row+3*j+4);
+        __m128 p2 = _mm_loadu_ps(row+3*j+8);
+
+        __m128 channel[3];
+        channel[0] = _mm_shuffle_ps(p0, _mm_shuffle_ps(p1, p2, _MM_SHUFFLE(1,1,2,2)), _MM_SHUFFLE(2,0,3,0));
+        channel[1] = _mm_shuffle_ps(_mm_shuffle_ps(p0, p1, _MM_SHUFFLE(0,0,1,1)), _mm_shuffle_ps(p1, p2, _MM_SHUFFLE(2,2,3,3)), _MM_SHUFFLE(2,0,2,0));
+        channel[2] = _mm_shuffle_ps(_mm_shuffle_ps(p0, p1, _MM_SHUFFLE(1,1,2,2)), p2, _MM_SHUFFLE(3,0,2,0));
+
+        __m128 factors[SH_ROW_SUMS];
+        factors[0] = _mm_set1_ps(1.0f);
+        for(int k = 1 ; k<SH_ROW_SUMS ; ++k)
+        {
+            factors[k] = _mm_loadu_ps(&azimuthFactors[k][j]);
+        }
+
+        for(int c = 0 ; c<3 ; ++c)
+        {
+            for(int k = 0 ; k<SH_ROW_SUMS ; ++k)
+            {
+                accumulators[c][k] = _mm_add_ps(accumulators[c][k], _mm_mul_ps(channel[c], factors[k]));
+            }
+        }
+    }
+
+    for(int c = 0 ; c<3 ; ++c)
+    {
+        for(int k = 0 ; k<SH_ROW_SUMS ; ++k)
+        {
+            float lanes[4];
+            _mm_storeu_ps(lanes, accumulators[c][k]);
+            sums[c][k] = (lanes[0]+lanes[1])+(lanes[2]+lanes[3]);
+        }
+    }
+#endif
+
+    for( ; j<width ; ++j)
+    {
+        for(int c = 0 ; c<3 ; ++c)
+        {
+            sums[c][0] += row[3*j+c];
+
+            for(int k = 1 ; k<SH_ROW_SUMS ; ++k)
+            {
+                sums[c][k] += row[3*j+c]*azimuthFactors[k][j];
+            }
+        }
+    }
+
+    for(int c = 0 ; c<3 ; ++c)
+    {
+        for(int k = 0 ; k<SH_ROW_SUMS ; ++k)
+        {
+            rowSums[c][k] = sums[c][k];
+        }
+    }
+}
+
+/**
+ * Projects a latitude longitude environment map (CV_32FC3, BGR) on the 9 spherical harmonics of order 0 to 2.
+ * Each pixel is weighted by its solid angle. The rows are split between numberOfThreads threads
+ * (the number of cores of the machine if numberOfThreads <= 0).
+ * The pixel (i,j) of a width x height map is the direction of angles theta = PI*(i+0.5)/height and phi = 2PI*(j+0.5)/width
+ * in the convention of cartesianToSpherical in the shaders : (sin(theta)sin(phi), cos(theta), sin(theta)cos(phi)).
+ * @brief projectOnSphericalHarmonics
+ * @param environmentMap
+ * @param coefficients
+ * @param numberOfThreads
+ */
+void projectOnSphericalHarmonics(const Mat& environmentMap, vector<Vec3f>& coefficients, int numberOfThreads)
+{
+    coefficients.assign(9, Vec3f(0.0f, 0.0f, 0.0f));
+
+    if(environmentMap.empty() || environmentMap.type() != CV_32FC3)
+    {
+        cerr << "The environment map must be a CV_32FC3 image." << endl;
+        return;
+    }
+
+    const int width = environmentMap.cols;
+    const int height = environmentMap.rows;
+
+    //Functions of phi : 1 (implicit), cos(phi), sin(phi), sin(phi)^2, sin(phi)cos(phi)
+    vector<float> azimuthFactors[SH_ROW_SUMS];
+    for(int k = 1 ; k<SH_ROW_SUMS ; ++k)
+    {
+        azimuthFactors[k].resize(width);
+    }
+
+    for(int j = 0 ; j<width ; ++j)
+    {
+        double phi = 2.0*M_PI*(j+0.5)/width;
+        azimuthFactors[1][j] = (float) cos(phi);
+        azimuthFactors[2][j] = (float) sin(phi);
+        azimuthFactors[3][j] = (float) (sin(phi)*sin(phi));
+        azimuthFactors[4][j] = (float) (sin(phi)*cos(phi));
+    }
+
+    //Solid angle of a pixel without the sin(theta) factor
+    const double pixelSolidAngle = (M_PI/height)*(2.0*M_PI/width);
+
+    double total[9][3] = {{0.0}};
+    mutex totalMutex;
+
+    parallelFor(0, height, [&](int firstRow, int lastRow)
+    {
+        double partial[9][3] = {{0.0}};
+
+        for(int i = firstRow ; i<lastRow ; ++i)
+        {
+            double rowSums[3][SH_ROW_SUMS];
+            sumRow(environmentMap.ptr<float>(i), width, azimuthFactors, rowSums);
+
+            double theta = M_PI*(i+0.5)/height;
+            double sinTheta = sin(theta);
+            double cosTheta = cos(theta);
+            double weight = pixelSolidAngle*sinTheta;
+
+            for(int c = 0 ; c<3 ; ++c)
+            {
+                const double* S = rowSums[c];
+
+                partial[0][c] += weight*SH_Y00*S[0];
+                partial[1][c] += weight*SH_Y1*cosTheta*S[0];                         //y
+                partial[2][c] += weight*SH_Y1*sinTheta*S[1];                         //z
+                partial[3][c] += weight*SH_Y1*sinTheta*S[2];                         //x
+                partial[4][c] += weight*SH_Y2*sinTheta*cosTheta*S[2];                //xy
+                partial[5][c] += weight*SH_Y2*sinTheta*cosTheta*S[1];                //yz
+                partial[6][c] += weight*SH_Y2*sinTheta*sinTheta*S[4];                //xz
+                partial[7][c] += weight*SH_Y20*(3.0*cosTheta*cosTheta-1.0)*S[0];     //3y^2-1
+                partial[8][c] += weight*SH_Y22*sinTheta*sinTheta*(2.0*S[3]-S[0]);    //x^2-z^2
+            }
+        }
+
+        lock_guard<mutex> lock(totalMutex);
+
+        for(int k = 0 ; k<9 ; ++k)
+        {
+            for(int c = 0 ; c<3 ; ++c)
+            {
+                total[k][c] += partial[k][c];
+            }
+        }
+    }, numberOfThreads);
+
+    for(int k = 0 ; k<9 ; ++k)
+    {
+        coefficients[k] = Vec3f((float) total[k][0], (float) total[k][1], (float) total[k][2]);
+    }
+}
+
+/**
+ * Returns the diffuse convolution (irradiance divided by PI) of the environment map given by its 9 spherical harmonics
+ * coefficients as a width x height latitude longitude map (CV_32FC3, BGR).
+ * The order 2 spherical harmonics keep the low frequencies of the irradiance : the error is largest around small bright lights.
+ * @brief diffuseConvolutionFromSphericalHarmonics
+ * @param coefficients
+ * @param width
+ * @param height
+ * @return
+ */
+Mat diffuseConvolutionFromSphericalHarmonics(const vector<Vec3f>& coefficients, int width, int height)
+{
+    if(coefficients.size() != 9 || width <= 0 || height <= 0)
+    {
+        cerr << "The diffuse convolution requires 9 spherical harmonics coefficients and a positive size." << endl;
+        return Mat();
+    }
+
+    //Convolution with the clamped cosine divided by PI : 1 for order 0, 2/3 for order 1 and 1/4 for order 2
+    float convolution[9] = {1.0f, 2.0f/3.0f, 2.0f/3.0f, 2.0f/3.0f, 0.25f, 0.25f, 0.25f, 0.25f, 0.25f};
+
+    Mat diffuse(height, width, CV_32FC3);
+
+    parallelFor(0, height, [&](int firstRow, int lastRow)
+    {
+        for(int i = firstRow ; i<lastRow ; ++i)
+        {
+            float theta = (float) (M_PI*(i+0.5)/height);
+            float y = cos(theta);
+            float* row = diffuse.ptr<float>(i);
+
+            for(int j = 0 ; j<width ; ++j)
+            {
+                float phi = (float) (2.0*M_PI*(j+0.5)/width);
+                float x = sin(theta)*sin(phi);
+                float z = sin(theta)*cos(phi);
+
+                float basis[9] = {SH_Y00, SH_Y1*y, SH_Y1*z, SH_Y1*x, SH_Y2*x*y, SH_Y2*y*z, SH_Y2*x*z,
+                                  SH_Y20*(3.0f*y*y-1.0f), SH_Y22*(x*x-z*z)};
+
+                for(int c = 0 ; c<3 ; ++c)
+                {
+                    float value = 0.0f;
+
+                    for(int k = 0 ; k<9 ; ++k)
+                    {
+                        value += convolution[k]*coefficients[k][c]*basis[k];
+                    }
+
+                    //The truncation of the spherical harmonics can ring below 0
+                    row[3*j+c] = max(value, 0.0f);
+                }
+            }
+        }
+    });
+
+    return diffuse;
+}
+
+/**
+ * Returns the diffuse convolution (irradiance divided by PI) of a latitude longitude environment map (CV_32FC3, BGR)
+ * as a width x height latitude longitude map. The cost is linear in the number of pixels of both maps.
+ * @brief diffuseConvolution
+ * @param environmentMap
+ * @param width
+ * @param height
+ * @return
+ */
+Mat diffuseConvolution(const Mat& environmentMap, int width, int height)
+{
+    vector<Vec3f> coefficients;
+    projectOnSphericalHarmonics(environmentMap, coefficients);
+
+    return diffuseConvolutionFromSphericalHarmonics(coefficients, width, height);
+}
+
+/**
+ * Returns the radical inverse in base 2 of index : first dimension of the (0,2)-sequence.
+ * @brief radicalInverse
+ * @param index
+ * @return
+ */
+static double radicalInverse(unsigned int index)
+{
+    index = (index << 16) | (index >> 16);
+    index = ((index & 0x55555555u) << 1) | ((index & 0xAAAAAAAAu) >> 1);
+    index = ((index & 0x33333333u) << 2) | ((index & 0xCCCCCCCCu) >> 2);
+    index = ((index & 0x0F0F0F0Fu) << 4) | ((index & 0xF0F0F0F0u) >> 4);
+    index = ((index & 0x00FF00FFu) << 8) | ((index & 0xFF00FF00u) >> 8);
+
+    return index/4294967296.0;
+}
+
+/**
+ * Returns the second dimension of the Sobol sequence for index : second dimension of the (0,2)-sequence.
+ * @brief sobolSecondDimension
+ * @param index
+ * @return
+ */
+static double sobolSecondDimension(unsigned int index)
+{
+    unsigned int result = 0;
+
+    for(unsigned int v = 1u << 31 ; index ; index >>= 1, v ^= v >> 1)
+    {
+        if(index & 1u)
+        {
+            result ^= v;
+        }
+    }
+
+    return result/4294967296.0;
+}
+
+/**
+ * Light direction sampled from the Beckmann distribution around the reflection direction.
+ * @brief The SpecularSample struct
+ */
+struct SpecularSample
+{
+    float x; /*!< Coordinates of the light direction in the frame of the reflection direction (z axis). */
+    float y;
+    float z;
+    float weight; /*!< Cosine between the light direction and the normal. */
+    float solidAngle; /*!< Solid angle covered by the sample. */
+};
+
+/**
+ * Bilinear interpolation of a latitude longitude map in the direction of angles (theta, phi).
+ * The map is periodic along phi and clamped along theta.
+ * @brief sampleLatLong
+ * @param map
+ * @param theta
+ * @param phi
+ * @param color
+ */
+static void sampleLatLong(const Mat& map, float theta, float phi, float color[3])
+{
+    float x = phi*(float) (0.5/M_PI)*map.cols-0.5f;
+    float y = theta*(float) (1.0/M_PI)*map.rows-0.5f;
+
+    int x0 = (int) floor(x);
+    int y0 = (int) floor(y);
+    float fx = x-x0;
+    float fy = y-y0;
+
+    x0 = ((x0 % map.cols) + map.cols) % map.cols;
+    int x1 = (x0+1 == map.cols) ? 0 : x0+1;
+    int y1 = min(max(y0+1, 0), map.rows-1);
+    y0 = min(max(y0, 0), map.rows-1);
+
+    const float* row0 = map.ptr<float>(y0);
+    const float* row1 = map.ptr<float>(y1);
+
+    for(int c = 0 ; c<3 ; ++c)
+    {
+        float top = row0[3*x0+c] + fx*(row0[3*x1+c]-row0[3*x0+c]);
+        float bottom = row1[3*x0+c] + fx*(row1[3*x1+c]-row1[3*x0+c]);
+        color[c] = top + fy*(bottom-top);
+    }
+}
+
+/**
+ * Returns the Beckmann roughness of the level of a specular mip chain of numberOfLevels levels.
+ * The roughness increases linearly from 0 (mirror reflection) for the first level to 1 for the last level.
+ * @brief specularMipLevelRoughness
+ * @param level
+ * @param numberOfLevels
+ * @return
+ */
+float specularMipLevelRoughness(int level, int numberOfLevels)
+{
+    if(numberOfLevels <= 1)
+    {
+        return 0.0f;
+    }
+
+    return (float) level/(float) (numberOfLevels-1);
+}
+
+/**
+ * Computes the mip chain of the specular convolutions of a latitude longitude environment map (CV_32FC3, BGR)
+ * with numberOfSamples samples per pixel. See SpecularPrefilter.
+ * @brief prefilterSpecular
+ * @param environmentMap
+ * @param mipChain
+ * @param numberOfSamples
+ * @param numberOfLevels
+ * @param width
+ */
+void prefilterSpecular(const Mat& environmentMap, vector<Mat>& mipChain, int numberOfSamples, int numberOfLevels, int width)
+{
+    SpecularPrefilter prefilter(environmentMap, numberOfLevels, width);
+    prefilter.addSamples(numberOfSamples);
+    prefilter.getMipChain(mipChain);
+}
+
+/**
+ * Packs the levels of a mip chain of latitude longitude maps in a single image : the levels are stored one under the other
+ * and aligned on the left. The image can then be saved as a PFM or Radiance HDR file.
+ * @brief packMipChain
+ * @param mipChain
+ * @return
+ */
+Mat packMipChain(const vector<Mat>& mipChain)
+{
+    if(mipChain.empty() || mipChain[0].empty())
+    {
+        return Mat();
+    }
+
+    int height = 0;
+    for(unsigned int l = 0 ; l<mipChain.size() ; ++l)
+    {
+        height += mipChain[l].rows;
+    }
+
+    Mat packedMipChain = Mat::zeros(height, mipChain[0].cols, mipChain[0].type());
+
+    int offset = 0;
+    for(unsigned int l = 0 ; l<mipChain.size() ; ++l)
+    {
+        Mat level = packedMipChain(Rect(0, offset, mipChain[l].cols, mipChain[l].rows));
+        mipChain[l].copyTo(level);
+        offset += mipChain[l].rows;
+    }
+
+    return packedMipChain;
+}
+
+/**
+ * Unpacks an image created by packMipChain. The levels share the data of the packed image.
+ * A latitude longitude map (width = 2*height) is unpacked as a mip chain of one level.
+ * Returns false if the image is not a packed mip chain.
+ * @brief unpackMipChain
+ * @param packedMipChain
+ * @param mipChain
+ * @return
+ */
+bool unpackMipChain(const Mat& packedMipChain, vector<Mat>& mipChain)
+{
+    mipChain.clear();
+
+    const int width = packedMipChain.cols;
+    const int height = width/2;
+    int offset = 0;
+
+    for(int l = 0 ; offset < packedMipChain.rows ; ++l)
+    {
+        int levelWidth = width >> l;
+        int levelHeight = height >> l;
+
+        if(levelHeight == 0 || offset+levelHeight > packedMipChain.rows)
+        {
+            cerr << "The image is not a mip chain of latitude longitude maps." << endl;
+            mipChain.clear();
+            return false;
+        }
+
+        mipChain.push_back(packedMipChain(Rect(0, offset, levelWidth, levelHeight)));
+        offset += levelHeight;
+    }
+
+    return !mipChain.empty();
+}
+
+/**
+ * Direction of the point (sc, tc) in [-1,1]x[-1,1] of a face of a cubemap in the OpenGL convention
+ * (the inverse of the selection of the face and of its coordinates by the major axis of the direction).
+ * @brief cubemapDirection
+ * @param face
+ * @param sc
+ * @param tc
+ * @param direction
+ */
+static void cubemapDirection(int face, float sc, float tc, float direction[3])
+{
+    switch(face)
+    {
+        case 0: //+X
+            direction[0] = 1.0f; direction[1] = -tc; direction[2] = -sc;
+            break;
+        case 1: //-X
+            direction[0] = -1.0f; direction[1] = -tc; direction[2] = sc;
+            break;
+        case 2: //+Y
+            direction[0] = sc; direction[1] = 1.0f; direction[2] = tc;
+            break;
+        case 3: //-Y
+            direction[0] = sc; direction[1] = -1.0f; direction[2] = -tc;
+            break;
+        case 4: //+Z
+            direction[0] = sc; direction[1] = -tc; direction[2] = 1.0f;
+            break;
+        default: //-Z
+            direction[0] = -sc; direction[1] = -tc; direction[2] = -1.0f;
+            break;
+    }
+}
+
+/**
+ * Average of a latitude longitude map over a footprint of angular size angularSize centred on the direction (theta, phi).
+ * The footprint covers about one row of the map and angularSize/sin(theta) along phi : it is covered by bilinear samples
+ * one pixel apart along phi.
+ * @brief filterLatLong
+ * @param map
+ * @param theta
+ * @param phi
+ * @param angularSize
+ * @param color
+ */
+static void filterLatLong(const Mat& map, float theta, float phi, float angularSize, float color[3])
+{
+    float phiFootprint = min(angularSize/max(sin(theta), 1e-6f), (float) (2.0*M_PI));
+    int numberOfSamples = max((int) ceil(phiFootprint*map.cols*(float) (0.5/M_PI)), 1);
+
+    color[0] = color[1] = color[2] = 0.0f;
+
+    for(int s = 0 ; s<numberOfSamples ; ++s)
+    {
+        float sample[3];
+        sampleLatLong(map, theta, phi + phiFootprint*((s+0.5f)/numberOfSamples-0.5f), sample);
+
+        for(int c = 0 ; c<3 ; ++c)
+        {
+            color[c] += sample[c];
+        }
+    }
+
+    for(int c = 0 ; c<3 ; ++c)
+    {
+        color[c] /= numberOfSamples;
+    }
+}
+
+/**
+ * Returns the size of the faces of the cubemap of a latitude longitude map : a quarter of its width,
+ * so that the cubemap has about as many pixels around the equator as the map.
+ * @brief cubemapFaceSize
+ * @param environmentMap
+ * @return
+ */
+int cubemapFaceSize(const Mat& environmentMap)
+{
+    return max(environmentMap.cols/4, 1);
+}
+
+/**
+ * Resamples a latitude longitude environment map (CV_32FC3, BGR) as a cubemap of faceSize x faceSize faces.
+ * The faces are stored side by side in the OpenGL order (+X, -X, +Y, -Y, +Z, -Z) in a 6*faceSize x faceSize image :
+ * the row 0 of a face is its top (t = 1) and the face is sent to OpenGL like the other images, from the bottom row.
+ * Each pixel averages the area of the map it covers : the map is read from a mip pyramid whose rows match the size of the pixel
+ * and several samples are taken along phi where the map is compressed close to the poles.
+ * The faces are split between numberOfThreads threads (the number of cores of the machine if numberOfThreads <= 0).
+ * @brief latLongToCubemap
+ * @param environmentMap
+ * @param faceSize
+ * @param numberOfThreads
+ * @return
+ */
+Mat latLongToCubemap(const Mat& environmentMap, int faceSize, int numberOfThreads)
+{
+    if(environmentMap.empty() || environmentMap.type() != CV_32FC3 || faceSize < 1)
+    {
+        cerr << "The environment map must be a CV_32FC3 image and the faces of the cubemap at least one pixel wide." << endl;
+        return Mat();
+    }
+
+    //Mip pyramid of the environment map : the level l has rows 2^l times higher than the level 0
+    vector<Mat> pyramid(1, environmentMap);
+
+    while(pyramid.back().cols > 1 && pyramid.back().rows > 1)
+    {
+        const Mat& previous = pyramid.back();
+        Mat next;
+        resize(previous, next, Size(previous.cols/2, previous.rows/2), 0, 0, INTER_AREA);
+        pyramid.push_back(next);
+    }
+
+    const float maxLevel = (float) (pyramid.size()-1);
+    const float rowAngle = (float) (M_PI/environmentMap.rows);
+
+    Mat cubemap(faceSize, EM_CUBEMAP_FACES*faceSize, CV_32FC3);
+
+    parallelFor(0, EM_CUBEMAP_FACES, [&](int firstFace, int lastFace)
+    {
+        for(int f = firstFace ; f<lastFace ; ++f)
+        {
+            for(int i = 0 ; i<faceSize ; ++i)
+            {
+                float tc = 1.0f-2.0f*(i+0.5f)/faceSize;
+                float* row = cubemap.ptr<float>(i) + 3*f*faceSize;
+
+                for(int j = 0 ; j<faceSize ; ++j)
+                {
+                    float sc = 2.0f*(j+0.5f)/faceSize-1.0f;
+
+                    float direction[3];
+                    cubemapDirection(f, sc, tc, direction);
+
+                    float norm2 = 1.0f + sc*sc + tc*tc;
+                    float theta = acos(direction[1]/sqrt(norm2));
+                    float phi = atan2(direction[0], direction[2]);
+
+                    if(phi < 0.0f)
+                    {
+                        phi += (float) (2.0*M_PI);
+                    }
+
+                    //Angular size of the pixel : square root of its solid angle (2/faceSize)^2/(1+sc^2+tc^2)^(3/2)
+                    float angularSize = 2.0f/(faceSize*pow(norm2, 0.75f));
+
+                    //Level of the pyramid whose rows are as high as the pixel, interpolated between two levels
+                    float lod = min(max(log2(angularSize/rowAngle), 0.0f), maxLevel);
+                    int lod0 = (int) lod;
+                    int lod1 = min(lod0+1, (int) maxLevel);
+                    float t = lod-lod0;
+
+                    float color0[3], color1[3];
+                    filterLatLong(pyramid[lod0], theta, phi, angularSize, color0);
+
+                    if(t > 0.0f)
+                    {
+                        filterLatLong(pyramid[lod1], theta, phi, angularSize, color1);
+                    }
+                    else
+                    {
+                        color1[0] = color1[1] = color1[2] = 0.0f;
+                    }
+
+                    for(int c = 0 ; c<3 ; ++c)
+                    {
+                        row[3*j+c] = color0[c] + t*(color1[c]-color0[c]);
+                    }
+                }
+            }
+        }
+    }, numberOfThreads);
+
+    return cubemap;
+}
+
+/**
+ * Resamples each level of a mip chain of latitude longitude maps as a cubemap (see latLongToCubemap).
+ * The faces of the level l are cubemapFaceSize(mipChain[0]) divided by 2^l.
+ * @brief latLongToCubemap
+ * @param mipChain
+ * @param cubemapMipChain
+ * @param numberOfThreads
+ */
+void latLongToCubemap(const vector<Mat>& mipChain, vector<Mat>& cubemapMipChain, int numberOfThreads)
+{
+    cubemapMipChain.clear();
+
+    if(mipChain.empty())
+    {
+        return;
+    }
+
+    const int faceSize = cubemapFaceSize(mipChain[0]);
+
+    for(unsigned int l = 0 ; l<mipChain.size() ; ++l)
+    {
+        cubemapMipChain.push_back(latLongToCubemap(mipChain[l], max(faceSize >> l, 1), numberOfThreads));
+    }
+}
+
+/**
+ * Creates an empty prefilter.
+ * @brief SpecularPrefilter
+ */
+SpecularPrefilter::SpecularPrefilter(): m_sourcePyramid(), m_sums(), m_weights(), m_numberOfSamples(0), m_numberOfThreads(0)
+{
+
+}
+
+/**
+ * Creates a prefilter of the environment map (CV_32FC3, BGR) for a mip chain of numberOfLevels levels.
+ * The first level is width x width/2. The rows are split between numberOfThreads threads
+ * (the number of cores of the machine if numberOfThreads <= 0).
+ * @brief SpecularPrefilter
+ * @param environmentMap
+ * @param numberOfLevels
+ * @param width
+ * @param numberOfThreads
+ */
+SpecularPrefilter::SpecularPrefilter(const Mat& environmentMap, int numberOfLevels, int width, int numberOfThreads):
+    m_sourcePyramid(), m_sums(), m_weights(), m_numberOfSamples(0), m_numberOfThreads(numberOfThreads)
+{
+    if(environmentMap.empty() || environmentMap.type() != CV_32FC3 || width < 2 || numberOfLevels < 1)
+    {
+        cerr << "The environment map must be a CV_32FC3 image and the mip chain must have at least one level." << endl;
+        return;
+    }
+
+    //Every level must be at least one pixel high
+    while(((width/2) >> (numberOfLevels-1)) == 0)
+    {
+        numberOfLevels--;
+    }
+
+    //Mip pyramid of the environment map read by the samples
+    m_sourcePyramid.push_back(environmentMap);
+
+    while(m_sourcePyramid.back().cols > 1 && m_sourcePyramid.back().rows > 1)
+    {
+        const Mat& previous = m_sourcePyramid.back();
+        Mat next;
+        resize(previous, next, Size(previous.cols/2, previous.rows/2), 0, 0, INTER_AREA);
+        m_sourcePyramid.push_back(next);
+    }
+
+    //The first level is the mirror reflection
+    m_sums.resize(numberOfLevels);
+    m_weights.assign(numberOfLevels, 0.0);
+
+    resize(environmentMap, m_sums[0], Size(width, width/2), 0, 0, INTER_AREA);
+    m_weights[0] = 1.0;
+
+    for(int l = 1 ; l<numberOfLevels ; ++l)
+    {
+        m_sums[l] = Mat::zeros(((width/2) >> l), (width >> l), CV_32FC3);
+    }
+}
+
+/**
+ * Adds numberOfSamples samples per pixel to every level of the mip chain.
+ * @brief addSamples
+ * @param numberOfSamples
+ */
+void SpecularPrefilter::addSamples(int numberOfSamples)
+{
+    if(isEmpty() || numberOfSamples <= 0)
+    {
+        return;
+    }
+
+    const int firstSample = m_numberOfSamples;
+    m_numberOfSamples += numberOfSamples;
+
+    const Mat& source = m_sourcePyramid[0];
+    const float maxSourceLevel = (float) (m_sourcePyramid.size()-1);
+
+    //Solid angle of a pixel of the environment map without the sin(theta) factor
+    const float sourcePixelSolidAngle = (float) ((M_PI/source.rows)*(2.0*M_PI/source.cols));
+
+    for(unsigned int l = 1 ; l<m_sums.size() ; ++l)
+    {
+        double roughness = specularMipLevelRoughness(l, (int) m_sums.size());
+        double roughness2 = roughness*roughness;
+
+        //The light directions only depend on the level : they are computed in the frame of the reflection direction
+        vector<SpecularSample> samples;
+        samples.reserve(numberOfSamples);
+
+        for(int s = firstSample ; s<m_numberOfSamples ; ++s)
+        {
+            //Importance sampling of the Beckmann distribution of the half vector
+            double tanThetaH2 = -roughness2*log(1.0-radicalInverse(s));
+            double cosThetaH = 1.0/sqrt(1.0+tanThetaH2);
+            double sinThetaH = sqrt(max(1.0-cosThetaH*cosThetaH, 0.0));
+            double phiH = 2.0*M_PI*sobolSecondDimension(s);
+
+            //Light direction : reflection of the viewing direction (z axis) on the half vector
+            SpecularSample sample;
+            sample.z = (float) (2.0*cosThetaH*cosThetaH-1.0);
+
+            if(sample.z <= 0.0f)
+            {
+                continue;
+            }
+
+            sample.x = (float) (2.0*cosThetaH*sinThetaH*cos(phiH));
+            sample.y = (float) (2.0*cosThetaH*sinThetaH*sin(phiH));
+            sample.weight = sample.z;
+
+            //Probability density of the light direction : D(h)cos(theta_h)/(4 dot(v,h)) = D(h)/4 when the normal is the viewing direction
+            double D = exp(-tanThetaH2/roughness2)/(M_PI*roughness2*pow(cosThetaH, 4.0));
+            sample.solidAngle = (float) (4.0/(m_numberOfSamples*D));
+
+            samples.push_back(sample);
+            m_weights[l] += sample.weight;
+        }
+
+        Mat& sums = m_sums[l];
+
+        parallelFor(0, sums.rows, [&](int firstRow, int lastRow)
+        {
+            for(int i = firstRow ; i<lastRow ; ++i)
+            {
+                float theta = (float) (M_PI*(i+0.5)/sums.rows);
+                float* row = sums.ptr<float>(i);
+
+                for(int j = 0 ; j<sums.cols ; ++j)
+                {
+                    float phi = (float) (2.0*M_PI*(j+0.5)/sums.cols);
+
+                    //Reflection direction and its tangent frame
+                    float R[3] = {sin(theta)*sin(phi), cos(theta), sin(theta)*cos(phi)};
+                    float up[3] = {0.0f, 1.0f, 0.0f};
+
+                    if(fabs(R[1]) > 0.999f)
+                    {
+                        up[0] = 1.0f;
+                        up[1] = 0.0f;
+                    }
+
+                    float T[3] = {up[1]*R[2]-up[2]*R[1], up[2]*R[0]-up[0]*R[2], up[0]*R[1]-up[1]*R[0]};
+                    float norm = sqrt(T[0]*T[0] + T[1]*T[1] + T[2]*T[2]);
+                    T[0] /= norm;
+                    T[1] /= norm;
+                    T[2] /= norm;
+
+                    float B[3] = {R[1]*T[2]-R[2]*T[1], R[2]*T[0]-R[0]*T[2], R[0]*T[1]-R[1]*T[0]};
+
+                    for(unsigned int s = 0 ; s<samples.size() ; ++s)
+                    {
+                        const SpecularSample& sample = samples[s];
+                        float L[3];
+
+                        for(int k = 0 ; k<3 ; ++k)
+                        {
+                            L[k] = sample.x*T[k] + sample.y*B[k] + sample.z*R[k];
+                        }
+
+                        float sinThetaL = sqrt(L[0]*L[0] + L[2]*L[2]);
+                        float thetaL = acos(min(max(L[1], -1.0f), 1.0f));
+                        float phiL = atan2(L[0], L[2]);
+
+                        if(phiL < 0.0f)
+                        {
+                            phiL += (float) (2.0*M_PI);
+                        }
+
+                        //Filtered importance sampling : level of the pyramid where a pixel covers the solid angle of the sample
+                        float pixelSolidAngle = sourcePixelSolidAngle*max(sinThetaL, 1e-4f);
+                        float lod = 0.5f*log2(sample.solidAngle/pixelSolidAngle) + 1.0f;
+                        lod = min(max(lod, 0.0f), maxSourceLevel);
+
+                        int lod0 = (int) lod;
+                        int lod1 = min(lod0+1, (int) maxSourceLevel);
+                        float t = lod-lod0;
+
+                        float color0[3], color1[3];
+                        sampleLatLong(m_sourcePyramid[lod0], thetaL, phiL, color0);
+                        sampleLatLong(m_sourcePyramid[lod1], thetaL, phiL, color1);
+
+                        for(int c = 0 ; c<3 ; ++c)
+                        {
+                            row[3*j+c] += sample.weight*(color0[c] + t*(color1[c]-color0[c]));
+                        }
+                    }
+                }
+            }
+        }, m_numberOfThreads);
+    }
+}
+
+/**
+ * Returns the mip chain computed with the samples added so far.
+ * @brief getMipChain
+ * @param mipChain
+ */
+void SpecularPrefilter::getMipChain(vector<Mat>& mipChain) const
+{
+    mipChain.resize(m_sums.size());
+
+    for(unsigned int l = 0 ; l<m_sums.size() ; ++l)
+    {
+        if(m_weights[l] > 0.0)
+        {
+            m_sums[l].convertTo(mipChain[l], CV_32FC3, 1.0/m_weights[l]);
+        }
+        else
+        {
+            mipChain[l] = Mat::zeros(m_sums[l].rows, m_sums[l].cols, CV_32FC3);
+        }
+    }
+}
+
+/**
+ * Returns the number of samples per pixel added so far.
+ * @brief getNumberOfSamples
+ * @return
+ */
+int SpecularPrefilter::getNumberOfSamples() const
+{
+    return m_numberOfSamples;
+}
+
+/**
+ * Returns the number of levels of the mip chain.
+ * @brief getNumberOfLevels
+ * @return
+ */
+int SpecularPrefilter::getNumberOfLevels() const
+{
+    return (int) m_sums.size();
+}
+
+/**
+ * Returns true if the prefilter has no environment map.
+ * @brief isEmpty
+ * @return
+ */
+bool SpecularPrefilter::isEmpty() const
+{
+    return m_sums.empty();
+}
+
+/**
+ * Returns the integral of the Cook Torrance BRDF (Beckmann distribution, Cook Torrance geometric factor)
+ * times cos(theta_l) over the hemisphere, split in a scale and a bias of the Fresnel reflectance at normal incidence F0 :
+ * the integral is F0*scale + bias with the Schlick approximation of the Fresnel factor.
+ * The column j is dot(normal, viewingDirection) = (j+0.5)/size and the row i is the roughness (i+0.5)/size.
+ * The scale is stored in the red channel and the bias in the green channel (CV_32FC3, BGR). The rows are split between
+ * numberOfThreads threads (the number of cores of the machine if numberOfThreads <= 0).
+ * @brief brdfIntegrationLUT
+ * @param size
+ * @param numberOfSamples
+ * @param numberOfThreads
+ * @return
+ */
+Mat brdfIntegrationLUT(int size, int numberOfSamples, int numberOfThreads)
+{
+    if(size <= 0 || numberOfSamples <= 0)
+    {
+        cerr << "The BRDF integration table requires a positive size and number of samples." << endl;
+        return Mat();
+    }
+
+    Mat LUT = Mat::zeros(size, size, CV_32FC3);
+
+    parallelFor(0, size, [&](int firstRow, int lastRow)
+    {
+        vector<double> cosThetaH(numberOfSamples), sinThetaH(numberOfSamples), cosPhiH(numberOfSamples);
+
+        for(int i = firstRow ; i<lastRow ; ++i)
+        {
+            double roughness = (i+0.5)/size;
+
+            //The half vectors only depend on the roughness
+            for(int s = 0 ; s<numberOfSamples ; ++s)
+            {
+                //Importance sampling of the Beckmann distribution of the half vector
+                double tanThetaH2 = -roughness*roughness*log(1.0-radicalInverse(s));
+                cosThetaH[s] = 1.0/sqrt(1.0+tanThetaH2);
+                sinThetaH[s] = sqrt(max(1.0-cosThetaH[s]*cosThetaH[s], 0.0));
+                cosPhiH[s] = cos(2.0*M_PI*sobolSecondDimension(s));
+            }
+
+            float* row = LUT.ptr<float>(i);
+
+            for(int j = 0 ; j<size ; ++j)
+            {
+                //Viewing direction in the plane (x, z) with the normal along z
+                double NdotV = (j+0.5)/size;
+                double Vx = sqrt(1.0-NdotV*NdotV);
+
+                double scale = 0.0;
+                double bias = 0.0;
+
+                for(int s = 0 ; s<numberOfSamples ; ++s)
+                {
+                    double NdotH = cosThetaH[s];
+                    double VdotH = Vx*sinThetaH[s]*cosPhiH[s] + NdotV*NdotH;
+                    double NdotL = 2.0*VdotH*NdotH - NdotV;
+
+                    if(NdotL <= 0.0 || VdotH <= 0.0)
+                        continue;
+
+                    //Geometric factor of the shaders
+                    double G = min(1.0, min(2.0*NdotH*NdotV/VdotH, 2.0*NdotH*NdotL/VdotH));
+
+                    //BRDF*cos(theta_l)/pdf without the Fresnel factor (the distribution cancels with the pdf)
+                    double weight = G*VdotH/(NdotH*NdotV);
+                    double fresnel = pow(1.0-VdotH, 5.0);
+
+                    scale += (1.0-fresnel)*weight;
+                    bias += fresnel*weight;
+                }
+
+                row[3*j] = 0.0f;
+                row[3*j+1] = (float) (bias/numberOfSamples);
+                row[3*j+2] = (float) (scale/numberOfSamples);
+            }
+        }
+    }, numberOfThreads);
+
+    return LUT;
+}
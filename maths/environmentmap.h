@@ -0,0 +1,272 @@
+/*
+ *     Real3D
+ *
+ *     Author:  Antoine TOISOUL LE CANN
+ *
+ *     Copyright © 2016 Antoine TOISOUL LE CANN, Imperial College London
+ *              All rights reserved
+ *
+ *
+ * Real3D is free software: you can redistribute it and/or modify
+ *
+ * it under the terms of the GNU Lesser General Public License as published by
+ *
+ * the Free Software Foundation, either version 3 of the License, or
+ *
+ * (at your option) any later version.
+ *
+ * Real3D is distributed in the hope that it will be useful,
+ *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ *
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * \file environmentmap.h
+ * \brief Precomputation of the environment maps used for image based lighting.
+ * \author Antoine Toisoul Le Cann
+ * \date October, 16th, 2026
+ *
+ * Computes the diffuse convolution of a latitude longitude environment map with spherical harmonics
+ * and the mip chain of its specular convolutions with the Beckmann distribution (one roughness per mip level).
+ * Also integrates the Cook Torrance BRDF for the split sum approximation of the specular reflection
+ * and resamples the latitude longitude maps as cubemaps for the shaders.
+ */
+
+#ifndef ENVIRONMENTMAP_H
+#define ENVIRONMENTMAP_H
+
+#include "maths/mathfunctions.h"
+
+#include <iostream>
+#include <cmath>
+#include <vector>
+
+/*---- OpenCV ----*/
+#include <opencv2/core/core.hpp>
+#include "opencv2/imgproc/imgproc.hpp"
+
+#define EM_DIFFUSE_WIDTH 256 /*!< Default width of the diffuse convolution of an environment map. */
+#define EM_DIFFUSE_HEIGHT 128 /*!< Default height of the diffuse convolution of an environment map. */
+
+#define EM_SPECULAR_WIDTH 512 /*!< Default width of the first level of the specular mip chain of an environment map. */
+#define EM_SPECULAR_LEVELS 7 /*!< Default number of levels of the specular mip chain (512x256 to 8x4). */
+#define EM_SPECULAR_SAMPLES 256 /*!< Default number of samples per pixel of the specular mip chain. */
+#define EM_SPECULAR_PREVIEW_SAMPLES 16 /*!< Number of samples per pixel of the first preview of the specular mip chain. */
+
+#define EM_BRDF_LUT_SIZE 64 /*!< Default width and height of the BRDF integration table. */
+#define EM_BRDF_LUT_SAMPLES 1024 /*!< Default number of samples per pixel of the BRDF integration table. */
+
+#define EM_CUBEMAP_FACES 6 /*!< Number of faces of a cubemap. */
+
+/**
+ * Projects a latitude longitude environment map (CV_32FC3, BGR) on the 9 spherical harmonics of order 0 to 2.
+ * Each pixel is weighted by its solid angle. The rows are split between numberOfThreads threads
+ * (the number of cores of the machine if numberOfThreads <= 0).
+ * The pixel (i,j) of a width x height map is the direction of angles theta = PI*(i+0.5)/height and phi = 2PI*(j+0.5)/width
+ * in the convention of cartesianToSpherical in the shaders : (sin(theta)sin(phi), cos(theta), sin(theta)cos(phi)).
+ * @brief projectOnSphericalHarmonics
+ * @param environmentMap
+ * @param coefficients
+ * @param numberOfThreads
+ */
+void projectOnSphericalHarmonics(const cv::Mat& environmentMap, std::vector<cv::Vec3f>& coefficients, int numberOfThreads = 0);
+
+/**
+ * Returns the diffuse convolution (irradiance divided by PI) of the environment map given by its 9 spherical harmonics
+ * coefficients as a width x height latitude longitude map (CV_32FC3, BGR).
+ * The order 2 spherical harmonics keep the low frequencies of the irradiance : the error is largest around small bright lights.
+ * @brief diffuseConvolutionFromSphericalHarmonics
+ * @param coefficients
+ * @param width
+ * @param height
+ * @return
+ */
+cv::Mat diffuseConvolutionFromSphericalHarmonics(const std::vector<cv::Vec3f>& coefficients, int width, int height);
+
+/**
+ * Returns the diffuse convolution (irradiance divided by PI) of a latitude longitude environment map (CV_32FC3, BGR)
+ * as a width x height latitude longitude map. The cost is linear in the number of pixels of both maps.
+ * @brief diffuseConvolution
+ * @param environmentMap
+ * @param width
+ * @param height
+ * @return
+ */
+cv::Mat diffuseConvolution(const cv::Mat& environmentMap, int width = EM_DIFFUSE_WIDTH, int height = EM_DIFFUSE_HEIGHT);
+
+/**
+ * Returns the Beckmann roughness of the level of a specular mip chain of numberOfLevels levels.
+ * The roughness increases linearly from 0 (mirror reflection) for the first level to 1 for the last level.
+ * @brief specularMipLevelRoughness
+ * @param level
+ * @param numberOfLevels
+ * @return
+ */
+float specularMipLevelRoughness(int level, int numberOfLevels);
+
+/**
+ * Computes the mip chain of the specular convolutions of a latitude longitude environment map (CV_32FC3, BGR)
+ * with numberOfSamples samples per pixel. See SpecularPrefilter.
+ * @brief prefilterSpecular
+ * @param environmentMap
+ * @param mipChain
+ * @param numberOfSamples
+ * @param numberOfLevels
+ * @param width
+ */
+void prefilterSpecular(const cv::Mat& environmentMap, std::vector<cv::Mat>& mipChain, int numberOfSamples = EM_SPECULAR_SAMPLES,
+                       int numberOfLevels = EM_SPECULAR_LEVELS, int width = EM_SPECULAR_WIDTH);
+
+/**
+ * Packs the levels of a mip chain of latitude longitude maps in a single image : the levels are stored one under the other
+ * and aligned on the left. The image can then be saved as a PFM or Radiance HDR file.
+ * @brief packMipChain
+ * @param mipChain
+ * @return
+ */
+cv::Mat packMipChain(const std::vector<cv::Mat>& mipChain);
+
+/**
+ * Unpacks an image created by packMipChain. The levels share the data of the packed image.
+ * A latitude longitude map (width = 2*height) is unpacked as a mip chain of one level.
+ * Returns false if the image is not a packed mip chain.
+ * @brief unpackMipChain
+ * @param packedMipChain
+ * @param mipChain
+ * @return
+ */
+bool unpackMipChain(const cv::Mat& packedMipChain, std::vector<cv::Mat>& mipChain);
+
+/**
+ * Returns the size of the faces of the cubemap of a latitude longitude map : a quarter of its width,
+ * so that the cubemap has about as many pixels around the equator as the map.
+ * @brief cubemapFaceSize
+ * @param environmentMap
+ * @return
+ */
+int cubemapFaceSize(const cv::Mat& environmentMap);
+
+/**
+ * Resamples a latitude longitude environment map (CV_32FC3, BGR) as a cubemap of faceSize x faceSize faces.
+ * The faces are stored side by side in the OpenGL order (+X, -X, +Y, -Y, +Z, -Z) in a 6*faceSize x faceSize image :
+ * the row 0 of a face is its top (t = 1) and the face is sent to OpenGL like the other images, from the bottom row.
+ * Each pixel averages the area of the map it covers : the map is read from a mip pyramid whose rows match the size of the pixel
+ * and several samples are taken along phi where the map is compressed close to the poles.
+ * The faces are split between numberOfThreads threads (the number of cores of the machine if numberOfThreads <= 0).
+ * @brief latLongToCubemap
+ * @param environmentMap
+ * @param faceSize
+ * @param numberOfThreads
+ * @return
+ */
+cv::Mat latLongToCubemap(const cv::Mat& environmentMap, int faceSize, int numberOfThreads = 0);
+
+/**
+ * Resamples each level of a mip chain of latitude longitude maps as a cubemap (see latLongToCubemap).
+ * The faces of the level l are cubemapFaceSize(mipChain[0]) divided by 2^l.
+ * @brief latLongToCubemap
+ * @param mipChain
+ * @param cubemapMipChain
+ * @param numberOfThreads
+ */
+void latLongToCubemap(const std::vector<cv::Mat>& mipChain, std::vector<cv::Mat>& cubemapMipChain, int numberOfThreads = 0);
+
+/**
+ * Returns the integral of the Cook Torrance BRDF (Beckmann distribution, Cook Torrance geometric factor)
+ * times cos(theta_l) over the hemisphere, split in a scale and a bias of the Fresnel reflectance at normal incidence F0 :
+ * the integral is F0*scale + bias with the Schlick approximation of the Fresnel factor.
+ * The column j is dot(normal, viewingDirection) = (j+0.5)/size and the row i is the roughness (i+0.5)/size.
+ * The scale is stored in the red channel and the bias in the green channel (CV_32FC3, BGR). The rows are split between
+ * numberOfThreads threads (the number of cores of the machine if numberOfThreads <= 0).
+ * @brief brdfIntegrationLUT
+ * @param size
+ * @param numberOfSamples
+ * @param numberOfThreads
+ * @return
+ */
+cv::Mat brdfIntegrationLUT(int size = EM_BRDF_LUT_SIZE, int numberOfSamples = EM_BRDF_LUT_SAMPLES, int numberOfThreads = 0);
+
+/**
+ * Prefilters a latitude longitude environment map with the Beckmann distribution of the Cook Torrance BRDF
+ * for the roughness of each level of a mip chain (see specularMipLevelRoughness). Assumes that the viewing direction
+ * and the normal are the reflection direction, as in the shaders.
+ * The half vectors are importance sampled with a (0,2)-sequence : the samples can be added progressively in batches
+ * and any power of two number of samples is well stratified.
+ * Each sample reads a level of a mip pyramid of the environment map that matches its solid angle (filtered importance sampling) :
+ * a few samples per pixel already give a smooth preview.
+ * @brief The SpecularPrefilter class
+ */
+class SpecularPrefilter
+{
+    public:
+
+        /**
+         * Creates an empty prefilter.
+         * @brief SpecularPrefilter
+         */
+        SpecularPrefilter();
+
+        /**
+         * Creates a prefilter of the environment map (CV_32FC3, BGR) for a mip chain of numberOfLevels levels.
+         * The first level is width x width/2. The rows are split between numberOfThreads threads
+         * (the number of cores of the machine if numberOfThreads <= 0).
+         * @brief SpecularPrefilter
+         * @param environmentMap
+         * @param numberOfLevels
+         * @param width
+         * @param numberOfThreads
+         */
+        SpecularPrefilter(const cv::Mat& environmentMap, int numberOfLevels = EM_SPECULAR_LEVELS, int width = EM_SPECULAR_WIDTH, int numberOfThreads = 0);
+
+        /**
+         * Adds numberOfSamples samples per pixel to every level of the mip chain.
+         * @brief addSamples
+         * @param numberOfSamples
+         */
+        void addSamples(int numberOfSamples);
+
+        /**
+         * Returns the mip chain computed with the samples added so far.
+         * @brief getMipChain
+         * @param mipChain
+         */
+        void getMipChain(std::vector<cv::Mat>& mipChain) const;
+
+        /**
+         * Returns the number of samples per pixel added so far.
+         * @brief getNumberOfSamples
+         * @return
+         */
+        int getNumberOfSamples() const;
+
+        /**
+         * Returns the number of levels of the mip chain.
+         * @brief getNumberOfLevels
+         * @return
+         */
+        int getNumberOfLevels() const;
+
+        /**
+         * Returns true if the prefilter has no environment map.
+         * @brief isEmpty
+         * @return
+         */
+        bool isEmpty() const;
+
+    private:
+        std::vector<cv::Mat> m_sourcePyramid; /*!< Mip pyramid of the environment map read by the samples. */
+        std::vector<cv::Mat> m_sums; /*!< Weighted sums of the samples of each level (the first level is the mirror reflection). */
+        std::vector<double> m_weights; /*!< Sum of the weights of the samples of each level. */
+        int m_numberOfSamples; /*!< Number of samples per pixel added so far. */
+        int m_numberOfThreads; /*!< Number of threads used to add the samples. */
+};
+
+#endif // ENVIRONMENTMAP_H
@@ -40,6 +40,18 @@
 
 
 #include "maths/imageprocessing.h"
+#include "other/parallel.h"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define IMAGEPROCESSING_USE_AVX2
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define IMAGEPROCESSING_USE_SSE2
+#endif
+
+#define GAMMA_MIN_PIXELS_PER_THREAD (1 << 16) /*!< Images smaller than this number of pixels per thread are corrected with less threads. */
+#define CONVERSION_MIN_PIXELS_PER_THREAD (1 << 16) /*!< Images smaller than this number of pixels per thread are converted with less threads. */
 
 using namespace std;
 using namespace cv;
@@ -67,32 +79,251 @@ void gammaCorrection(const Mat &rgbImage, Mat &rgbImageWithGamma, double gamma)
     merge(channelWithGamma,3,rgbImageWithGamma);
 }
 
+/*
+ * Fast approximation of x^exponent for x in [0 ; 1] computed as 2^(exponent*log2(x)).
+ * log2 uses the series of atanh on the mantissa in [sqrt(2)/2 ; sqrt(2)), 2^f uses a polynomial of degree 6 on [-0.5 ; 0.5].
+ * The relative error is below 5e-6 : far below the quantization of 8 or 16 bits images.
+ * Values below 2^-126 (and NaN) give 0.
+ */
+#define LOG2_C1 2.8853900817779268f /*!< 2/ln(2) */
+#define LOG2_C3 0.9617966939259756f /*!< 2/(3ln(2)) */
+#define LOG2_C5 0.5770780163555854f /*!< 2/(5ln(2)) */
+#define LOG2_C7 0.4121985831111324f /*!< 2/(7ln(2)) */
+#define EXP2_C1 0.6931471805599453f /*!< ln(2) */
+#define EXP2_C2 0.2402265069591007f /*!< ln(2)^2/2 */
+#define EXP2_C3 0.0555041086648216f /*!< ln(2)^3/6 */
+#define EXP2_C4 0.0096181291076285f /*!< ln(2)^4/24 */
+#define EXP2_C5 0.0013333558146428f /*!< ln(2)^5/120 */
+#define EXP2_C6 0.0001540353039338f /*!< ln(2)^6/720 */
+
+/**
+ * Returns x^exponent clamped to [0 ; 1] for x clamped to [0 ; 1].
+ * @brief fastClampedPow
+ * @param x
+ * @param exponent
+ * @return
+ */
+static inline float fastClampedPow(float x, float exponent)
+{
+    //Also sends NaN to 0
+    x = (x > 0.0f) ? min(x, 1.0f) : 0.0f;
+
+    if(x < 1.17549435e-38f)
+        return 0.0f;
+
+    int bits;
+    memcpy(&bits, &x, sizeof(float));
+
+    int power = ((bits >> 23) & 0xff) - 127;
+    bits = (bits & 0x007fffff) | 0x3f800000;
+
+    float mantissa;
+    memcpy(&mantissa, &bits, sizeof(float));
+
+    if(mantissa > 1.41421356f)
+    {
+        mantissa *= 0.5f;
+        power += 1;
+    }
+
+    float t = (mantissa-1.0f)/(mantissa+1.0f);
+    float t2 = t*t;
+    float logarithm = (float) power + t*(LOG2_C1 + t2*(LOG2_C3 + t2*(LOG2_C5 + t2*LOG2_C7)));
+
+    //x^exponent is clamped to 1 when exponent*log2(x) > 0
+    float y = min(max(exponent*logarithm, -126.0f), 0.0f);
+    float n = floor(y+0.5f);
+    float f = y-n;
+
+    float result = 1.0f + f*(EXP2_C1 + f*(EXP2_C2 + f*(EXP2_C3 + f*(EXP2_C4 + f*(EXP2_C5 + f*EXP2_C6)))));
+    bits = ((int) n + 127) << 23;
+
+    float scale;
+    memcpy(&scale, &bits, sizeof(float));
+
+    return min(result*scale, 1.0f);
+}
+
+#ifdef IMAGEPROCESSING_USE_AVX2
 /**
- * Apply a gamma correction to a RGB image stored in an array of floats.
+ * Returns x^exponent clamped to [0 ; 1] for x clamped to [0 ; 1] on 8 floats.
+ * @brief fastClampedPow
+ * @param x
+ * @param exponent
+ * @return
+ */
+static inline __m256 fastClampedPow(__m256 x, __m256 exponent)
+{
+    const __m256 one = _mm256_set1_ps(1.0f);
+
+    //max returns the second operand for NaN
+    x = _mm256_min_ps(_mm256_max_ps(x, _mm256_setzero_ps()), one);
+    __m256 valid = _mm256_cmp_ps(x, _mm256_set1_ps(1.17549435e-38f), _CMP_GE_OQ);
+
+    __m256i bits = _mm256_castps_si256(x);
+    __m256i power = _mm256_sub_epi32(_mm256_srli_epi32(bits, 23), _mm256_set1_epi32(127));
+    __m256 mantissa = _mm256_castsi256_ps(_mm256_or_si256(_mm256_and_si256(bits, _mm256_set1_epi32(0x007fffff)), _mm256_castps_si256(one)));
+
+    __m256 large = _mm256_cmp_ps(mantissa, _mm256_set1_ps(1.41421356f), _CMP_GT_OQ);
+    mantissa = _mm256_blendv_ps(mantissa, _mm256_mul_ps(mantissa, _mm256_set1_ps(0.5f)), large);
+    power = _mm256_sub_epi32(power, _mm256_castps_si256(large));
+
+    __m256 t = _mm256_div_ps(_mm256_sub_ps(mantissa, one), _mm256_add_ps(mantissa, one));
+    __m256 t2 = _mm256_mul_ps(t, t);
+    __m256 polynomial = _mm256_add_ps(_mm256_set1_ps(LOG2_C5), _mm256_mul_ps(t2, _mm256_set1_ps(LOG2_C7)));
+    polynomial = _mm256_add_ps(_mm256_set1_ps(LOG2_C3), _mm256_mul_ps(t2, polynomial));
+    polynomial = _mm256_add_ps(_mm256_set1_ps(LOG2_C1), _mm256_mul_ps(t2, polynomial));
+    __m256 logarithm = _mm256_add_ps(_mm256_cvtepi32_ps(power), _mm256_mul_ps(t, polynomial));
+
+    __m256 y = _mm256_min_ps(_mm256_max_ps(_mm256_mul_ps(exponent, logarithm), _mm256_set1_ps(-126.0f)), _mm256_setzero_ps());
+    __m256i n = _mm256_cvtps_epi32(y);
+    __m256 f = _mm256_sub_ps(y, _mm256_cvtepi32_ps(n));
+
+    __m256 result = _mm256_add_ps(_mm256_set1_ps(EXP2_C5), _mm256_mul_ps(f, _mm256_set1_ps(EXP2_C6)));
+    result = _mm256_add_ps(_mm256_set1_ps(EXP2_C4), _mm256_mul_ps(f, result));
+    result = _mm256_add_ps(_mm256_set1_ps(EXP2_C3), _mm256_mul_ps(f, result));
+    result = _mm256_add_ps(_mm256_set1_ps(EXP2_C2), _mm256_mul_ps(f, result));
+    result = _mm256_add_ps(_mm256_set1_ps(EXP2_C1), _mm256_mul_ps(f, result));
+    result = _mm256_add_ps(one, _mm256_mul_ps(f, result));
+
+    __m256 scale = _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_add_epi32(n, _mm256_set1_epi32(127)), 23));
+
+    return _mm256_and_ps(_mm256_min_ps(_mm256_mul_ps(result, scale), one), valid);
+}
+#endif
+
+#ifdef IMAGEPROCESSING_USE_SSE2
+/**
+ * Returns x^exponent clamped to [0 ; 1] for x clamped to [0 ; 1] on 4 floats.
+ * @brief fastClampedPow
+ * @param x
+ * @param exponent
+ * @return
+ */
+static inline __m128 fastClampedPow(__m128 x, __m128 exponent)
+{
+    const __m128 one = _mm_set1_ps(1.0f);
+
+    //max returns the second operand for NaN
+    x = _mm_min_ps(_mm_max_ps(x, _mm_setzero_ps()), one);
+    __m128 valid = _mm_cmpge_ps(x, _mm_set1_ps(1.17549435e-38f));
+
+    __m128i bits = _mm_castps_si128(x);
+    __m128i power = _mm_sub_epi32(_mm_srli_epi32(bits, 23), _mm_set1_epi32(127));
+    __m128 mantissa = _mm_castsi128_ps(_mm_or_si128(_mm_and_si128(bits, _mm_set1_epi32(0x007fffff)), _mm_castps_si128(one)));
+
+    __m128 large = _mm_cmpgt_ps(mantissa, _mm_set1_ps(1.41421356f));
+    mantissa = _mm_or_ps(_mm_andnot_ps(large, mantissa), _mm_and_ps(large, _mm_mul_ps(mantissa, _mm_set1_ps(0.5f))));
+    power = _mm_sub_epi32(power, _mm_castps_si128(large));
+
+    __m128 t = _mm_div_ps(_mm_sub_ps(mantissa, one), _mm_add_ps(mantissa, one));
+    __m128 t2 = _mm_mul_ps(t, t);
+    __m128 polynomial = _mm_add_ps(_mm_set1_ps(LOG2_C5), _mm_mul_ps(t2, _mm_set1_ps(LOG2_C7)));
+    polynomial = _mm_add_ps(_mm_set1_ps(LOG2_C3), _mm_mul_ps(t2, polynomial));
+    polynomial = _mm_add_ps(_mm_set1_ps(LOG2_C1), _mm_mul_ps(t2, polynomial));
+    __m128 logarithm = _mm_add_ps(_mm_cvtepi32_ps(power), _mm_mul_ps(t, polynomial));
+
+    __m128 y = _mm_min_ps(_mm_max_ps(_mm_mul_ps(exponent, logarithm), _mm_set1_ps(-126.0f)), _mm_setzero_ps());
+    __m128i n = _mm_cvtps_epi32(y);
+    __m128 f = _mm_sub_ps(y, _mm_cvtepi32_ps(n));
+
+    __m128 result = _mm_add_ps(_mm_set1_ps(EXP2_C5), _mm_mul_ps(f, _mm_set1_ps(EXP2_C6)));
+    result = _mm_add_ps(_mm_set1_ps(EXP2_C4), _mm_mul_ps(f, result));
+    result = _mm_add_ps(_mm_set1_ps(EXP2_C3), _mm_mul_ps(f, result));
+    result = _mm_add_ps(_mm_set1_ps(EXP2_C2), _mm_mul_ps(f, result));
+    result = _mm_add_ps(_mm_set1_ps(EXP2_C1), _mm_mul_ps(f, result));
+    result = _mm_add_ps(one, _mm_mul_ps(f, result));
+
+    __m128 scale = _mm_castsi128_ps(_mm_slli_epi32(_mm_add_epi32(n, _mm_set1_epi32(127)), 23));
+
+    return _mm_and_ps(_mm_min_ps(_mm_mul_ps(result, scale), one), valid);
+}
+#endif
+
+/**
+ * Applies the gamma correction to size consecutive floats starting at the beginning of a pixel.
+ * With 4 components, the fourth component (alpha) is not modified.
+ * @brief gammaCorrectionValues
+ * @param values
+ * @param size
+ * @param numberOfComponents
+ * @param exponent
+ */
+static void gammaCorrectionValues(float* values, size_t size, unsigned int numberOfComponents, float exponent)
+{
+    size_t k = 0;
+
+#if defined(IMAGEPROCESSING_USE_AVX2)
+    const __m256 exponent8 = _mm256_set1_ps(exponent);
+
+    for( ; k+8<=size ; k += 8)
+    {
+        __m256 original = _mm256_loadu_ps(values+k);
+        __m256 result = fastClampedPow(original, exponent8);
+
+        //Keep the alpha channels (lanes 3 and 7)
+        if(numberOfComponents == 4)
+            result = _mm256_blend_ps(result, original, 0x88);
+
+        _mm256_storeu_ps(values+k, result);
+    }
+#elif defined(IMAGEPROCESSING_USE_SSE2)
+    const __m128 exponent4 = _mm_set1_ps(exponent);
+    const __m128 alphaMask = _mm_castsi128_ps(_mm_set_epi32(numberOfComponents == 4 ? -1 : 0, 0, 0, 0));
+
+    for( ; k+4<=size ; k += 4)
+    {
+        __m128 original = _mm_loadu_ps(values+k);
+        __m128 result = fastClampedPow(original, exponent4);
+
+        //Keep the alpha channel (lane 3)
+        result = _mm_or_ps(_mm_andnot_ps(alphaMask, result), _mm_and_ps(alphaMask, original));
+
+        _mm_storeu_ps(values+k, result);
+    }
+#endif
+
+    for( ; k<size ; ++k)
+    {
+        if(numberOfComponents != 4 || k%4 != 3)
+            values[k] = fastClampedPow(values[k], exponent);
+    }
+}
+
+/**
+ * Apply a gamma correction to an image stored in an array of floats. The result is clamped between 0 and 1.
+ * Images with 1 (grayscale), 3 (RGB) or 4 (RGBA) components are supported : the alpha channel is not modified.
+ * The power is approximated with a relative error below 5e-6. The rows are split between the cores of the machine.
  * @param INPUT : image is the image to which the gamma correction is applied. It is an array of floats.
  * @param INPUT : width is the width of the image.
  * @param INPUT : height is the height of the image.
- * @param INPUT : numberOfComponents is the number of components of the image (3 for a RGB image).
+ * @param INPUT : numberOfComponents is the number of components of the image (1, 3 or 4).
  * @param INPUT : gamma is a float corresponding to the value of the gamma correction.
  */
 void gammaCorrection(float* image, unsigned int& width, unsigned int& height, unsigned int& numberOfComponents,const float& gamma)
 {
-    float pixelR = 0.0f, pixelG = 0.0f, pixelB = 0.0f;
-
-    for(unsigned int i = 0 ; i< height; i++)
+    if(numberOfComponents != 1 && numberOfComponents != 3 && numberOfComponents != 4)
     {
-        for(unsigned int j = 0 ; j< width; j++)
-        {
-            pixelR = image[(i*width+j)*numberOfComponents];
-            pixelG = image[(i*width+j)*numberOfComponents+1];
-            pixelB = image[(i*width+j)*numberOfComponents+2];
+        cerr << "The gamma correction requires 1, 3 or 4 components per pixel." << endl;
+        return;
+    }
 
-            image[(i*width+j)*numberOfComponents] = clamp(pow(pixelR, 1.0/gamma), 0.0, 1.0);
-            image[(i*width+j)*numberOfComponents+1] = clamp(pow(pixelG, 1.0/gamma), 0.0 , 1.0);
-            image[(i*width+j)*numberOfComponents+2] = clamp(pow(pixelB, 1.0/gamma), 0.0, 1.0);
-        }
+    if(!(gamma > 0.0f))
+    {
+        cerr << "The gamma must be positive." << endl;
+        return;
     }
 
+    const size_t rowSize = (size_t) width*numberOfComponents;
+    const float exponent = 1.0f/gamma;
+
+    //Small images are not worth waking many threads
+    int numberOfThreads = (int) max((size_t) 1, min((size_t) numberOfCores(), (size_t) width*height/GAMMA_MIN_PIXELS_PER_THREAD));
+
+    parallelFor(0, (int) height, [&](int firstRow, int lastRow)
+    {
+        gammaCorrectionValues(image + firstRow*rowSize, (lastRow-firstRow)*rowSize, numberOfComponents, exponent);
+    }, numberOfThreads);
 }
 
 /**
@@ -103,6 +334,13 @@ void gammaCorrection(float* image, unsigned int& width, unsigned int& height, un
  */
 void removeGammaCorrection(const Mat &rgbImage, Mat &rgbImageWithoutGamma, double gamma)
 {
+    //8 bits images only have 256 values : a single pass through a table
+    if(rgbImage.depth() == CV_8U)
+    {
+        convert8UTo32F(rgbImage, rgbImageWithoutGamma, 1.0, gamma);
+        return;
+    }
+
     Mat channel[3], channel32F[3], channelWithoutGamma[3];
 
     split(rgbImage, channel);
@@ -119,27 +357,78 @@ void removeGammaCorrection(const Mat &rgbImage, Mat &rgbImageWithoutGamma, doubl
 }
 
 /**
- * Flips imageSource vertically.
+ * Converts an 8 bits image to a 32 bits floating point image with the same number of channels.
+ * Each value v becomes (scale*v)^gamma. The 256 possible results are computed once in a table
+ * and the image is converted in a single pass split between the cores of the machine.
+ * For instance scale = 1/255 and gamma = 1 gives values between 0 and 1.
+ * @brief convert8UTo32F
+ * @param image8U
+ * @param image32F
+ * @param scale
+ * @param gamma
+ */
+void convert8UTo32F(const Mat& image8U, Mat& image32F, double scale, double gamma)
+{
+    float table[256];
+
+    for(int v = 0 ; v<256 ; ++v)
+    {
+        table[v] = (gamma == 1.0) ? (float) (scale*v) : (float) pow(scale*v, gamma);
+    }
+
+    //Keeps the source alive if image32F is the same matrix as image8U
+    Mat source = image8U;
+    image32F.create(source.rows, source.cols, CV_MAKETYPE(CV_32F, source.channels()));
+
+    const size_t rowSize = (size_t) source.cols*source.channels();
+    int numberOfThreads = (int) max((size_t) 1, min((size_t) numberOfCores(), source.total()/CONVERSION_MIN_PIXELS_PER_THREAD));
+
+    parallelFor(0, source.rows, [&](int firstRow, int lastRow)
+    {
+        for(int i = firstRow ; i<lastRow ; ++i)
+        {
+            const unsigned char* row8U = source.ptr<unsigned char>(i);
+            float* row32F = image32F.ptr<float>(i);
+
+            for(size_t k = 0 ; k<rowSize ; ++k)
+            {
+                row32F[k] = table[row8U[k]];
+            }
+        }
+    }, numberOfThreads);
+}
+
+/**
+ * Flips imageSource vertically. The rows are copied with memcpy, result can be imageSource (flip in place).
  * @brief inverseYAxis
  * @param imageSource
  * @param result
  */
 void inverseYAxis(const Mat& imageSource, Mat& result)
 {
-    result.convertTo(result, CV_32FC3);
-
-    int width = imageSource.cols;
-    int height = imageSource.rows;
+    const int height = imageSource.rows;
+    const size_t rowSize = imageSource.cols*imageSource.elemSize();
 
-    for(int i = 0 ; i<height ; i++)
+    //In place : the rows are swapped two by two
+    if(result.data == imageSource.data && result.rows == height && result.type() == imageSource.type())
     {
-        for(int j = 0 ; j<width ; j++)
+        vector<unsigned char> buffer(rowSize);
+
+        for(int i = 0 ; i<height/2 ; i++)
         {
-            result.at<Vec3f>(height-1-i,j).val[0] = imageSource.at<Vec3f>(i,j).val[0];
-            result.at<Vec3f>(height-1-i,j).val[1] = imageSource.at<Vec3f>(i,j).val[1];
-            result.at<Vec3f>(height-1-i,j).val[2] = imageSource.at<Vec3f>(i,j).val[2];
+            memcpy(&buffer[0], result.ptr(i), rowSize);
+            memcpy(result.ptr(i), result.ptr(height-1-i), rowSize);
+            memcpy(result.ptr(height-1-i), &buffer[0], rowSize);
         }
+
+        return;
     }
 
+    result.create(height, imageSource.cols, imageSource.type());
+
+    for(int i = 0 ; i<height ; i++)
+    {
+        memcpy(result.ptr(height-1-i), imageSource.ptr(i), rowSize);
+    }
 }
 
@@ -45,6 +45,7 @@
 
 #include "maths/mathfunctions.h"
 #include "other/PFMReadWrite.h"
+#include "other/HDRReadWrite.h"
 
 #include <iostream>
 #include <cmath>
@@ -68,11 +69,13 @@
 void gammaCorrection(const cv::Mat &rgbImage, cv::Mat &rgbImageWithGamma, double gamma);
 
 /**
- * Apply a gamma correction to a RGB image stored in an array of floats.
+ * Apply a gamma correction to an image stored in an array of floats. The result is clamped between 0 and 1.
+ * Images with 1 (grayscale), 3 (RGB) or 4 (RGBA) components are supported : the alpha channel is not modified.
+ * The power is approximated with a relative error below 5e-6. The rows are split between the cores of the machine.
  * @param INPUT : image is the image to which the gamma correction is applied. It is an array of floats.
  * @param INPUT : width is the width of the image.
  * @param INPUT : height is the height of the image.
- * @param INPUT : numberOfComponents is the number of components of the image (3 for a RGB image).
+ * @param INPUT : numberOfComponents is the number of components of the image (1, 3 or 4).
  * @param INPUT : gamma is a float corresponding to the value of the gamma correction.
  */
 void gammaCorrection(float* image, unsigned int& width, unsigned int& height, unsigned int& numberOfComponents,const float& gamma);
@@ -86,7 +89,20 @@ void gammaCorrection(float* image, unsigned int& width, unsigned int& height, un
 void removeGammaCorrection(const cv::Mat &rgbImage, cv::Mat &rgbImageWithoutGamma, double gamma);
 
 /**
- * Flips imageSource vertically.
+ * Converts an 8 bits image to a 32 bits floating point image with the same number of channels.
+ * Each value v becomes (scale*v)^gamma. The 256 possible results are computed once in a table
+ * and the image is converted in a single pass split between the cores of the machine.
+ * For instance scale = 1/255 and gamma = 1 gives values between 0 and 1.
+ * @brief convert8UTo32F
+ * @param image8U
+ * @param image32F
+ * @param scale
+ * @param gamma
+ */
+void convert8UTo32F(const cv::Mat& image8U, cv::Mat& image32F, double scale, double gamma);
+
+/**
+ * Flips imageSource vertically. The rows are copied with memcpy, result can be imageSource (flip in place).
  * @brief inverseYAxis
  * @param imageSource
  * @param result
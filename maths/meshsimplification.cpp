@@ -0,0 +1,518 @@
+/*
+ *     Real3D
+ *
+ *     Author:  Antoine TOISOUL LE CANN
+ *
+ *     Copyright © 2016 Antoine TOISOUL LE CANN, Imperial College London
+ *              All rights reserved
+ *
+ *
+ * Real3D is free software: you can redistribute it and/or modify
+ *
+ * it under the terms of the GNU Lesser General Public License as published by
+ *
+ * the Free Software Foundation, either version 3 of the License, or
+ *
+ * (at your option) any later version.
+ *
+ * Real3D is distributed in the hope that it will be useful,
+ *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ *
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * \file meshsimplification.cpp
+ * \brief Simplification of triangle meshes.
+ * \author Antoine Toisoul Le Cann
+ * \date October, 16th, 2026
+ *
+ * Simplifies triangle meshes by collapsing edges in the order of the quadric error metric (Garland and Heckbert).
+ * Each collapse moves a vertex onto one of its neighbours, so the texture coordinates and the normals of the remaining vertices
+ * are the ones of the original mesh. The borders and the texture seams only collapse along themselves.
+ */
+
+#include "maths/meshsimplification.h"
+
+#include <algorithm>
+#include <climits>
+#include <cstring>
+
+using namespace std;
+
+#define NO_VERTEX UINT_MAX /*!< Index of a missing vertex. */
+
+/**
+ * Kind of a vertex, which gives the edges it can be collapsed along.
+ */
+enum VertexKind
+{
+    VERTEX_MANIFOLD, /*!< Inside the mesh with a single set of attributes : can be collapsed along any edge. */
+    VERTEX_BORDER, /*!< On a border of the mesh : can only be collapsed along the border. */
+    VERTEX_SEAM, /*!< On a seam between two sets of attributes : can only be collapsed along the seam, with the other side of the seam. */
+    VERTEX_LOCKED /*!< Corner of a border or of a seam, or not manifold : not collapsed. */
+};
+
+/**
+ * Quadric error of a set of planes : the sum of the squared distances of a point x to the planes is x^T A x + 2 b^T x + c.
+ * @brief The Quadric struct
+ */
+struct Quadric
+{
+    double a00, a11, a22, a01, a02, a12; /*!< Symmetric matrix A. */
+    double b0, b1, b2; /*!< Vector b. */
+    double c; /*!< Constant c. */
+};
+
+/**
+ * Candidate collapse of the vertex from onto the vertex to.
+ * @brief The Collapse struct
+ */
+struct Collapse
+{
+    double error; /*!< Quadric error of the position of from at the position of to. */
+    unsigned int from; /*!< Vertex removed. */
+    unsigned int to; /*!< Vertex kept. */
+};
+
+/**
+ * Adds the plane n.x + d = 0 (n of length 1) with a weight to a quadric.
+ * @brief addPlane
+ * @param quadric
+ * @param normal
+ * @param d
+ * @param weight
+ */
+static void addPlane(Quadric& quadric, const QVector3D& normal, double d, double weight)
+{
+    const double a = normal.x(), b = normal.y(), c = normal.z();
+
+    quadric.a00 += weight*a*a;
+    quadric.a11 += weight*b*b;
+    quadric.a22 += weight*c*c;
+    quadric.a01 += weight*a*b;
+    quadric.a02 += weight*a*c;
+    quadric.a12 += weight*b*c;
+    quadric.b0 += weight*a*d;
+    quadric.b1 += weight*b*d;
+    quadric.b2 += weight*c*d;
+    quadric.c += weight*d*d;
+}
+
+/**
+ * Adds the quadric q to the quadric sum.
+ * @brief addQuadric
+ * @param sum
+ * @param q
+ */
+static void addQuadric(Quadric& sum, const Quadric& q)
+{
+    sum.a00 += q.a00; sum.a11 += q.a11; sum.a22 += q.a22;
+    sum.a01 += q.a01; sum.a02 += q.a02; sum.a12 += q.a12;
+    sum.b0 += q.b0; sum.b1 += q.b1; sum.b2 += q.b2;
+    sum.c += q.c;
+}
+
+/**
+ * Returns the error of a quadric at a point (never negative).
+ * @brief quadricError
+ * @param quadric
+ * @param point
+ * @return
+ */
+static double quadricError(const Quadric& quadric, const QVector3D& point)
+{
+    const double x = point.x(), y = point.y(), z = point.z();
+
+    const double error = quadric.a00*x*x + quadric.a11*y*y + quadric.a22*z*z
+                       + 2.0*(quadric.a01*x*y + quadric.a02*x*z + quadric.a12*y*z)
+                       + 2.0*(quadric.b0*x + quadric.b1*y + quadric.b2*z) + quadric.c;
+
+    return max(error, 0.0);
+}
+
+/**
+ * Finds the open edges of a list of triangles : directed edges a -> b without an edge b -> a.
+ * The vertices of the triangles are replaced by vertexMap (the welded positions or the vertices themselves).
+ * The edges from each vertex are listed once so that the edge b -> a is searched among the few edges from b.
+ * For each vertex, counts its open edges from and to it (up to 255) and stores the last ones.
+ * @brief findOpenEdges
+ * @param triangles
+ * @param vertexMap
+ * @param openNext
+ * @param openPrevious
+ * @param openOut
+ * @param openIn
+ */
+static void findOpenEdges(const vector<unsigned int>& triangles, const vector<unsigned int>& vertexMap,
+                          vector<unsigned int>& openNext, vector<unsigned int>& openPrevious, vector<unsigned char>& openOut, vector<unsigned char>& openIn)
+{
+    const size_t numberOfVertices = vertexMap.size();
+    openNext.assign(numberOfVertices, NO_VERTEX);
+    openPrevious.assign(numberOfVertices, NO_VERTEX);
+    openOut.assign(numberOfVertices, 0);
+    openIn.assign(numberOfVertices, 0);
+
+    //Ends of the edges from each vertex
+    vector<unsigned int> firstEdge(numberOfVertices+1, 0);
+    vector<unsigned int> edgeEnds(triangles.size());
+
+    for(size_t k = 0 ; k<triangles.size() ; k++)
+        firstEdge[vertexMap[triangles[k]]+1]++;
+
+    for(size_t v = 0 ; v<numberOfVertices ; v++)
+        firstEdge[v+1] += firstEdge[v];
+
+    vector<unsigned int> position(firstEdge.begin(), firstEdge.end()-1);
+
+    for(size_t k = 0 ; k<triangles.size() ; k++)
+    {
+        const size_t next = (k%3 == 2) ? k-2 : k+1;
+        edgeEnds[position[vertexMap[triangles[k]]]++] = vertexMap[triangles[next]];
+    }
+
+    for(size_t a = 0 ; a<numberOfVertices ; a++)
+    {
+        for(unsigned int i = firstEdge[a] ; i<firstEdge[a+1] ; i++)
+        {
+            const unsigned int b = edgeEnds[i];
+            const unsigned int* begin = &edgeEnds[0] + firstEdge[b];
+            const unsigned int* end = &edgeEnds[0] + firstEdge[b+1];
+
+            if(find(begin, end, (unsigned int) a) != end)
+                continue;
+
+            openNext[a] = b;
+            openPrevious[b] = (unsigned int) a;
+            openOut[a] = (unsigned char) min(openOut[a]+1, 255);
+            openIn[b] = (unsigned char) min(openIn[b]+1, 255);
+        }
+    }
+}
+
+/**
+ * Returns true if moving the position from onto the position to flips one of the triangles around from
+ * (the normal of the triangle is reversed). The triangles of each position are listed from firstTriangle.
+ * @brief flipsTriangle
+ * @param positions
+ * @param triangles
+ * @param positionIndex
+ * @param firstTriangle
+ * @param positionTriangles
+ * @param from
+ * @param to
+ * @return
+ */
+static bool flipsTriangle(const QVector3D* positions, const vector<unsigned int>& triangles, const vector<unsigned int>& positionIndex,
+                          const vector<unsigned int>& firstTriangle, const vector<unsigned int>& positionTriangles, unsigned int from, unsigned int to)
+{
+    for(unsigned int i = firstTriangle[from] ; i<firstTriangle[from+1] ; i++)
+    {
+        const unsigned int* triangle = &triangles[3*positionTriangles[i]];
+        unsigned int corners[3] = {positionIndex[triangle[0]], positionIndex[triangle[1]], positionIndex[triangle[2]]};
+
+        //The triangles of the collapsed edge disappear
+        if(corners[0] == to || corners[1] == to || corners[2] == to)
+            continue;
+
+        const QVector3D before = QVector3D::crossProduct(positions[corners[1]]-positions[corners[0]], positions[corners[2]]-positions[corners[0]]);
+
+        for(int c = 0 ; c<3 ; c++)
+        {
+            corners[c] = (corners[c] == from) ? to : corners[c];
+        }
+
+        const QVector3D after = QVector3D::crossProduct(positions[corners[1]]-positions[corners[0]], positions[corners[2]]-positions[corners[0]]);
+
+        if(QVector3D::dotProduct(before, after) <= 0.0f)
+            return true;
+    }
+
+    return false;
+}
+
+/**
+ * Simplifies a triangle mesh until it has at most targetNumberOfTriangles triangles or no edge can be collapsed.
+ * Vertices with the same position are welded to find the borders and the seams of the texture coordinates (vertices with
+ * two sets of attributes). Vertices where more than two sets of attributes meet, or where the mesh is not manifold, are not moved.
+ * Each pass sorts the edges by quadric error and collapses the cheapest ones that do not share a vertex and do not flip a triangle.
+ * Returns the indices of the triangles of the simplified mesh (each consecutive triplet is a triangle), which use the input vertices.
+ * @brief simplifyMesh
+ * @param positions
+ * @param numberOfVertices
+ * @param indices
+ * @param numberOfIndices
+ * @param targetNumberOfTriangles
+ * @return
+ */
+vector<unsigned int> simplifyMesh(const QVector3D* positions, int numberOfVertices, const unsigned int* indices, int numberOfIndices, int targetNumberOfTriangles)
+{
+    vector<unsigned int> triangles(indices, indices + (numberOfIndices - numberOfIndices%3));
+    const size_t n = (size_t) numberOfVertices;
+
+    if(triangles.size()/3 <= (size_t) max(targetNumberOfTriangles, 0))
+        return triangles;
+
+    //Vertices with the same position are welded : positionIndex is the first vertex at the same position
+    vector<unsigned int> order(n);
+    vector<unsigned int> positionIndex(n);
+
+    for(size_t v = 0 ; v<n ; v++)
+        order[v] = (unsigned int) v;
+
+    sort(order.begin(), order.end(), [&](unsigned int a, unsigned int b)
+    {
+        const QVector3D& p = positions[a];
+        const QVector3D& q = positions[b];
+
+        if(p.x() != q.x()) return p.x() < q.x();
+        if(p.y() != q.y()) return p.y() < q.y();
+        if(p.z() != q.z()) return p.z() < q.z();
+
+        return a < b;
+    });
+
+    for(size_t k = 0 ; k<n ; k++)
+    {
+        positionIndex[order[k]] = (k > 0 && positions[order[k]] == positions[order[k-1]]) ? positionIndex[order[k-1]] : order[k];
+    }
+
+    vector<unsigned int> identity(n);
+
+    for(size_t v = 0 ; v<n ; v++)
+        identity[v] = (unsigned int) v;
+
+    //Quadrics of the planes of the triangles weighted by their area, and of the planes perpendicular to the borders and the seams
+    vector<Quadric> quadrics(n);
+    memset(&quadrics[0], 0, n*sizeof(Quadric));
+
+    vector<unsigned int> openNext, openPrevious, positionOpenNext, positionOpenPrevious;
+    vector<unsigned char> openOut, openIn, positionOpenOut, positionOpenIn;
+    findOpenEdges(triangles, identity, openNext, openPrevious, openOut, openIn);
+
+    for(size_t t = 0 ; t<triangles.size()/3 ; t++)
+    {
+        const unsigned int corners[3] = {positionIndex[triangles[3*t]], positionIndex[triangles[3*t+1]], positionIndex[triangles[3*t+2]]};
+        const QVector3D normal = QVector3D::crossProduct(positions[corners[1]]-positions[corners[0]], positions[corners[2]]-positions[corners[0]]);
+        const double area = 0.5*normal.length();
+
+        if(area <= 0.0)
+            continue;
+
+        const QVector3D unitNormal = normal.normalized();
+        Quadric quadric;
+        memset(&quadric, 0, sizeof(quadric));
+        addPlane(quadric, unitNormal, -QVector3D::dotProduct(unitNormal, positions[corners[0]]), area);
+
+        for(int c = 0 ; c<3 ; c++)
+        {
+            addQuadric(quadrics[corners[c]], quadric);
+
+            //Open edge in the vertices (border or seam) : plane through the edge perpendicular to the triangle
+            const unsigned int a = triangles[3*t+c];
+            const unsigned int b = triangles[3*t+(c+1)%3];
+
+            if(openNext[a] == b)
+            {
+                const QVector3D edge = positions[b]-positions[a];
+                const QVector3D edgeNormal = QVector3D::crossProduct(edge, unitNormal).normalized();
+                Quadric edgeQuadric;
+                memset(&edgeQuadric, 0, sizeof(edgeQuadric));
+                addPlane(edgeQuadric, edgeNormal, -QVector3D::dotProduct(edgeNormal, positions[a]), SIMPLIFICATION_BORDER_WEIGHT*edge.lengthSquared());
+                addQuadric(quadrics[positionIndex[a]], edgeQuadric);
+                addQuadric(quadrics[positionIndex[b]], edgeQuadric);
+            }
+        }
+    }
+
+    vector<unsigned char> kinds(n);
+    vector<unsigned int> wedgeCount(n);
+    vector<unsigned int> nextWedge(n);
+    vector<unsigned int> firstTriangle(n+1);
+    vector<unsigned int> positionTriangles;
+    vector<Collapse> collapses;
+    vector<unsigned char> locked(n);
+    vector<unsigned int> collapseMap(n);
+
+    for(int pass = 0 ; pass<SIMPLIFICATION_MAXIMUM_PASSES && triangles.size()/3 > (size_t) targetNumberOfTriangles ; pass++)
+    {
+        const size_t numberOfTriangles = triangles.size()/3;
+
+        //Vertices used by the triangles at each position, in a circular list
+        fill(wedgeCount.begin(), wedgeCount.end(), 0);
+        fill(nextWedge.begin(), nextWedge.end(), NO_VERTEX);
+
+        for(size_t k = 0 ; k<triangles.size() ; k++)
+        {
+            const unsigned int v = triangles[k];
+            const unsigned int p = positionIndex[v];
+
+            if(nextWedge[v] != NO_VERTEX)
+                continue;
+
+            //The first vertex found at p is stored in collapseMap[p] during the construction
+            if(wedgeCount[p] == 0)
+            {
+                nextWedge[v] = v;
+                collapseMap[p] = v;
+            }
+            else
+            {
+                nextWedge[v] = nextWedge[collapseMap[p]];
+                nextWedge[collapseMap[p]] = v;
+            }
+
+            wedgeCount[p]++;
+        }
+
+        //Kinds of the vertices
+        findOpenEdges(triangles, identity, openNext, openPrevious, openOut, openIn);
+        findOpenEdges(triangles, positionIndex, positionOpenNext, positionOpenPrevious, positionOpenOut, positionOpenIn);
+
+        for(size_t v = 0 ; v<n ; v++)
+        {
+            const unsigned int p = positionIndex[v];
+
+            if(nextWedge[v] == NO_VERTEX)
+            {
+                kinds[v] = VERTEX_LOCKED;
+            }
+            else if(wedgeCount[p] == 1)
+            {
+                const bool border = (positionOpenOut[p] == 1 && positionOpenIn[p] == 1);
+                kinds[v] = (positionOpenOut[p] == 0 && positionOpenIn[p] == 0) ? VERTEX_MANIFOLD : (border ? VERTEX_BORDER : VERTEX_LOCKED);
+            }
+            else
+            {
+                const unsigned int w = nextWedge[v];
+                const bool seam = (wedgeCount[p] == 2 && positionOpenOut[p] == 0 && positionOpenIn[p] == 0
+                                   && openOut[v] == 1 && openIn[v] == 1 && openOut[w] == 1 && openIn[w] == 1);
+                kinds[v] = seam ? VERTEX_SEAM : VERTEX_LOCKED;
+            }
+        }
+
+        //Candidate collapses along the edges of the triangles (the reverse of an edge is the edge of another triangle unless it is open)
+        collapses.clear();
+
+        for(size_t k = 0 ; k<triangles.size() ; k++)
+        {
+            const unsigned int a = triangles[k];
+            const unsigned int b = triangles[(k%3 == 2) ? k-2 : k+1];
+            const unsigned int edge[2][2] = {{a, b}, {b, a}};
+            const int numberOfDirections = (openPrevious[b] == a) ? 2 : 1;
+
+            for(int d = 0 ; d<numberOfDirections ; d++)
+            {
+                const unsigned int from = edge[d][0];
+                const unsigned int to = edge[d][1];
+                const unsigned int p = positionIndex[from];
+                const unsigned int q = positionIndex[to];
+
+                bool allowed = (p != q) && (kinds[from] == VERTEX_MANIFOLD);
+                allowed = allowed || (kinds[from] == VERTEX_BORDER && p != q && (positionOpenNext[p] == q || positionOpenPrevious[p] == q));
+                allowed = allowed || (kinds[from] == VERTEX_SEAM && (openNext[from] == to || openPrevious[from] == to));
+
+                if(allowed)
+                {
+                    Collapse collapse = {quadricError(quadrics[p], positions[q]), from, to};
+                    collapses.push_back(collapse);
+                }
+            }
+        }
+
+        sort(collapses.begin(), collapses.end(), [](const Collapse& a, const Collapse& b) { return a.error < b.error; });
+
+        //Triangles of each position
+        fill(firstTriangle.begin(), firstTriangle.end(), 0);
+
+        for(size_t k = 0 ; k<triangles.size() ; k++)
+            firstTriangle[positionIndex[triangles[k]]+1]++;
+
+        for(size_t p = 0 ; p<n ; p++)
+            firstTriangle[p+1] += firstTriangle[p];
+
+        positionTriangles.resize(triangles.size());
+        vector<unsigned int> position(firstTriangle.begin(), firstTriangle.end()-1);
+
+        for(size_t k = 0 ; k<triangles.size() ; k++)
+            positionTriangles[position[positionIndex[triangles[k]]]++] = (unsigned int) (k/3);
+
+        //Collapses of the cheapest edges, each position is moved or kept once per pass
+        fill(locked.begin(), locked.end(), 0);
+
+        for(size_t v = 0 ; v<n ; v++)
+            collapseMap[v] = (unsigned int) v;
+
+        const size_t trianglesToRemove = numberOfTriangles - (size_t) targetNumberOfTriangles;
+        size_t trianglesRemoved = 0;
+        size_t numberOfCollapses = 0;
+
+        for(size_t c = 0 ; c<collapses.size() && trianglesRemoved < trianglesToRemove ; c++)
+        {
+            const unsigned int from = collapses[c].from;
+            const unsigned int to = collapses[c].to;
+            const unsigned int p = positionIndex[from];
+            const unsigned int q = positionIndex[to];
+
+            if(locked[p] || locked[q] || flipsTriangle(positions, triangles, positionIndex, firstTriangle, positionTriangles, p, q))
+                continue;
+
+            if(kinds[from] == VERTEX_SEAM)
+            {
+                //The other side of the seam collapses onto the vertex of the other side at q
+                const unsigned int otherFrom = nextWedge[from];
+                unsigned int otherTo = NO_VERTEX;
+
+                for(unsigned int w = nextWedge[to], i = 0 ; i<wedgeCount[q] ; w = nextWedge[w], i++)
+                {
+                    if(w != to && (openNext[otherFrom] == w || openPrevious[otherFrom] == w))
+                        otherTo = w;
+                }
+
+                if(otherTo == NO_VERTEX)
+                    continue;
+
+                collapseMap[otherFrom] = otherTo;
+            }
+
+            collapseMap[from] = to;
+            addQuadric(quadrics[q], quadrics[p]);
+            locked[p] = 1;
+            locked[q] = 1;
+
+            trianglesRemoved += (kinds[from] == VERTEX_BORDER) ? 1 : 2;
+            numberOfCollapses++;
+        }
+
+        if(numberOfCollapses == 0)
+            break;
+
+        //Triangles that are not degenerate after the collapses
+        size_t numberOfIndicesKept = 0;
+
+        for(size_t t = 0 ; t<numberOfTriangles ; t++)
+        {
+            const unsigned int a = collapseMap[triangles[3*t]];
+            const unsigned int b = collapseMap[triangles[3*t+1]];
+            const unsigned int c = collapseMap[triangles[3*t+2]];
+
+            if(positionIndex[a] != positionIndex[b] && positionIndex[b] != positionIndex[c] && positionIndex[a] != positionIndex[c])
+            {
+                triangles[numberOfIndicesKept++] = a;
+                triangles[numberOfIndicesKept++] = b;
+                triangles[numberOfIndicesKept++] = c;
+            }
+        }
+
+        triangles.resize(numberOfIndicesKept);
+    }
+
+    return triangles;
+}
@@ -0,0 +1,70 @@
+/*
+ *     Real3D
+ *
+ *     Author:  Antoine TOISOUL LE CANN
+ *
+ *     Copyright © 2016 Antoine TOISOUL LE CANN, Imperial College London
+ *              All rights reserved
+ *
+ *
+ * Real3D is free software: you can redistribute it and/or modify
+ *
+ * it under the terms of the GNU Lesser General Public License as published by
+ *
+ * the Free Software Foundation, either version 3 of the License, or
+ *
+ * (at your option) any later version.
+ *
+ * Real3D is distributed in the hope that it will be useful,
+ *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ *
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * \file meshsimplification.h
+ * \brief Simplification of triangle meshes.
+ * \author Antoine Toisoul Le Cann
+ * \date October, 16th, 2026
+ *
+ * Simplifies triangle meshes by collapsing edges in the order of the quadric error metric (Garland and Heckbert).
+ * Each collapse moves a vertex onto one of its neighbours, so the texture coordinates and the normals of the remaining vertices
+ * are the ones of the original mesh. The borders and the texture seams only collapse along themselves.
+ */
+
+#ifndef MESHSIMPLIFICATION_H
+#define MESHSIMPLIFICATION_H
+
+#include <QVector3D>
+
+#include <iostream>
+#include <cmath>
+#include <vector>
+
+#define SIMPLIFICATION_BORDER_WEIGHT 10.0 /*!< Weight of the quadrics that keep the borders and the seams in place, relative to the quadrics of the triangles. */
+#define SIMPLIFICATION_MAXIMUM_PASSES 100 /*!< Maximum number of passes of edge collapses. */
+
+/**
+ * Simplifies a triangle mesh until it has at most targetNumberOfTriangles triangles or no edge can be collapsed.
+ * Vertices with the same position are welded to find the borders and the seams of the texture coordinates (vertices with
+ * two sets of attributes). Vertices where more than two sets of attributes meet, or where the mesh is not manifold, are not moved.
+ * Each pass sorts the edges by quadric error and collapses the cheapest ones that do not share a vertex and do not flip a triangle.
+ * Returns the indices of the triangles of the simplified mesh (each consecutive triplet is a triangle), which use the input vertices.
+ * @brief simplifyMesh
+ * @param positions
+ * @param numberOfVertices
+ * @param indices
+ * @param numberOfIndices
+ * @param targetNumberOfTriangles
+ * @return
+ */
+std::vector<unsigned int> simplifyMesh(const QVector3D* positions, int numberOfVertices, const unsigned int* indices, int numberOfIndices, int targetNumberOfTriangles);
+
+#endif // MESHSIMPLIFICATION_H
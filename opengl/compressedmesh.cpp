@@ -0,0 +1,341 @@
+/*
+ *     Real3D
+ *
+ *     Author:  Antoine TOISOUL LE CANN
+ *
+ *     Copyright © 2016 Antoine TOISOUL LE CANN, Imperial College London
+ *              All rights reserved
+ *
+ *
+ * Real3D is free software: you can redistribute it and/or modify
+ *
+ * it under the terms of the GNU Lesser General Public License as published by
+ *
+ * the Free Software Foundation, either version 3 of the License, or
+ *
+ * (at your option) any later version.
+ *
+ * Real3D is distributed in the hope that it will be useful,
+ *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ *
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * \file compressedmesh.cpp
+ * \brief Implementation of a CompressedMesh.
+ * \author Antoine Toisoul Le Cann
+ * \date October, 16th, 2026
+ *
+ * Compact copy of a mesh decoded by the vertex shaders : 20 bytes per vertex instead of 48, and 16 bits indices when there are
+ * at most 65536 vertices. The positions and texture coordinates are quantized on 16 bits relative to their bounding box and the
+ * normals and tangents are encoded on 2x16 bits with the octahedral mapping.
+ */
+
+#include "opengl/compressedmesh.h"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace std;
+
+/**
+ * Quantizes a value of [offset ; offset+extent] to an integer from 0 to 65535.
+ * @brief quantizeUnsigned
+ * @param value
+ * @param offset
+ * @param extent
+ * @return
+ */
+static inline uint16_t quantizeUnsigned(float value, float offset, float extent)
+{
+    const float normalized = (extent > 0.0f) ? (value-offset)/extent : 0.0f;
+    return (uint16_t) (min(max(normalized, 0.0f), 1.0f)*65535.0f + 0.5f);
+}
+
+/**
+ * Quantizes a value of [-1 ; 1] to an integer from -32767 to 32767.
+ * @brief quantizeSigned
+ * @param value
+ * @return
+ */
+static inline int16_t quantizeSigned(float value)
+{
+    return (int16_t) floor(min(max(value, -1.0f), 1.0f)*32767.0f + 0.5f);
+}
+
+/**
+ * Encodes a unit vector on 2x16 bits with the octahedral mapping : the vector is projected on the octahedron |x|+|y|+|z| = 1
+ * and the lower half of the octahedron is folded over the upper half.
+ * @brief encodeOctahedral
+ * @param vector
+ * @param encodedVector
+ */
+static inline void encodeOctahedral(const QVector3D& vector, int16_t encodedVector[2])
+{
+    const float norm = fabs(vector.x()) + fabs(vector.y()) + fabs(vector.z());
+    float x = (norm > 0.0f) ? vector.x()/norm : 0.0f;
+    float y = (norm > 0.0f) ? vector.y()/norm : 0.0f;
+
+    if(norm > 0.0f && vector.z() < 0.0f)
+    {
+        const float foldedX = (1.0f-fabs(y))*(x >= 0.0f ? 1.0f : -1.0f);
+        const float foldedY = (1.0f-fabs(x))*(y >= 0.0f ? 1.0f : -1.0f);
+        x = foldedX;
+        y = foldedY;
+    }
+
+    encodedVector[0] = quantizeSigned(x);
+    encodedVector[1] = quantizeSigned(y);
+}
+
+/**
+ * Decodes a unit vector encoded by encodeOctahedral (as computed by the vertex shaders).
+ * @brief decodeOctahedral
+ * @param encodedVector
+ * @return
+ */
+static inline QVector3D decodeOctahedral(const int16_t encodedVector[2])
+{
+    QVector3D vector(encodedVector[0]/32767.0f, encodedVector[1]/32767.0f, 0.0f);
+    vector.setZ(1.0f - fabs(vector.x()) - fabs(vector.y()));
+
+    //Unfolds the lower half of the octahedron
+    const float t = max(-vector.z(), 0.0f);
+    vector.setX(vector.x() + (vector.x() >= 0.0f ? -t : t));
+    vector.setY(vector.y() + (vector.y() >= 0.0f ? -t : t));
+
+    return vector.normalized();
+}
+
+/**
+ * Default CompressedMesh constructor (no vertices).
+ * @brief CompressedMesh
+ */
+CompressedMesh::CompressedMesh(): m_vertices(), m_shortIndices(), m_indices(),
+    m_positionOffset(QVector3D()), m_positionExtent(QVector3D()), m_textureCoordinateOffset(QVector2D()), m_textureCoordinateExtent(QVector2D())
+{
+
+}
+
+/**
+ * Compresses the vertices and the triangles of a mesh. The normals, the texture coordinates and the tangents can be NULL.
+ * @brief CompressedMesh
+ * @param vertices
+ * @param vertexNormals
+ * @param textureCoordinates
+ * @param vertexTangents
+ * @param numberOfVertices
+ * @param indices
+ * @param numberOfIndices
+ */
+CompressedMesh::CompressedMesh(const QVector3D* vertices, const QVector3D* vertexNormals, const QVector2D* textureCoordinates, const QVector4D* vertexTangents,
+                               int numberOfVertices, const GLuint* indices, int numberOfIndices):
+    m_vertices(max(numberOfVertices, 0)), m_shortIndices(), m_indices(),
+    m_positionOffset(QVector3D()), m_positionExtent(QVector3D()), m_textureCoordinateOffset(QVector2D()), m_textureCoordinateExtent(QVector2D())
+{
+    if(numberOfVertices <= 0)
+        return;
+
+    //Bounding boxes of the positions and the texture coordinates
+    QVector3D minimum = vertices[0], maximum = vertices[0];
+    QVector2D minimumUV = textureCoordinates ? textureCoordinates[0] : QVector2D();
+    QVector2D maximumUV = minimumUV;
+
+    for(int v = 1 ; v<numberOfVertices ; v++)
+    {
+        minimum = QVector3D(min(minimum.x(), vertices[v].x()), min(minimum.y(), vertices[v].y()), min(minimum.z(), vertices[v].z()));
+        maximum = QVector3D(max(maximum.x(), vertices[v].x()), max(maximum.y(), vertices[v].y()), max(maximum.z(), vertices[v].z()));
+
+        if(textureCoordinates)
+        {
+            minimumUV = QVector2D(min(minimumUV.x(), textureCoordinates[v].x()), min(minimumUV.y(), textureCoordinates[v].y()));
+            maximumUV = QVector2D(max(maximumUV.x(), textureCoordinates[v].x()), max(maximumUV.y(), textureCoordinates[v].y()));
+        }
+    }
+
+    m_positionOffset = minimum;
+    m_positionExtent = maximum-minimum;
+    m_textureCoordinateOffset = minimumUV;
+    m_textureCoordinateExtent = maximumUV-minimumUV;
+
+    for(int v = 0 ; v<numberOfVertices ; v++)
+    {
+        CompressedVertex& vertex = m_vertices[v];
+
+        vertex.position[0] = quantizeUnsigned(vertices[v].x(), minimum.x(), m_positionExtent.x());
+        vertex.position[1] = quantizeUnsigned(vertices[v].y(), minimum.y(), m_positionExtent.y());
+        vertex.position[2] = quantizeUnsigned(vertices[v].z(), minimum.z(), m_positionExtent.z());
+        vertex.position[3] = (vertexTangents && vertexTangents[v].w() < 0.0f) ? 0 : 65535;
+
+        encodeOctahedral(vertexNormals ? vertexNormals[v] : QVector3D(), vertex.normal);
+        encodeOctahedral(vertexTangents ? vertexTangents[v].toVector3D() : QVector3D(), vertex.tangent);
+
+        vertex.textureCoordinate[0] = textureCoordinates ? quantizeUnsigned(textureCoordinates[v].x(), minimumUV.x(), m_textureCoordinateExtent.x()) : 0;
+        vertex.textureCoordinate[1] = textureCoordinates ? quantizeUnsigned(textureCoordinates[v].y(), minimumUV.y(), m_textureCoordinateExtent.y()) : 0;
+    }
+
+    //16 bits indices if they are all below 65536
+    if(numberOfVertices <= 65536)
+    {
+        m_shortIndices.assign(indices, indices+max(numberOfIndices, 0));
+    }
+    else
+    {
+        m_indices.assign(indices, indices+max(numberOfIndices, 0));
+    }
+}
+
+/**
+ * Returns the position of a vertex after decoding (as computed by the vertex shaders).
+ * @brief decodePosition
+ * @param vertex
+ * @return
+ */
+QVector3D CompressedMesh::decodePosition(const CompressedVertex& vertex) const
+{
+    return m_positionOffset + QVector3D(vertex.position[0]*m_positionExtent.x(), vertex.position[1]*m_positionExtent.y(), vertex.position[2]*m_positionExtent.z())/65535.0f;
+}
+
+/**
+ * Returns the normal of a vertex after decoding (as computed by the vertex shaders).
+ * @brief decodeNormal
+ * @param vertex
+ * @return
+ */
+QVector3D CompressedMesh::decodeNormal(const CompressedVertex& vertex) const
+{
+    return decodeOctahedral(vertex.normal);
+}
+
+/**
+ * Returns the texture coordinate of a vertex after decoding (as computed by the vertex shaders).
+ * @brief decodeTextureCoordinate
+ * @param vertex
+ * @return
+ */
+QVector2D CompressedMesh::decodeTextureCoordinate(const CompressedVertex& vertex) const
+{
+    return m_textureCoordinateOffset + QVector2D(vertex.textureCoordinate[0]*m_textureCoordinateExtent.x(), vertex.textureCoordinate[1]*m_textureCoordinateExtent.y())/65535.0f;
+}
+
+/**
+ * Returns the tangent of a vertex and the sign of its bitangent after decoding (as computed by the vertex shaders).
+ * @brief decodeTangent
+ * @param vertex
+ * @return
+ */
+QVector4D CompressedMesh::decodeTangent(const CompressedVertex& vertex) const
+{
+    return QVector4D(decodeOctahedral(vertex.tangent), vertex.position[3]/65535.0f*2.0f-1.0f);
+}
+
+/**
+ * Returns a pointer to the vertices.
+ * @brief getVertexData
+ * @return
+ */
+const CompressedVertex* CompressedMesh::getVertexData() const
+{
+    return m_vertices.empty() ? NULL : &m_vertices[0];
+}
+
+/**
+ * Returns a pointer to the indices (16 or 32 bits integers, see getIndexType).
+ * @brief getIndexData
+ * @return
+ */
+const void* CompressedMesh::getIndexData() const
+{
+    if(!m_shortIndices.empty())
+        return &m_shortIndices[0];
+
+    return m_indices.empty() ? NULL : &m_indices[0];
+}
+
+/**
+ * Returns the type of the indices : GL_UNSIGNED_SHORT or GL_UNSIGNED_INT.
+ * @brief getIndexType
+ * @return
+ */
+GLenum CompressedMesh::getIndexType() const
+{
+    return m_indices.empty() ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+}
+
+/**
+ * Returns the number of vertices.
+ * @brief getNumberOfVertices
+ * @return
+ */
+int CompressedMesh::getNumberOfVertices() const
+{
+    return (int) m_vertices.size();
+}
+
+/**
+ * Returns the number of indices (3 per triangle).
+ * @brief getNumberOfIndices
+ * @return
+ */
+int CompressedMesh::getNumberOfIndices() const
+{
+    return (int) (m_shortIndices.size() + m_indices.size());
+}
+
+/**
+ * Returns the size of the vertices and the indices in bytes.
+ * @brief getSize
+ * @return
+ */
+size_t CompressedMesh::getSize() const
+{
+    return m_vertices.size()*sizeof(CompressedVertex) + m_shortIndices.size()*sizeof(uint16_t) + m_indices.size()*sizeof(GLuint);
+}
+
+/**
+ * Returns the minimum of the positions : the position of the quantized value 0.
+ * @brief getPositionOffset
+ * @return
+ */
+QVector3D CompressedMesh::getPositionOffset() const
+{
+    return m_positionOffset;
+}
+
+/**
+ * Returns the size of the bounding box of the positions : the position of the quantized value 65535 minus the offset.
+ * @brief getPositionExtent
+ * @return
+ */
+QVector3D CompressedMesh::getPositionExtent() const
+{
+    return m_positionExtent;
+}
+
+/**
+ * Returns the minimum of the texture coordinates : the texture coordinate of the quantized value 0.
+ * @brief getTextureCoordinateOffset
+ * @return
+ */
+QVector2D CompressedMesh::getTextureCoordinateOffset() const
+{
+    return m_textureCoordinateOffset;
+}
+
+/**
+ * Returns the size of the bounding box of the texture coordinates.
+ * @brief getTextureCoordinateExtent
+ * @return
+ */
+QVector2D CompressedMesh::getTextureCoordinateExtent() const
+{
+    return m_textureCoordinateExtent;
+}
@@ -0,0 +1,202 @@
+/*
+ *     Real3D
+ *
+ *     Author:  Antoine TOISOUL LE CANN
+ *
+ *     Copyright © 2016 Antoine TOISOUL LE CANN, Imperial College London
+ *              All rights reserved
+ *
+ *
+ * Real3D is free software: you can redistribute it and/or modify
+ *
+ * it under the terms of the GNU Lesser General Public License as published by
+ *
+ * the Free Software Foundation, either version 3 of the License, or
+ *
+ * (at your option) any later version.
+ *
+ * Real3D is distributed in the hope that it will be useful,
+ *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ *
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * \file compressedmesh.h
+ * \brief Implementation of a CompressedMesh.
+ * \author Antoine Toisoul Le Cann
+ * \date October, 16th, 2026
+ *
+ * Compact copy of a mesh decoded by the vertex shaders : 20 bytes per vertex instead of 48, and 16 bits indices when there are
+ * at most 65536 vertices. The positions and texture coordinates are quantized on 16 bits relative to their bounding box and the
+ * normals and tangents are encoded on 2x16 bits with the octahedral mapping.
+ */
+
+#ifndef COMPRESSEDMESH_H
+#define COMPRESSEDMESH_H
+
+#include "openglheaders.h"
+
+#include <QVector2D>
+#include <QVector3D>
+#include <QVector4D>
+
+#include <vector>
+#include <stdint.h>
+
+/**
+ * Vertex of a compressed mesh (20 bytes). The attributes are read as normalized integers by OpenGL.
+ * @brief The CompressedVertex struct
+ */
+struct CompressedVertex
+{
+    uint16_t position[4]; /*!< Position in the bounding box of the mesh from 0 to 65535, then the sign of the bitangent (0 for -1, 65535 for 1). */
+    int16_t normal[2]; /*!< Octahedral encoding of the normal from -32767 to 32767. */
+    uint16_t textureCoordinate[2]; /*!< Texture coordinate in the bounding box of the texture coordinates from 0 to 65535. */
+    int16_t tangent[2]; /*!< Octahedral encoding of the tangent from -32767 to 32767. */
+};
+
+class CompressedMesh
+{
+    public:
+        /**
+         * Default CompressedMesh constructor (no vertices).
+         * @brief CompressedMesh
+         */
+        CompressedMesh();
+
+        /**
+         * Compresses the vertices and the triangles of a mesh. The normals, the texture coordinates and the tangents can be NULL.
+         * @brief CompressedMesh
+         * @param vertices
+         * @param vertexNormals
+         * @param textureCoordinates
+         * @param vertexTangents
+         * @param numberOfVertices
+         * @param indices
+         * @param numberOfIndices
+         */
+        CompressedMesh(const QVector3D* vertices, const QVector3D* vertexNormals, const QVector2D* textureCoordinates, const QVector4D* vertexTangents,
+                       int numberOfVertices, const GLuint* indices, int numberOfIndices);
+
+        /**
+         * Returns the position of a vertex after decoding (as computed by the vertex shaders).
+         * @brief decodePosition
+         * @param vertex
+         * @return
+         */
+        QVector3D decodePosition(const CompressedVertex& vertex) const;
+
+        /**
+         * Returns the normal of a vertex after decoding (as computed by the vertex shaders).
+         * @brief decodeNormal
+         * @param vertex
+         * @return
+         */
+        QVector3D decodeNormal(const CompressedVertex& vertex) const;
+
+        /**
+         * Returns the texture coordinate of a vertex after decoding (as computed by the vertex shaders).
+         * @brief decodeTextureCoordinate
+         * @param vertex
+         * @return
+         */
+        QVector2D decodeTextureCoordinate(const CompressedVertex& vertex) const;
+
+        /**
+         * Returns the tangent of a vertex and the sign of its bitangent after decoding (as computed by the vertex shaders).
+         * @brief decodeTangent
+         * @param vertex
+         * @return
+         */
+        QVector4D decodeTangent(const CompressedVertex& vertex) const;
+
+        /**
+         * Returns a pointer to the vertices.
+         * @brief getVertexData
+         * @return
+         */
+        const CompressedVertex* getVertexData() const;
+
+        /**
+         * Returns a pointer to the indices (16 or 32 bits integers, see getIndexType).
+         * @brief getIndexData
+         * @return
+         */
+        const void* getIndexData() const;
+
+        /**
+         * Returns the type of the indices : GL_UNSIGNED_SHORT or GL_UNSIGNED_INT.
+         * @brief getIndexType
+         * @return
+         */
+        GLenum getIndexType() const;
+
+        /**
+         * Returns the number of vertices.
+         * @brief getNumberOfVertices
+         * @return
+         */
+        int getNumberOfVertices() const;
+
+        /**
+         * Returns the number of indices (3 per triangle).
+         * @brief getNumberOfIndices
+         * @return
+         */
+        int getNumberOfIndices() const;
+
+        /**
+         * Returns the size of the vertices and the indices in bytes.
+         * @brief getSize
+         * @return
+         */
+        size_t getSize() const;
+
+        /**
+         * Returns the minimum of the positions : the position of the quantized value 0.
+         * @brief getPositionOffset
+         * @return
+         */
+        QVector3D getPositionOffset() const;
+
+        /**
+         * Returns the size of the bounding box of the positions : the position of the quantized value 65535 minus the offset.
+         * @brief getPositionExtent
+         * @return
+         */
+        QVector3D getPositionExtent() const;
+
+        /**
+         * Returns the minimum of the texture coordinates : the texture coordinate of the quantized value 0.
+         * @brief getTextureCoordinateOffset
+         * @return
+         */
+        QVector2D getTextureCoordinateOffset() const;
+
+        /**
+         * Returns the size of the bounding box of the texture coordinates.
+         * @brief getTextureCoordinateExtent
+         * @return
+         */
+        QVector2D getTextureCoordinateExtent() const;
+
+    private:
+        std::vector<CompressedVertex> m_vertices; /*!< Array of vertices. */
+        std::vector<uint16_t> m_shortIndices; /*!< Indices of the triangles if there are at most 65536 vertices. */
+        std::vector<GLuint> m_indices; /*!< Indices of the triangles if there are more than 65536 vertices. */
+
+        QVector3D m_positionOffset; /*!< Minimum of the positions. */
+        QVector3D m_positionExtent; /*!< Size of the bounding box of the positions. */
+        QVector2D m_textureCoordinateOffset; /*!< Minimum of the texture coordinates. */
+        QVector2D m_textureCoordinateExtent; /*!< Size of the bounding box of the texture coordinates. */
+};
+
+#endif // COMPRESSEDMESH_H
@@ -38,150 +38,2360 @@
  */
 
 #include "opengl/mesh.h"
+#include "other/parallel.h"
+#include "other/datacache.h"
+#include "maths/meshsimplification.h"
+
+#include <climits>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+#include <functional>
+#include <sstream>
+#include <unordered_map>
+#include <vector>
 
 using namespace std;
 
+#define OFF_BLOCK_SIZE 4194304 /*!< Approximate size in bytes of the blocks of lines of an OFF file parsed in parallel. */
+#define MESH_OVERDRAW_THRESHOLD 1.05f /*!< Maximum increase of the average cache miss ratio allowed to reorder the triangles for overdraw. */
+#define MESH_CACHE_BYTE_ORDER_MARK 0x01020304u /*!< Written in the byte order of the machine to detect cache files written by another architecture. */
+
+/**
+ * Powers of ten represented exactly by doubles.
+ */
+static const double exactPowersOfTen[23] = {1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+                                            1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+
+/**
+ * Skips the spaces and tabs (but not the end of the line).
+ * @brief skipSpaces
+ * @param p
+ * @param end
+ */
+static inline void skipSpaces(const char*& p, const char* end)
+{
+    while(p < end && (*p == ' ' || *p == '\t' || *p == '\r'))
+        p++;
+}
+
+/**
+ * Returns the beginning of the line that follows p (end if p is on the last line).
+ * @brief nextLine
+ * @param p
+ * @param end
+ * @return
+ */
+static inline const char* nextLine(const char* p, const char* end)
+{
+    const char* newLine = (const char*) memchr(p, '\n', end-p);
+    return (newLine == NULL) ? end : newLine+1;
+}
+
+/**
+ * Returns true if the line that starts at p contains data : it is neither empty nor a comment.
+ * @brief isDataLine
+ * @param p
+ * @param end
+ * @return
+ */
+static inline bool isDataLine(const char* p, const char* end)
+{
+    skipSpaces(p, end);
+    return p < end && *p != '\n' && *p != '#';
+}
+
+/**
+ * Parses a non negative integer at p and moves p after it. Returns false if p is not on a digit.
+ * @brief parseInteger
+ * @param p
+ * @param end
+ * @param value
+ * @return
+ */
+static inline bool parseInteger(const char*& p, const char* end, long long& value)
+{
+    skipSpaces(p, end);
+
+    if(p == end || *p < '0' || *p > '9')
+        return false;
+
+    value = 0;
+
+    while(p < end && *p >= '0' && *p <= '9')
+    {
+        value = 10*value + (*p-'0');
+        p++;
+    }
+
+    return true;
+}
+
+/**
+ * Parses a decimal number at p and moves p after it. Returns false if p is not on a number.
+ * Numbers of up to 15 significant digits with small exponents are converted with a single operation between exact doubles :
+ * the result is the correctly rounded double given by atof. Other numbers are converted by strtod.
+ * @brief parseFloat
+ * @param p
+ * @param end
+ * @param value
+ * @return
+ */
+static inline bool parseFloat(const char*& p, const char* end, float& value)
+{
+    skipSpaces(p, end);
+    const char* start = p;
+
+    bool negative = false;
+
+    if(p < end && (*p == '-' || *p == '+'))
+    {
+        negative = (*p == '-');
+        p++;
+    }
+
+    //The significant digits are accumulated in the mantissa, the position of the point in the exponent
+    unsigned long long mantissa = 0;
+    int numberOfDigits = 0;
+    int exponent = 0;
+    bool hasDigits = false;
+    bool afterPoint = false;
+
+    for( ; p < end ; p++)
+    {
+        if(*p >= '0' && *p <= '9')
+        {
+            hasDigits = true;
+
+            if(mantissa != 0 || *p != '0')
+                numberOfDigits++;
+
+            if(numberOfDigits <= 19)
+            {
+                mantissa = 10*mantissa + (*p-'0');
+                exponent -= afterPoint ? 1 : 0;
+            }
+            else
+            {
+                exponent += afterPoint ? 0 : 1;
+            }
+        }
+        else if(*p == '.' && !afterPoint)
+        {
+            afterPoint = true;
+        }
+        else
+        {
+            break;
+        }
+    }
+
+    if(!hasDigits)
+    {
+        p = start;
+        return false;
+    }
+
+    if(p+1 < end && (*p == 'e' || *p == 'E'))
+    {
+        const char* exponentDigits = p+1;
+        bool negativeExponent = false;
+
+        if(*exponentDigits == '-' || *exponentDigits == '+')
+        {
+            negativeExponent = (*exponentDigits == '-');
+            exponentDigits++;
+        }
+
+        long long explicitExponent = 0;
+
+        if(exponentDigits < end && *exponentDigits >= '0' && *exponentDigits <= '9' && parseInteger(exponentDigits, end, explicitExponent))
+        {
+            explicitExponent = min(explicitExponent, 100000LL);
+            exponent += (int) (negativeExponent ? -explicitExponent : explicitExponent);
+            p = exponentDigits;
+        }
+    }
+
+    if(numberOfDigits <= 15 && exponent >= -22 && exponent <= 22)
+    {
+        double result = (double) mantissa;
+        result = (exponent < 0) ? result/exactPowersOfTen[-exponent] : result*exactPowersOfTen[exponent];
+        value = (float) (negative ? -result : result);
+        return true;
+    }
+
+    //The file is not terminated by a null character : the number is copied
+    char buffer[64];
+    size_t length = min((size_t) (p-start), sizeof(buffer)-1);
+    memcpy(buffer, start, length);
+    buffer[length] = '\0';
+    value = (float) strtod(buffer, NULL);
+
+    return true;
+}
+
+
+/**
+ * Types of the properties of a PLY file.
+ */
+enum PLYType {PLY_INT8, PLY_UINT8, PLY_INT16, PLY_UINT16, PLY_INT32, PLY_UINT32, PLY_FLOAT32, PLY_FLOAT64, PLY_INVALID};
+
+/**
+ * Formats of the data of a PLY file.
+ */
+enum PLYFormat {PLY_ASCII, PLY_BINARY_LITTLE_ENDIAN, PLY_BINARY_BIG_ENDIAN};
+
+/**
+ * Property of an element of a PLY file : a value or a list of values preceded by their number.
+ * @brief The PLYProperty struct
+ */
+struct PLYProperty
+{
+    string name; /*!< Name of the property. */
+    PLYType type; /*!< Type of the value (of the values of the list). */
+    PLYType countType; /*!< Type of the number of values of a list. */
+    bool isList; /*!< True if the property is a list. */
+};
+
+/**
+ * Element of a PLY file (vertex, face...) : count records of the same properties.
+ * @brief The PLYElement struct
+ */
+struct PLYElement
+{
+    string name; /*!< Name of the element. */
+    long long count; /*!< Number of records of the element. */
+    vector<PLYProperty> properties; /*!< Properties of each record. */
+};
+
+/**
+ * Returns the type of a property of a PLY file from its name in the header.
+ * @brief plyType
+ * @param name
+ * @return
+ */
+static PLYType plyType(const string& name)
+{
+    if(name == "char" || name == "int8")
+        return PLY_INT8;
+    if(name == "uchar" || name == "uint8")
+        return PLY_UINT8;
+    if(name == "short" || name == "int16")
+        return PLY_INT16;
+    if(name == "ushort" || name == "uint16")
+        return PLY_UINT16;
+    if(name == "int" || name == "int32")
+        return PLY_INT32;
+    if(name == "uint" || name == "uint32")
+        return PLY_UINT32;
+    if(name == "float" || name == "float32")
+        return PLY_FLOAT32;
+    if(name == "double" || name == "float64")
+        return PLY_FLOAT64;
+
+    return PLY_INVALID;
+}
+
+/**
+ * Reads a value of a PLY file at p and moves p after it. Binary values in the byte order of the file are swapped
+ * if it is not the byte order of the machine. Returns false at the end of the data or if the value is not a number.
+ * @brief readPLYValue
+ * @param p
+ * @param end
+ * @param type
+ * @param format
+ * @param value
+ * @return
+ */
+static inline bool readPLYValue(const char*& p, const char* end, PLYType type, PLYFormat format, double& value)
+{
+    if(format == PLY_ASCII)
+    {
+        while(p < end && (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n'))
+            p++;
+
+        if(type == PLY_FLOAT32 || type == PLY_FLOAT64)
+        {
+            float floatValue = 0.0f;
+            bool read = parseFloat(p, end, floatValue);
+            value = floatValue;
+            return read;
+        }
+
+        bool negative = (p < end && *p == '-');
+        p += negative ? 1 : 0;
+
+        long long integerValue = 0;
+        bool read = parseInteger(p, end, integerValue);
+        value = (double) (negative ? -integerValue : integerValue);
+        return read;
+    }
+
+    static const int sizes[PLY_INVALID] = {1, 1, 2, 2, 4, 4, 4, 8};
+    const int size = sizes[type];
+
+    if(end-p < size)
+        return false;
+
+    //Copy in the byte order of the machine
+    const unsigned int one = 1;
+    const bool isLittleEndianMachine = (*(const unsigned char*) &one == 1);
+    unsigned char bytes[8];
+
+    if(isLittleEndianMachine == (format == PLY_BINARY_LITTLE_ENDIAN))
+    {
+        memcpy(bytes, p, size);
+    }
+    else
+    {
+        for(int k = 0 ; k<size ; k++)
+            bytes[k] = (unsigned char) p[size-1-k];
+    }
+
+    p += size;
+
+    switch(type)
+    {
+        case PLY_INT8: { int8_t v; memcpy(&v, bytes, 1); value = v; break; }
+        case PLY_UINT8: { uint8_t v; memcpy(&v, bytes, 1); value = v; break; }
+        case PLY_INT16: { int16_t v; memcpy(&v, bytes, 2); value = v; break; }
+        case PLY_UINT16: { uint16_t v; memcpy(&v, bytes, 2); value = v; break; }
+        case PLY_INT32: { int32_t v; memcpy(&v, bytes, 4); value = v; break; }
+        case PLY_UINT32: { uint32_t v; memcpy(&v, bytes, 4); value = v; break; }
+        case PLY_FLOAT32: { float v; memcpy(&v, bytes, 4); value = v; break; }
+        default: { double v; memcpy(&v, bytes, 8); value = v; break; }
+    }
+
+    return true;
+}
+
+
+
+/**
+ * Corner of a face of an OBJ file : 0 based indices of its position, texture coordinate and normal (-1 if it has none).
+ * @brief The OBJCorner struct
+ */
+struct OBJCorner
+{
+    int position; /*!< Index of the position. */
+    int textureCoordinate; /*!< Index of the texture coordinate. */
+    int normal; /*!< Index of the normal. */
+
+    bool operator==(const OBJCorner& corner) const
+    {
+        return position == corner.position && textureCoordinate == corner.textureCoordinate && normal == corner.normal;
+    }
+};
+
+/**
+ * Hash of the corners of an OBJ file. The three indices are mixed in 64 bits so that corners that share a position
+ * (or a position and a texture coordinate) do not collide.
+ * @brief The OBJCornerHash struct
+ */
+struct OBJCornerHash
+{
+    size_t operator()(const OBJCorner& corner) const
+    {
+        uint64_t hash = (uint64_t) (uint32_t) corner.position;
+        hash = hash*0x9E3779B97F4A7C15ULL + (uint64_t) (uint32_t) corner.textureCoordinate;
+        hash = hash*0x9E3779B97F4A7C15ULL + (uint64_t) (uint32_t) corner.normal;
+        hash ^= hash >> 29;
+        hash *= 0xBF58476D1CE4E5B9ULL;
+        hash ^= hash >> 32;
+
+        return (size_t) hash;
+    }
+};
+
+/**
+ * Parses an index of a face of an OBJ file at p and moves p after it. Positive indices start at 1 and negative indices
+ * are relative to the end of the list of count elements read so far. Returns the 0 based index or -1 if there is no index.
+ * @brief parseOBJIndex
+ * @param p
+ * @param end
+ * @param count
+ * @return
+ */
+static inline long long parseOBJIndex(const char*& p, const char* end, long long count)
+{
+    bool negative = (p < end && *p == '-');
+    p += negative ? 1 : 0;
+
+    long long index = 0;
+
+    if(p == end || *p < '0' || *p > '9' || !parseInteger(p, end, index) || index == 0)
+        return -1;
+
+    return negative ? count-index : index-1;
+}
+
+/**
+ * Returns true if the line at p starts with the keyword followed by a space.
+ * @brief isOBJKeyword
+ * @param p
+ * @param end
+ * @param keyword
+ * @param length
+ * @return
+ */
+static inline bool isOBJKeyword(const char* p, const char* end, const char* keyword, int length)
+{
+    return end-p > length && memcmp(p, keyword, length) == 0 && (p[length] == ' ' || p[length] == '\t');
+}
+
+/**
+ * Simulates a FIFO post transform cache of cacheSize vertices and returns the number of cache misses of each triangle
+ * added to misses. A vertex is in the cache if it was added less than cacheSize misses ago : time is the number of misses
+ * plus an offset and timestamps the time at which each vertex was added. Adding cacheSize+1 to time empties the cache.
+ * @brief cacheMisses
+ * @param triangle
+ * @param timestamps
+ * @param time
+ * @param cacheSize
+ * @return
+ */
+static inline unsigned int cacheMisses(const GLuint* triangle, vector<size_t>& timestamps, size_t& time, int cacheSize)
+{
+    unsigned int misses = 0;
+
+    for(int c = 0 ; c<3 ; c++)
+    {
+        if(time - timestamps[triangle[c]] > (size_t) cacheSize)
+        {
+            timestamps[triangle[c]] = time++;
+            misses++;
+        }
+    }
+
+    return misses;
+}
+
+/**
+ * Returns the average cache miss ratio (number of vertices transformed per triangle, between 0.5 and 3)
+ * of a list of triangles with a FIFO post transform cache of cacheSize vertices.
+ * @brief averageCacheMissRatio
+ * @param indices
+ * @param numberOfIndices
+ * @param numberOfVertices
+ * @param cacheSize
+ * @return
+ */
+static float averageCacheMissRatio(const GLuint* indices, size_t numberOfIndices, size_t numberOfVertices, int cacheSize)
+{
+    if(numberOfIndices < 3)
+        return 0.0f;
+
+    vector<size_t> timestamps(numberOfVertices, 0);
+    size_t time = cacheSize+1;
+    size_t misses = 0;
+
+    for(size_t k = 0 ; k+2<numberOfIndices ; k += 3)
+    {
+        misses += cacheMisses(&indices[k], timestamps, time, cacheSize);
+    }
+
+    return (float) misses/(numberOfIndices/3);
+}
+
+/**
+ * Orders the triangles for the post transform vertex cache (Tom Forsyth, Linear-speed vertex cache optimisation).
+ * Vertices are scored from their position in a LRU cache of MESH_VERTEX_CACHE_SIZE vertices and from their number of triangles
+ * not drawn yet. The next triangle is the triangle of highest score among the triangles of the vertices in the cache,
+ * or the next triangle of the input order if none of them is left. The cost is linear in the number of triangles.
+ * @brief optimizeVertexCache
+ * @param indices
+ * @param numberOfIndices
+ * @param numberOfVertices
+ * @param destination
+ */
+static void optimizeVertexCache(const GLuint* indices, size_t numberOfIndices, size_t numberOfVertices, GLuint* destination)
+{
+    const size_t numberOfTriangles = numberOfIndices/3;
+    const int cacheSize = MESH_VERTEX_CACHE_SIZE;
+
+    //Scores of the positions in the cache and of the number of triangles left
+    float positionScores[MESH_VERTEX_CACHE_SIZE];
+    float valenceScores[64];
+
+    for(int i = 0 ; i<cacheSize ; i++)
+        positionScores[i] = (i < 3) ? 0.75f : pow(1.0f - (float) (i-3)/(cacheSize-3), 1.5f);
+
+    for(int i = 1 ; i<64 ; i++)
+        valenceScores[i] = 2.0f/sqrt((float) i);
+
+    auto vertexScore = [&](int position, unsigned int remaining) -> float
+    {
+        if(remaining == 0)
+            return -1.0f;
+
+        return ((position >= 0) ? positionScores[position] : 0.0f) + ((remaining < 64) ? valenceScores[remaining] : 2.0f/sqrt((float) remaining));
+    };
+
+    //Triangles of each vertex that are not drawn yet : the first remaining[v] triangles of the list of v
+    vector<unsigned int> remaining(numberOfVertices, 0);
+    vector<size_t> firstTriangle(numberOfVertices+1, 0);
+
+    for(size_t k = 0 ; k<3*numberOfTriangles ; k++)
+        remaining[indices[k]]++;
+
+    for(size_t v = 0 ; v<numberOfVertices ; v++)
+        firstTriangle[v+1] = firstTriangle[v] + remaining[v];
+
+    vector<unsigned int> vertexTriangles(3*numberOfTriangles);
+    vector<size_t> fill(firstTriangle.begin(), firstTriangle.end()-1);
+
+    for(size_t k = 0 ; k<3*numberOfTriangles ; k++)
+        vertexTriangles[fill[indices[k]]++] = (unsigned int) (k/3);
+
+    vector<int> cachePosition(numberOfVertices, -1);
+    vector<float> scores(numberOfVertices);
+    vector<float> triangleScores(numberOfTriangles);
+    vector<char> emitted(numberOfTriangles, 0);
+
+    for(size_t v = 0 ; v<numberOfVertices ; v++)
+        scores[v] = vertexScore(-1, remaining[v]);
+
+    long long best = -1;
+    float bestScore = -1.0f;
+
+    for(size_t t = 0 ; t<numberOfTriangles ; t++)
+    {
+        triangleScores[t] = scores[indices[3*t]] + scores[indices[3*t+1]] + scores[indices[3*t+2]];
+
+        if(triangleScores[t] > bestScore)
+        {
+            bestScore = triangleScores[t];
+            best = (long long) t;
+        }
+    }
+
+    GLuint cache[MESH_VERTEX_CACHE_SIZE+3];
+    GLuint newCache[MESH_VERTEX_CACHE_SIZE+3];
+    int cacheCount = 0;
+    size_t inputCursor = 0;
+
+    for(size_t n = 0 ; n<numberOfTriangles ; n++)
+    {
+        //Dead end : next triangle of the input order
+        if(best < 0)
+        {
+            while(emitted[inputCursor])
+                inputCursor++;
+
+            best = (long long) inputCursor;
+        }
+
+        const GLuint* triangle = &indices[3*best];
+        destination[3*n] = triangle[0];
+        destination[3*n+1] = triangle[1];
+        destination[3*n+2] = triangle[2];
+        emitted[best] = 1;
+
+        //The triangle is removed from the lists of its vertices
+        for(int c = 0 ; c<3 ; c++)
+        {
+            unsigned int* list = &vertexTriangles[firstTriangle[triangle[c]]];
+            unsigned int& count = remaining[triangle[c]];
+
+            for(unsigned int i = 0 ; i<count ; i++)
+            {
+                if(list[i] == (unsigned int) best)
+                {
+                    swap(list[i], list[count-1]);
+                    count--;
+                    break;
+                }
+            }
+        }
+
+        //The vertices of the triangle move to the front of the cache
+        int newCacheCount = 0;
+
+        for(int c = 0 ; c<3 ; c++)
+        {
+            if(find(newCache, newCache+newCacheCount, triangle[c]) == newCache+newCacheCount)
+                newCache[newCacheCount++] = triangle[c];
+        }
+
+        for(int i = 0 ; i<cacheCount ; i++)
+        {
+            if(cache[i] != triangle[0] && cache[i] != triangle[1] && cache[i] != triangle[2])
+                newCache[newCacheCount++] = cache[i];
+        }
+
+        for(int i = 0 ; i<newCacheCount ; i++)
+        {
+            cachePosition[newCache[i]] = (i < cacheSize) ? i : -1;
+            scores[newCache[i]] = vertexScore(cachePosition[newCache[i]], remaining[newCache[i]]);
+        }
+
+        //Scores of the triangles of the vertices whose score changed
+        best = -1;
+        bestScore = -1.0f;
+
+        for(int i = 0 ; i<newCacheCount ; i++)
+        {
+            const unsigned int* list = &vertexTriangles[firstTriangle[newCache[i]]];
+
+            for(unsigned int j = 0 ; j<remaining[newCache[i]] ; j++)
+            {
+                const unsigned int t = list[j];
+                triangleScores[t] = scores[indices[3*t]] + scores[indices[3*t+1]] + scores[indices[3*t+2]];
+
+                if(triangleScores[t] > bestScore)
+                {
+                    bestScore = triangleScores[t];
+                    best = t;
+                }
+            }
+        }
+
+        cacheCount = min(newCacheCount, cacheSize);
+        copy(newCache, newCache+cacheCount, cache);
+    }
+}
+
+/**
+ * Reorders groups of triangles to reduce overdraw, keeping the vertex cache order inside each group
+ * (Sander et al., Fast triangle reordering for vertex locality and reduced overdraw).
+ * The list is split where the cache starts again (a triangle with 3 cache misses) and where the average cache miss ratio
+ * of the beginning of a group is less than threshold times the one of the whole group. The groups are then drawn from
+ * the one that faces the most outwards (dot product between the normal of the group and its position from the center of the mesh)
+ * so that the groups in front, more likely to be visible, hide the others.
+ * @brief optimizeOverdraw
+ * @param indices
+ * @param numberOfIndices
+ * @param vertices
+ * @param numberOfVertices
+ * @param threshold
+ */
+static void optimizeOverdraw(GLuint* indices, size_t numberOfIndices, const QVector3D* vertices, size_t numberOfVertices, float threshold)
+{
+    const size_t numberOfTriangles = numberOfIndices/3;
+
+    if(numberOfTriangles == 0)
+        return;
+
+    vector<size_t> timestamps(numberOfVertices, 0);
+    size_t time = MESH_VERTEX_CACHE_SIZE+1;
+
+    //Hard boundaries : the cache starts again
+    vector<size_t> hardBoundaries;
+
+    for(size_t t = 0 ; t<numberOfTriangles ; t++)
+    {
+        if(cacheMisses(&indices[3*t], timestamps, time, MESH_VERTEX_CACHE_SIZE) == 3 || t == 0)
+            hardBoundaries.push_back(t);
+    }
+
+    hardBoundaries.push_back(numberOfTriangles);
+
+    //Soft boundaries : the cache can start again without increasing the cache misses much
+    vector<size_t> clusters;
+
+    for(size_t h = 0 ; h+1<hardBoundaries.size() ; h++)
+    {
+        const size_t first = hardBoundaries[h];
+        const size_t last = hardBoundaries[h+1];
+
+        time += MESH_VERTEX_CACHE_SIZE+1;
+        size_t misses = 0;
+
+        for(size_t t = first ; t<last ; t++)
+            misses += cacheMisses(&indices[3*t], timestamps, time, MESH_VERTEX_CACHE_SIZE);
+
+        const float clusterThreshold = threshold*misses/(last-first);
+
+        time += MESH_VERTEX_CACHE_SIZE+1;
+        size_t clusterFirst = first;
+        misses = 0;
+        clusters.push_back(first);
+
+        for(size_t t = first ; t+1<last ; t++)
+        {
+            misses += cacheMisses(&indices[3*t], timestamps, time, MESH_VERTEX_CACHE_SIZE);
+
+            if((float) misses/(t+1-clusterFirst) <= clusterThreshold)
+            {
+                clusterFirst = t+1;
+                clusters.push_back(clusterFirst);
+                time += MESH_VERTEX_CACHE_SIZE+1;
+                misses = 0;
+            }
+        }
+    }
+
+    clusters.push_back(numberOfTriangles);
+    const size_t numberOfClusters = clusters.size()-1;
+
+    //Center of the mesh and center and normal of each cluster, weighted by the area of the triangles
+    vector<QVector3D> clusterCenters(numberOfClusters);
+    vector<QVector3D> clusterNormals(numberOfClusters);
+    QVector3D meshCenter;
+    float meshArea = 0.0f;
+
+    for(size_t c = 0 ; c<numberOfClusters ; c++)
+    {
+        QVector3D center;
+        QVector3D normal;
+        float area = 0.0f;
+
+        for(size_t t = clusters[c] ; t<clusters[c+1] ; t++)
+        {
+            const QVector3D& a = vertices[indices[3*t]];
+            const QVector3D& b = vertices[indices[3*t+1]];
+            const QVector3D& d = vertices[indices[3*t+2]];
+            const QVector3D crossProduct = QVector3D::crossProduct(b-a, d-a);
+            const float triangleArea = crossProduct.length();
+
+            center += triangleArea*(a+b+d)/3.0f;
+            normal += crossProduct;
+            area += triangleArea;
+        }
+
+        meshCenter += center;
+        meshArea += area;
+        clusterCenters[c] = (area > 0.0f) ? center/area : QVector3D();
+        clusterNormals[c] = normal.normalized();
+    }
+
+    meshCenter = (meshArea > 0.0f) ? meshCenter/meshArea : QVector3D();
+
+    vector<float> sortKeys(numberOfClusters);
+    vector<size_t> order(numberOfClusters);
+
+    for(size_t c = 0 ; c<numberOfClusters ; c++)
+    {
+        sortKeys[c] = QVector3D::dotProduct(clusterCenters[c]-meshCenter, clusterNormals[c]);
+        order[c] = c;
+    }
+
+    stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) { return sortKeys[a] > sortKeys[b]; });
+
+    vector<GLuint> sorted(3*numberOfTriangles);
+    size_t n = 0;
+
+    for(size_t c = 0 ; c<numberOfClusters ; c++)
+    {
+        for(size_t k = 3*clusters[order[c]] ; k<3*clusters[order[c]+1] ; k++)
+            sorted[n++] = indices[k];
+    }
+
+    copy(sorted.begin(), sorted.end(), indices);
+}
+
+/**
+ * Returns a QVector that contains a copy of size elements of an array.
+ * @brief copyArray
+ * @param data
+ * @param size
+ * @return
+ */
+template <typename T> static QVector<T> copyArray(const T* data, int size)
+{
+    QVector<T> array(size);
+    copy(data, data+size, array.begin());
+
+    return array;
+}
+
+/**
+ * Returns a QVector that contains an attribute of each vertex of a compressed mesh after decoding.
+ * @brief decodeArray
+ * @param mesh
+ * @param decode
+ * @return
+ */
+template <typename T> static QVector<T> decodeArray(const CompressedMesh& mesh, function<T(const CompressedVertex&)> decode)
+{
+    const CompressedVertex* vertices = mesh.getVertexData();
+    QVector<T> array(mesh.getNumberOfVertices());
+
+    for(int k = 0 ; k<array.size() ; k++)
+    {
+        array[k] = decode(vertices[k]);
+    }
+
+    return array;
+}
+
+/**
+ * Returns the indices of a compressed mesh as 32 bits integers.
+ * @brief decodeIndices
+ * @param mesh
+ * @return
+ */
+static QVector<GLuint> decodeIndices(const CompressedMesh& mesh)
+{
+    if(mesh.getIndexType() == GL_UNSIGNED_INT)
+        return copyArray((const GLuint*) mesh.getIndexData(), mesh.getNumberOfIndices());
+
+    const uint16_t* indices = (const uint16_t*) mesh.getIndexData();
+    QVector<GLuint> array(mesh.getNumberOfIndices());
+    copy(indices, indices+array.size(), array.begin());
+
+    return array;
+}
+
+/**
+ * Lists the corners (index 3*triangle+corner) of each vertex sorted by triangle : vertexCorners[firstCorner[k]] to vertexCorners[firstCorner[k+1]-1]
+ * are the corners of the vertex k. A vertex repeated in a degenerate triangle only counts once.
+ * @brief listVertexCorners
+ * @param indices
+ * @param numberOfTriangles
+ * @param numberOfVertices
+ * @param firstCorner
+ * @param vertexCorners
+ */
+static void listVertexCorners(const QVector3D* indices, int numberOfTriangles, int numberOfVertices, vector<int>& firstCorner, vector<int>& vertexCorners)
+{
+    firstCorner.assign(numberOfVertices+1, 0);
+    vertexCorners.resize(3*numberOfTriangles);
+
+    for(int i = 0 ; i<numberOfTriangles ; i++)
+    {
+        int index[3] = {(int) indices[i].x(), (int) indices[i].y(), (int) indices[i].z()};
+
+        for(int c = 0 ; c<3 ; c++)
+        {
+            if((c > 0 && index[c] == index[0]) || (c > 1 && index[c] == index[1]))
+                continue;
+
+            firstCorner[index[c]+1]++;
+        }
+    }
+
+    for(int k = 0 ; k<numberOfVertices ; k++)
+    {
+        firstCorner[k+1] += firstCorner[k];
+    }
+
+    vector<int> nextCorner(firstCorner.begin(), firstCorner.end()-1);
+
+    for(int i = 0 ; i<numberOfTriangles ; i++)
+    {
+        int index[3] = {(int) indices[i].x(), (int) indices[i].y(), (int) indices[i].z()};
+
+        for(int c = 0 ; c<3 ; c++)
+        {
+            if((c > 0 && index[c] == index[0]) || (c > 1 && index[c] == index[1]))
+                continue;
+
+            vertexCorners[nextCorner[index[c]]++] = 3*i+c;
+        }
+    }
+}
+
+/**
+ * Default Mesh constructor.
+ * @brief Mesh
+ */
+Mesh::Mesh():m_vertices(QVector<QVector3D>()), m_indices(QVector<QVector3D>()),
+             m_indicesArray(QVector<GLuint>()), m_triangleNormals( QVector<QVector3D>()), m_vertexNormals( QVector<QVector3D>()),
+             m_textureCoordinates(QVector<QVector2D>()), m_vertexTangents(QVector<QVector4D>()), m_cache(), m_compressedMesh()
+{
+
+}
+
+/**
+ * Loads a Mesh given its name.
+ * @brief Mesh
+ * @param objectName
+ */
+Mesh::Mesh(const string& objectName):m_vertices(QVector<QVector3D>()), m_indices(QVector<QVector3D>()),
+                            m_indicesArray(QVector<GLuint>()), m_triangleNormals( QVector<QVector3D>()), m_vertexNormals( QVector<QVector3D>()),
+                            m_textureCoordinates(QVector<QVector2D>()), m_vertexTangents(QVector<QVector4D>()), m_cache(), m_compressedMesh()
+{
+    string fileName = loadPathAndTextureCoordinates(objectName);
+    readFile(fileName);
+}
+
+/**
+ * Reads the triangles from a .off file.
+ * The file is mapped in memory and split in blocks of lines parsed in parallel. Polygons with more than 3 vertices
+ * are split in a fan of triangles around their first vertex.
+ * @brief offReader
+ * @param fileName
+ */
+void Mesh::offReader(string fileName)
+{
+    m_cache.reset();
+    m_compressedMesh.reset();
+    m_vertices.clear();
+    m_indices.clear();
+    m_indicesArray.clear();
+
+    size_t fileSize = 0;
+    const char* file = (const char*) mapFile(fileName, fileSize);
+
+    if(file == NULL)
+    {
+        cerr << "Could not open the file : " << fileName << endl;
+        computeNormals();
+        return;
+    }
+
+    const char* end = file + fileSize;
+    const char* p = file;
+
+    //Header : OFF (or a variant such as COFF) then the number of vertices, faces and edges, comments and empty lines are skipped
+    long long counts[3] = {0, 0, 0};
+    int numberOfCounts = 0;
+    bool isOFFFile = false;
+
+    while(p < end && numberOfCounts < 3)
+    {
+        skipSpaces(p, end);
+
+        if(p == end || *p == '\n' || *p == '#')
+        {
+            p = nextLine(p, end);
+        }
+        else if(!isOFFFile)
+        {
+            const char* token = p;
+
+            while(p < end && *p != ' ' && *p != '\t' && *p != '\r' && *p != '\n')
+                p++;
+
+            isOFFFile = (p-token >= 3 && memcmp(p-3, "OFF", 3) == 0);
+
+            if(!isOFFFile)
+                break;
+        }
+        else if(!parseInteger(p, end, counts[numberOfCounts++]))
+        {
+            break;
+        }
+    }
+
+    if(!isOFFFile || numberOfCounts < 3 || counts[0] <= 0 || counts[0] > INT_MAX || counts[1] < 0 || counts[1] > INT_MAX)
+    {
+        cerr << "The file is not a valid OFF file : " << fileName << endl;
+        unmapFile((void*) file, fileSize);
+        computeNormals();
+        return;
+    }
+
+    const int numberOfVertices = (int) counts[0];
+    const int numberOfFaces = (int) counts[1];
+    const char* body = nextLine(p, end);
+
+    //Blocks of about 4 MB that start at the beginning of a line
+    const int numberOfBlocks = (int) min((size_t) (4*numberOfCores()), (size_t) (end-body)/(OFF_BLOCK_SIZE)+1);
+    vector<const char*> blockStart(numberOfBlocks+1, end);
+
+    for(int b = 0 ; b<numberOfBlocks ; b++)
+    {
+        const char* start = body + (size_t) (end-body)*b/numberOfBlocks;
+        blockStart[b] = (b == 0) ? body : nextLine(start-1, end);
+    }
+
+    for(int b = 1 ; b<numberOfBlocks ; b++)
+    {
+        blockStart[b] = max(blockStart[b], blockStart[b-1]);
+    }
+
+    //Number of lines of data (vertices or faces) before each block
+    vector<long long> firstDataLine(numberOfBlocks+1, 0);
+
+    parallelFor(0, numberOfBlocks, [&](int firstBlock, int lastBlock)
+    {
+        for(int b = firstBlock ; b<lastBlock ; b++)
+        {
+            long long numberOfLines = 0;
+
+            for(const char* line = blockStart[b] ; line < blockStart[b+1] ; line = nextLine(line, blockStart[b+1]))
+            {
+                numberOfLines += isDataLine(line, blockStart[b+1]) ? 1 : 0;
+            }
+
+            firstDataLine[b+1] = numberOfLines;
+        }
+    });
+
+    for(int b = 0 ; b<numberOfBlocks ; b++)
+    {
+        firstDataLine[b+1] += firstDataLine[b];
+    }
+
+    //Vertices are written directly at their index, the triangles of each block are gathered once the blocks are parsed
+    m_vertices.resize(numberOfVertices);
+    QVector3D* vertices = m_vertices.data();
+
+    vector< vector<GLuint> > blockTriangles(numberOfBlocks);
+    vector<long long> blockErrors(numberOfBlocks, 0);
+
+    parallelFor(0, numberOfBlocks, [&](int firstBlock, int lastBlock)
+    {
+        vector<long long> polygon;
+
+        for(int b = firstBlock ; b<lastBlock ; b++)
+        {
+            long long dataLine = firstDataLine[b];
+            const char* blockEnd = blockStart[b+1];
+
+            for(const char* line = blockStart[b] ; line < blockEnd && dataLine < numberOfVertices+numberOfFaces ; line = nextLine(line, blockEnd))
+            {
+                if(!isDataLine(line, blockEnd))
+                    continue;
+
+                const char* q = line;
+
+                if(dataLine < numberOfVertices)
+                {
+                    float x = 0.0f, y = 0.0f, z = 0.0f;
+
+                    if(!(parseFloat(q, blockEnd, x) && parseFloat(q, blockEnd, y) && parseFloat(q, blockEnd, z)))
+                        blockErrors[b]++;
+
+                    vertices[dataLine] = QVector3D(x, y, z);
+                }
+                else
+                {
+                    //Polygon : number of vertices then the indices, followed by an optional color
+                    long long numberOfIndices = 0;
+                    bool valid = parseInteger(q, blockEnd, numberOfIndices) && numberOfIndices >= 3;
+
+                    polygon.clear();
+
+                    for(long long k = 0 ; valid && k<numberOfIndices ; k++)
+                    {
+                        long long index = 0;
+                        valid = parseInteger(q, blockEnd, index) && index < numberOfVertices;
+                        polygon.push_back(index);
+                    }
+
+                    if(!valid)
+                    {
+                        blockErrors[b]++;
+                    }
+                    else
+                    {
+                        for(size_t k = 1 ; k+1<polygon.size() ; k++)
+                        {
+                            blockTriangles[b].push_back((GLuint) polygon[0]);
+                            blockTriangles[b].push_back((GLuint) polygon[k]);
+                            blockTriangles[b].push_back((GLuint) polygon[k+1]);
+                        }
+                    }
+                }
+
+                dataLine++;
+            }
+        }
+    });
+
+    unmapFile((void*) file, fileSize);
+
+    long long numberOfErrors = 0;
+    vector<size_t> firstIndex(numberOfBlocks+1, 0);
+
+    for(int b = 0 ; b<numberOfBlocks ; b++)
+    {
+        numberOfErrors += blockErrors[b];
+        firstIndex[b+1] = firstIndex[b] + blockTriangles[b].size();
+    }
+
+    if(firstDataLine[numberOfBlocks] < numberOfVertices+numberOfFaces || numberOfErrors > 0)
+    {
+        cerr << "The OFF file is truncated or contains " << numberOfErrors << " invalid lines : " << fileName << endl;
+    }
+
+    //List of indices for OpenGL rendering and indices for each triangle
+    m_indicesArray.resize((int) firstIndex[numberOfBlocks]);
+    m_indices.resize((int) firstIndex[numberOfBlocks]/3);
+    GLuint* indicesArray = m_indicesArray.data();
+    QVector3D* indices = m_indices.data();
+
+    parallelFor(0, numberOfBlocks, [&](int firstBlock, int lastBlock)
+    {
+        for(int b = firstBlock ; b<lastBlock ; b++)
+        {
+            const vector<GLuint>& triangles = blockTriangles[b];
+
+            for(size_t k = 0 ; k<triangles.size() ; k += 3)
+            {
+                indicesArray[firstIndex[b]+k] = triangles[k];
+                indicesArray[firstIndex[b]+k+1] = triangles[k+1];
+                indicesArray[firstIndex[b]+k+2] = triangles[k+2];
+                indices[(firstIndex[b]+k)/3] = QVector3D(triangles[k], triangles[k+1], triangles[k+2]);
+            }
+        }
+    });
+
+    computeNormals();
+}
+
+/**
+ * Reads the vertices (positions, normals and texture coordinates) and the faces from a .ply file
+ * (binary little endian, binary big endian or ascii). The file is mapped in memory and read in a single pass
+ * into arrays allocated from the number of elements given in the header. Polygons with more than 3 vertices
+ * are split in a fan of triangles around their first vertex. The normals are computed if the file does not contain them.
+ * Returns true if the mesh was read.
+ * @brief plyReader
+ * @param fileName
+ * @return
+ */
+bool Mesh::plyReader(string fileName)
+{
+    m_cache.reset();
+    m_compressedMesh.reset();
+    m_vertices.clear();
+    m_indices.clear();
+    m_indicesArray.clear();
+    m_vertexNormals.clear();
+    m_textureCoordinates.clear();
+    m_vertexTangents.clear();
+
+    size_t fileSize = 0;
+    const char* file = (const char*) mapFile(fileName, fileSize);
+
+    if(file == NULL)
+    {
+        cerr << "Could not open the file : " << fileName << endl;
+        return false;
+    }
+
+    const char* end = file + fileSize;
+    const char* p = file;
+
+    //Header : one keyword per line until end_header
+    vector<PLYElement> elements;
+    PLYFormat format = PLY_ASCII;
+    bool validHeader = (fileSize >= 3 && memcmp(file, "ply", 3) == 0);
+    bool endOfHeader = false;
+
+    while(validHeader && !endOfHeader && p < end)
+    {
+        const char* lineEnd = (const char*) memchr(p, '\n', end-p);
+        lineEnd = (lineEnd == NULL) ? end : lineEnd;
+
+        istringstream line(string(p, lineEnd));
+        p = (lineEnd == end) ? end : lineEnd+1;
+
+        string keyword;
+        line >> keyword;
+
+        if(keyword == "format")
+        {
+            string formatName;
+            line >> formatName;
+
+            if(formatName == "binary_little_endian")
+                format = PLY_BINARY_LITTLE_ENDIAN;
+            else if(formatName == "binary_big_endian")
+                format = PLY_BINARY_BIG_ENDIAN;
+            else if(formatName == "ascii")
+                format = PLY_ASCII;
+            else
+                validHeader = false;
+        }
+        else if(keyword == "element")
+        {
+            PLYElement element;
+            element.count = -1;
+            line >> element.name >> element.count;
+            validHeader = (element.count >= 0);
+            elements.push_back(element);
+        }
+        else if(keyword == "property" && !elements.empty())
+        {
+            PLYProperty property;
+            string type;
+            line >> type;
+            property.isList = (type == "list");
+
+            if(property.isList)
+            {
+                string countType;
+                line >> countType >> type;
+                property.countType = plyType(countType);
+                validHeader = (property.countType != PLY_INVALID && property.countType != PLY_FLOAT32 && property.countType != PLY_FLOAT64);
+            }
+            else
+            {
+                property.countType = PLY_INVALID;
+            }
+
+            property.type = plyType(type);
+            line >> property.name;
+            validHeader = validHeader && (property.type != PLY_INVALID);
+            elements.back().properties.push_back(property);
+        }
+        else if(keyword == "end_header")
+        {
+            endOfHeader = true;
+        }
+        else if(keyword != "ply" && keyword != "comment" && keyword != "obj_info" && !keyword.empty())
+        {
+            validHeader = false;
+        }
+    }
+
+    if(!validHeader || !endOfHeader)
+    {
+        cerr << "The file is not a valid PLY file : " << fileName << endl;
+        unmapFile((void*) file, fileSize);
+        return false;
+    }
+
+    vector<GLuint> triangles;
+    vector<double> polygon;
+    bool hasNormals = false;
+    bool hasTextureCoordinates = false;
+    bool valid = true;
+
+    for(unsigned int e = 0 ; e<elements.size() && valid ; e++)
+    {
+        const PLYElement& element = elements[e];
+        const bool isVertex = (element.name == "vertex");
+        const bool isFace = (element.name == "face");
+
+        //Attribute written by each property of the vertices : x, y, z, nx, ny, nz, u, v (-1 if the property is not used)
+        vector<int> attribute(element.properties.size(), -1);
+        int faceIndicesProperty = -1;
+
+        for(unsigned int k = 0 ; k<element.properties.size() ; k++)
+        {
+            const string& name = element.properties[k].name;
+
+            if(isVertex && !element.properties[k].isList)
+            {
+                if(name == "x") attribute[k] = 0;
+                else if(name == "y") attribute[k] = 1;
+                else if(name == "z") attribute[k] = 2;
+                else if(name == "nx") attribute[k] = 3;
+                else if(name == "ny") attribute[k] = 4;
+                else if(name == "nz") attribute[k] = 5;
+                else if(name == "u" || name == "s" || name == "texture_u" || name == "texture_s") attribute[k] = 6;
+                else if(name == "v" || name == "t" || name == "texture_v" || name == "texture_t") attribute[k] = 7;
+
+                hasNormals = hasNormals || attribute[k] == 3;
+                hasTextureCoordinates = hasTextureCoordinates || attribute[k] == 6;
+            }
+            else if(isFace && element.properties[k].isList && (name == "vertex_indices" || name == "vertex_index"))
+            {
+                faceIndicesProperty = k;
+            }
+        }
+
+        if(isVertex)
+        {
+            m_vertices.resize((int) element.count);
+
+            if(hasNormals)
+                m_vertexNormals.resize((int) element.count);
+
+            if(hasTextureCoordinates)
+                m_textureCoordinates.resize((int) element.count);
+        }
+
+        if(isFace)
+        {
+            triangles.reserve(3*element.count);
+        }
+
+        for(long long i = 0 ; i<element.count && valid ; i++)
+        {
+            double values[8] = {0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0};
+
+            for(unsigned int k = 0 ; k<element.properties.size() && valid ; k++)
+            {
+                const PLYProperty& property = element.properties[k];
+
+                if(!property.isList)
+                {
+                    double value = 0.0;
+                    valid = readPLYValue(p, end, property.type, format, value);
+
+                    if(attribute[k] >= 0)
+                        values[attribute[k]] = value;
+
+                    continue;
+                }
+
+                double count = 0.0;
+                valid = readPLYValue(p, end, property.countType, format, count);
+
+                polygon.resize(valid ? (size_t) max(count, 0.0) : 0);
+
+                for(size_t j = 0 ; j<polygon.size() && valid ; j++)
+                {
+                    valid = readPLYValue(p, end, property.type, format, polygon[j]);
+                }
+
+                if((int) k == faceIndicesProperty && valid)
+                {
+                    for(size_t j = 0 ; j<polygon.size() ; j++)
+                    {
+                        valid = valid && polygon[j] >= 0.0 && polygon[j] < (double) m_vertices.size();
+                    }
+
+                    for(size_t j = 1 ; j+1<polygon.size() && valid ; j++)
+                    {
+                        triangles.push_back((GLuint) polygon[0]);
+                        triangles.push_back((GLuint) polygon[j]);
+                        triangles.push_back((GLuint) polygon[j+1]);
+                    }
+                }
+            }
+
+            if(isVertex && valid)
+            {
+                m_vertices[(int) i] = QVector3D(values[0], values[1], values[2]);
+
+                if(hasNormals)
+                    m_vertexNormals[(int) i] = QVector3D(values[3], values[4], values[5]).normalized();
+
+                if(hasTextureCoordinates)
+                    m_textureCoordinates[(int) i] = QVector2D(values[6], values[7]);
+            }
+        }
+    }
+
+    unmapFile((void*) file, fileSize);
+
+    if(!valid)
+    {
+        cerr << "The PLY file is truncated or contains invalid indices : " << fileName << endl;
+        m_vertices.clear();
+        m_vertexNormals.clear();
+        m_textureCoordinates.clear();
+        return false;
+    }
+
+    setTriangles(triangles);
+
+    if(!hasNormals)
+    {
+        computeNormals();
+    }
+
+    return !m_vertices.isEmpty();
+}
+
+/**
+ * Reads the vertices (positions, texture coordinates and normals) and the faces from a .obj file.
+ * A first pass over the mapped file counts the elements so that every array is allocated once.
+ * Corners of the faces that use the same position, texture coordinate and normal are merged in one vertex with a hash table.
+ * Polygons with more than 3 vertices are split in a fan of triangles around their first vertex.
+ * The normals are computed if some corners of the faces do not have one.
+ * Returns true if the mesh was read.
+ * @brief objReader
+ * @param fileName
+ * @return
+ */
+bool Mesh::objReader(string fileName)
+{
+    m_cache.reset();
+    m_compressedMesh.reset();
+    m_vertices.clear();
+    m_indices.clear();
+    m_indicesArray.clear();
+    m_vertexNormals.clear();
+    m_textureCoordinates.clear();
+    m_vertexTangents.clear();
+
+    size_t fileSize = 0;
+    const char* file = (const char*) mapFile(fileName, fileSize);
+
+    if(file == NULL)
+    {
+        cerr << "Could not open the file : " << fileName << endl;
+        return false;
+    }
+
+    const char* end = file + fileSize;
+
+    //First pass : number of positions, texture coordinates, normals and triangles
+    long long numberOfPositions = 0;
+    long long numberOfTextureCoordinates = 0;
+    long long numberOfNormals = 0;
+    long long numberOfTriangles = 0;
+
+    for(const char* p = file ; p < end ; p = nextLine(p, end))
+    {
+        skipSpaces(p, end);
+
+        if(isOBJKeyword(p, end, "v", 1))
+        {
+            numberOfPositions++;
+        }
+        else if(isOBJKeyword(p, end, "vt", 2))
+        {
+            numberOfTextureCoordinates++;
+        }
+        else if(isOBJKeyword(p, end, "vn", 2))
+        {
+            numberOfNormals++;
+        }
+        else if(isOBJKeyword(p, end, "f", 1))
+        {
+            int numberOfCorners = 0;
+            p++;
+            skipSpaces(p, end);
+
+            while(p < end && *p != '\n' && *p != '#')
+            {
+                while(p < end && *p != ' ' && *p != '\t' && *p != '\r' && *p != '\n')
+                    p++;
+
+                numberOfCorners++;
+                skipSpaces(p, end);
+            }
+
+            numberOfTriangles += max(numberOfCorners-2, 0);
+        }
+    }
+
+    //Second pass : the elements are written at their index
+    vector<QVector3D> positions((size_t) numberOfPositions);
+    vector<QVector2D> textureCoordinates((size_t) numberOfTextureCoordinates);
+    vector<QVector3D> normals((size_t) numberOfNormals);
+    vector<OBJCorner> corners((size_t) (3*numberOfTriangles));
+    vector<OBJCorner> polygon;
+
+    long long position = 0;
+    long long textureCoordinate = 0;
+    long long normal = 0;
+    size_t numberOfCorners = 0;
+    long long numberOfErrors = 0;
+
+    for(const char* p = file ; p < end ; p = nextLine(p, end))
+    {
+        skipSpaces(p, end);
+
+        if(isOBJKeyword(p, end, "v", 1))
+        {
+            float x = 0.0f, y = 0.0f, z = 0.0f;
+            p++;
+
+            if(!(parseFloat(p, end, x) && parseFloat(p, end, y) && parseFloat(p, end, z)))
+                numberOfErrors++;
+
+            positions[position++] = QVector3D(x, y, z);
+        }
+        else if(isOBJKeyword(p, end, "vt", 2))
+        {
+            float u = 0.0f, v = 0.0f;
+            p += 2;
+
+            if(!parseFloat(p, end, u))
+                numberOfErrors++;
+
+            parseFloat(p, end, v);
+            textureCoordinates[textureCoordinate++] = QVector2D(u, v);
+        }
+        else if(isOBJKeyword(p, end, "vn", 2))
+        {
+            float x = 0.0f, y = 0.0f, z = 0.0f;
+            p += 2;
+
+            if(!(parseFloat(p, end, x) && parseFloat(p, end, y) && parseFloat(p, end, z)))
+                numberOfErrors++;
+
+            normals[normal++] = QVector3D(x, y, z).normalized();
+        }
+        else if(isOBJKeyword(p, end, "f", 1))
+        {
+            //Corners v, v/vt, v//vn or v/vt/vn
+            bool validFace = true;
+            polygon.clear();
+            p++;
+            skipSpaces(p, end);
+
+            while(p < end && *p != '\n' && *p != '#')
+            {
+                OBJCorner corner = {-1, -1, -1};
+                long long index = parseOBJIndex(p, end, position);
+                validFace = validFace && index >= 0 && index < position;
+                corner.position = (int) index;
+
+                if(p < end && *p == '/')
+                {
+                    p++;
+
+                    if(p < end && *p != '/')
+                    {
+                        index = parseOBJIndex(p, end, textureCoordinate);
+                        validFace = validFace && index >= 0 && index < textureCoordinate;
+                        corner.textureCoordinate = (int) index;
+                    }
+
+                    if(p < end && *p == '/')
+                    {
+                        p++;
+                        index = parseOBJIndex(p, end, normal);
+                        validFace = validFace && index >= 0 && index < normal;
+                        corner.normal = (int) index;
+                    }
+                }
+
+                validFace = validFace && (p == end || *p == ' ' || *p == '\t' || *p == '\r' || *p == '\n');
+
+                while(p < end && *p != ' ' && *p != '\t' && *p != '\r' && *p != '\n')
+                    p++;
+
+                polygon.push_back(corner);
+                skipSpaces(p, end);
+            }
+
+            if(!validFace)
+            {
+                numberOfErrors++;
+                continue;
+            }
+
+            for(size_t k = 1 ; k+1<polygon.size() ; k++)
+            {
+                corners[numberOfCorners++] = polygon[0];
+                corners[numberOfCorners++] = polygon[k];
+                corners[numberOfCorners++] = polygon[k+1];
+            }
+        }
+    }
+
+    unmapFile((void*) file, fileSize);
+
+    if(numberOfErrors > 0)
+    {
+        cerr << "The OBJ file contains " << numberOfErrors << " invalid lines : " << fileName << endl;
+    }
+
+    //Vertices : one per distinct corner
+    bool hasTextureCoordinates = false;
+    bool hasNormals = (numberOfCorners > 0);
+
+    for(size_t k = 0 ; k<numberOfCorners ; k++)
+    {
+        hasTextureCoordinates = hasTextureCoordinates || corners[k].textureCoordinate >= 0;
+        hasNormals = hasNormals && corners[k].normal >= 0;
+    }
+
+    vector<GLuint> triangles(numberOfCorners);
+    size_t numberOfVertices = 0;
+
+    if(!hasTextureCoordinates && !hasNormals)
+    {
+        //The vertices are the positions
+        for(size_t k = 0 ; k<numberOfCorners ; k++)
+        {
+            triangles[k] = corners[k].position;
+        }
+
+        m_vertices.resize((int) positions.size());
+        copy(positions.begin(), positions.end(), m_vertices.begin());
+    }
+    else
+    {
+        //The first occurrence of each corner is moved to the front of the array of corners
+        unordered_map<OBJCorner, GLuint, OBJCornerHash> vertexIndices;
+        vertexIndices.reserve(numberOfCorners);
+
+        for(size_t k = 0 ; k<numberOfCorners ; k++)
+        {
+            const OBJCorner corner = corners[k];
+            pair<unordered_map<OBJCorner, GLuint, OBJCornerHash>::iterator, bool> inserted = vertexIndices.insert(make_pair(corner, (GLuint) numberOfVertices));
+
+            if(inserted.second)
+            {
+                corners[numberOfVertices++] = corner;
+            }
+
+            triangles[k] = inserted.first->second;
+        }
+
+        m_vertices.resize((int) numberOfVertices);
+        m_textureCoordinates.resize((int) numberOfVertices);
+
+        if(hasNormals)
+            m_vertexNormals.resize((int) numberOfVertices);
+
+        for(size_t k = 0 ; k<numberOfVertices ; k++)
+        {
+            m_vertices[(int) k] = positions[corners[k].position];
+
+            if(corners[k].textureCoordinate >= 0)
+                m_textureCoordinates[(int) k] = textureCoordinates[corners[k].textureCoordinate];
+
+            if(hasNormals)
+                m_vertexNormals[(int) k] = normals[corners[k].normal];
+        }
+    }
+
+    setTriangles(triangles);
+
+    if(!hasNormals)
+    {
+        computeNormals();
+    }
+
+    return !m_vertices.isEmpty();
+}
+
+/**
+ * Reads a mesh file. The format is given by the extension of the file : .ply, .obj or .off (default).
+ * Vertices without texture coordinates are given the texture coordinate (0,0).
+ * The cache file next to the mesh file (MESH_CACHE_EXTENSION) is mapped instead if it was generated from the current mesh file,
+ * otherwise it is written after the mesh file is read, its tangents are computed (see computeTangents) and its triangles are reordered (see optimizeIndices).
+ * The average cache miss ratio (ACMR) before and after the reordering is printed.
+ * Returns true if the mesh was read.
+ * @brief readFile
+ * @param fileName
+ * @return
+ */
+bool Mesh::readFile(string fileName)
+{
+    const string cacheFileName = fileName + string(MESH_CACHE_EXTENSION);
+
+    if(readCache(cacheFileName, fileName))
+    {
+        return true;
+    }
+
+    string extension = fileName.substr(fileName.find_last_of('.') == string::npos ? fileName.size() : fileName.find_last_of('.')+1);
+    transform(extension.begin(), extension.end(), extension.begin(), ::tolower);
+
+    bool loaded = false;
+
+    if(extension == "ply")
+    {
+        loaded = plyReader(fileName);
+    }
+    else if(extension == "obj")
+    {
+        loaded = objReader(fileName);
+    }
+    else
+    {
+        offReader(fileName);
+        loaded = !m_vertices.isEmpty();
+    }
+
+    //The texture coordinates of the .off files are set by loadPathAndTextureCoordinates
+    m_textureCoordinates.resize(m_vertices.size());
+
+    if(loaded)
+    {
+        //The vertices split by the tangents are reordered with the others
+        computeTangents();
+
+        const float ratio = getAverageCacheMissRatio();
+        optimizeIndices();
+        cout << "Triangles of " << fileName << " reordered : ACMR " << ratio << " -> " << getAverageCacheMissRatio() << endl;
+
+        writeCache(cacheFileName, fileName);
+    }
+
+    return loaded;
+}
+
+/**
+ * Reorders the triangles for the post transform vertex cache then for overdraw, and numbers the vertices
+ * in the order they are first used by the triangles so that they are fetched from memory in order.
+ * @brief optimizeIndices
+ */
+void Mesh::optimizeIndices()
+{
+    detachCache();
+    m_compressedMesh.reset();
+
+    const size_t numberOfIndices = m_indicesArray.size();
+    const size_t numberOfVertices = m_vertices.size();
+
+    if(numberOfIndices < 3)
+        return;
+
+    //Triangles
+    vector<GLuint> triangles(numberOfIndices);
+    optimizeVertexCache(m_indicesArray.constData(), numberOfIndices, numberOfVertices, &triangles[0]);
+    optimizeOverdraw(&triangles[0], numberOfIndices, m_vertices.constData(), numberOfVertices, MESH_OVERDRAW_THRESHOLD);
+
+    //Vertices in the order of their first use (unused vertices at the end)
+    vector<GLuint> newIndex(numberOfVertices, UINT_MAX);
+    GLuint numberOfUsedVertices = 0;
+
+    for(size_t k = 0 ; k<numberOfIndices ; k++)
+    {
+        if(newIndex[triangles[k]] == UINT_MAX)
+            newIndex[triangles[k]] = numberOfUsedVertices++;
+
+        triangles[k] = newIndex[triangles[k]];
+    }
+
+    for(size_t v = 0 ; v<numberOfVertices ; v++)
+    {
+        if(newIndex[v] == UINT_MAX)
+            newIndex[v] = numberOfUsedVertices++;
+    }
+
+    QVector<QVector3D> vertices(numberOfVertices);
+    QVector<QVector3D> vertexNormals(m_vertexNormals.size() == (int) numberOfVertices ? numberOfVertices : 0);
+    QVector<QVector2D> textureCoordinates(m_textureCoordinates.size() == (int) numberOfVertices ? numberOfVertices : 0);
+    QVector<QVector4D> vertexTangents(m_vertexTangents.size() == (int) numberOfVertices ? numberOfVertices : 0);
+
+    for(size_t v = 0 ; v<numberOfVertices ; v++)
+    {
+        vertices[newIndex[v]] = m_vertices[v];
+
+        if(!vertexNormals.isEmpty())
+            vertexNormals[newIndex[v]] = m_vertexNormals[v];
+
+        if(!textureCoordinates.isEmpty())
+            textureCoordinates[newIndex[v]] = m_textureCoordinates[v];
+
+        if(!vertexTangents.isEmpty())
+            vertexTangents[newIndex[v]] = m_vertexTangents[v];
+    }
+
+    m_vertices = vertices;
+    m_vertexNormals = vertexNormals.isEmpty() ? m_vertexNormals : vertexNormals;
+    m_textureCoordinates = textureCoordinates.isEmpty() ? m_textureCoordinates : textureCoordinates;
+    m_vertexTangents = vertexTangents.isEmpty() ? m_vertexTangents : vertexTangents;
+    m_triangleNormals.clear();
+    setTriangles(triangles);
+}
+
+/**
+ * Returns a simplified copy of the mesh with at most targetNumberOfTriangles triangles, or as close as the edges that can be collapsed allow.
+ * The vertices that remain keep their positions, normals, texture coordinates and tangents, and the unused vertices are removed.
+ * @brief simplify
+ * @param targetNumberOfTriangles
+ * @return
+ */
+Mesh Mesh::simplify(int targetNumberOfTriangles) const
+{
+    if(m_compressedMesh)
+    {
+        Mesh decoded = *this;
+        decoded.detachCache();
+        return decoded.simplify(targetNumberOfTriangles);
+    }
+
+    const int numberOfVertices = getNumberOfVertices();
+    const bool hasNormals = cacheHeader() || m_vertexNormals.size() == numberOfVertices;
+    const bool hasTextureCoordinates = cacheHeader() || m_textureCoordinates.size() == numberOfVertices;
+
+    const QVector3D* vertices = getVertexData();
+    const QVector3D* vertexNormals = getVertexNormalData();
+    const QVector2D* textureCoordinates = getTextureCoordinateData();
+    const QVector4D* vertexTangents = getVertexTangentData();
+
+    vector<GLuint> triangles = simplifyMesh(vertices, numberOfVertices, getIndexData(), getNumberOfIndices(), targetNumberOfTriangles);
+
+    //Vertices used by the remaining triangles
+    vector<GLuint> newIndex(numberOfVertices, UINT_MAX);
+    Mesh simplified;
+
+    for(size_t k = 0 ; k<triangles.size() ; k++)
+    {
+        const GLuint v = triangles[k];
+
+        if(newIndex[v] == UINT_MAX)
+        {
+            newIndex[v] = (GLuint) simplified.m_vertices.size();
+            simplified.m_vertices.push_back(vertices[v]);
+
+            if(hasNormals)
+                simplified.m_vertexNormals.push_back(vertexNormals[v]);
+
+            if(hasTextureCoordinates)
+                simplified.m_textureCoordinates.push_back(textureCoordinates[v]);
+
+            if(vertexTangents)
+                simplified.m_vertexTangents.push_back(vertexTangents[v]);
+        }
+
+        triangles[k] = newIndex[v];
+    }
+
+    simplified.setTriangles(triangles);
+
+    if(!hasNormals)
+        simplified.computeNormals();
+
+    if(!vertexTangents)
+        simplified.computeTangents();
+
+    return simplified;
+}
+
+/**
+ * Replaces the arrays of the mesh by a compressed copy for the compact vertex format (see CompressedMesh).
+ * The float arrays (or the mapping of the cache file) are released : the pointers to the arrays are NULL and the
+ * arrays returned by the other functions are decoded. The mesh is decoded back to floats before it is modified.
+ * @brief compress
+ */
+void Mesh::compress()
+{
+    if(m_compressedMesh)
+        return;
+
+    const int numberOfVertices = getNumberOfVertices();
+    const bool hasNormals = cacheHeader() || m_vertexNormals.size() == numberOfVertices;
+    const bool hasTextureCoordinates = cacheHeader() || m_textureCoordinates.size() == numberOfVertices;
+
+    m_compressedMesh = make_shared<const CompressedMesh>(getVertexData(), hasNormals ? getVertexNormalData() : NULL,
+                                                         hasTextureCoordinates ? getTextureCoordinateData() : NULL, getVertexTangentData(), numberOfVertices,
+                                                         getIndexData(), getNumberOfIndices());
+
+    //The arrays shared with the copies of the mesh are only released with the last copy
+    m_vertices.clear();
+    m_indices.clear();
+    m_indicesArray.clear();
+    m_triangleNormals.clear();
+    m_vertexNormals.clear();
+    m_textureCoordinates.clear();
+    m_vertexTangents.clear();
+    m_cache.reset();
+}
+
 /**
- * Default Mesh constructor.
- * @brief Mesh
+ * Returns the compressed copy of the mesh, or NULL if the mesh is not compressed.
+ * @brief getCompressedMesh
+ * @return
  */
-Mesh::Mesh():m_vertices(QVector<QVector3D>()), m_indices(QVector<QVector3D>()),
-             m_indicesArray(QVector<GLuint>()), m_triangleNormals( QVector<QVector3D>()), m_vertexNormals( QVector<QVector3D>()),
-             m_textureCoordinates(QVector<QVector2D>())
+const CompressedMesh* Mesh::getCompressedMesh() const
+{
+    return m_compressedMesh.get();
+}
+
+/**
+ * Returns the average cache miss ratio (ACMR) of the triangles : the number of vertices transformed per triangle (between 0.5 and 3)
+ * with a FIFO post transform cache of cacheSize vertices.
+ * @brief getAverageCacheMissRatio
+ * @param cacheSize
+ * @return
+ */
+float Mesh::getAverageCacheMissRatio(int cacheSize) const
 {
+    if(m_compressedMesh)
+    {
+        const QVector<GLuint> indices = decodeIndices(*m_compressedMesh);
+        return averageCacheMissRatio(indices.constData(), indices.size(), getNumberOfVertices(), cacheSize);
+    }
 
+    return averageCacheMissRatio(getIndexData(), getNumberOfIndices(), getNumberOfVertices(), cacheSize);
 }
 
 /**
- * Loads a Mesh given its name.
- * @brief Mesh
- * @param objectName
+ * Writes the mesh in a cache file that can be mapped in memory by readCache.
+ * The size and the modification date of the mesh file sourceFileName are stored to detect when the cache is outdated.
+ * The file is written under another name then renamed : a cache file is either complete or missing.
+ * Returns true if the file was written.
+ * @brief writeCache
+ * @param cacheFileName
+ * @param sourceFileName
+ * @return
  */
-Mesh::Mesh(const string& objectName):m_vertices(QVector<QVector3D>()), m_indices(QVector<QVector3D>()),
-                            m_indicesArray(QVector<GLuint>()), m_triangleNormals( QVector<QVector3D>()), m_vertexNormals( QVector<QVector3D>()),
-                            m_textureCoordinates(QVector<QVector2D>())
+bool Mesh::writeCache(string cacheFileName, string sourceFileName) const
 {
-    string fileName = loadPathAndTextureCoordinates(objectName);
-    offReader(fileName);
+    if(m_compressedMesh)
+    {
+        Mesh decoded = *this;
+        decoded.detachCache();
+        return decoded.writeCache(cacheFileName, sourceFileName);
+    }
+
+    const int numberOfVertices = getNumberOfVertices();
+    const int numberOfIndices = getNumberOfIndices();
+
+    if(!cacheHeader() && (m_vertexNormals.size() != numberOfVertices || m_textureCoordinates.size() != numberOfVertices || m_vertexTangents.size() != numberOfVertices))
+    {
+        cerr << "The mesh must have a normal, a texture coordinate and a tangent per vertex to be cached." << endl;
+        return false;
+    }
+
+    MeshCacheHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, "R3DMESH", 8);
+    header.version = MESH_CACHE_VERSION;
+    header.byteOrderMark = MESH_CACHE_BYTE_ORDER_MARK;
+    header.numberOfVertices = (uint32_t) numberOfVertices;
+    header.numberOfIndices = (uint32_t) numberOfIndices;
+
+    if(!fileStatus(sourceFileName, header.sourceSize, header.sourceModificationTime))
+    {
+        return false;
+    }
+
+    QVector3D minimum, maximum;
+    getBoundingBox(minimum, maximum);
+
+    for(int k = 0 ; k<3 ; k++)
+    {
+        header.boundingBoxMinimum[k] = minimum[k];
+        header.boundingBoxMaximum[k] = maximum[k];
+    }
+
+    //Arrays aligned on MESH_CACHE_ALIGNMENT bytes
+    const void* arrays[5] = {getVertexData(), getVertexNormalData(), getTextureCoordinateData(), getVertexTangentData(), getIndexData()};
+    const uint64_t sizes[5] = {numberOfVertices*sizeof(QVector3D), numberOfVertices*sizeof(QVector3D), numberOfVertices*sizeof(QVector2D),
+                               numberOfVertices*sizeof(QVector4D), numberOfIndices*sizeof(GLuint)};
+    uint64_t* offsets[5] = {&header.verticesOffset, &header.normalsOffset, &header.textureCoordinatesOffset, &header.tangentsOffset, &header.indicesOffset};
+    uint64_t offset = sizeof(MeshCacheHeader);
+
+    for(int k = 0 ; k<5 ; k++)
+    {
+        offset = (offset+MESH_CACHE_ALIGNMENT-1)/MESH_CACHE_ALIGNMENT*MESH_CACHE_ALIGNMENT;
+        *offsets[k] = offset;
+        offset += sizes[k];
+    }
+
+    header.fileSize = (offset+MESH_CACHE_ALIGNMENT-1)/MESH_CACHE_ALIGNMENT*MESH_CACHE_ALIGNMENT;
+
+    vector<char> data((size_t) header.fileSize, 0);
+
+    for(int k = 0 ; k<5 ; k++)
+    {
+        if(sizes[k] > 0)
+            memcpy(&data[(size_t) *offsets[k]], arrays[k], (size_t) sizes[k]);
+    }
+
+    header.dataChecksum = hashData(&data[0]+sizeof(MeshCacheHeader), data.size()-sizeof(MeshCacheHeader));
+    header.headerChecksum = hashData(&header, offsetof(MeshCacheHeader, headerChecksum));
+    memcpy(&data[0], &header, sizeof(header));
+
+    string temporaryFileName = cacheFileName + string(".tmp");
+    ofstream file(temporaryFileName.c_str(), ios::out | ios::binary | ios::trunc);
+
+    if(!file)
+    {
+        cerr << "Could not write the mesh cache file : " << temporaryFileName << endl;
+        return false;
+    }
+
+    file.write(&data[0], data.size());
+    file.close();
+
+    if(!file)
+    {
+        cerr << "Could not write the mesh cache file : " << temporaryFileName << endl;
+        remove(temporaryFileName.c_str());
+        return false;
+    }
+
+    remove(cacheFileName.c_str());
+
+    if(rename(temporaryFileName.c_str(), cacheFileName.c_str()) != 0)
+    {
+        cerr << "Could not write the mesh cache file : " << cacheFileName << endl;
+        remove(temporaryFileName.c_str());
+        return false;
+    }
+
+    return true;
 }
 
 /**
- * Reads the triangles from a .off file.
- * @brief offReader
- * @param fileName
+ * Maps a cache file written by writeCache in memory. The arrays are used directly from the mapping (without any copy),
+ * so the time to read the mesh does not depend on its size and the pages are read from the disk when they are first used.
+ * Returns false if the file is not a valid cache file of the current version or if the mesh file sourceFileName changed.
+ * The hash of the arrays is only checked if verifyData is true, as it reads the whole file. Otherwise the indices are checked
+ * to be smaller than the number of vertices, so a corrupted index block cannot make OpenGL read outside of the arrays.
+ * @brief readCache
+ * @param cacheFileName
+ * @param sourceFileName
+ * @param verifyData
+ * @return
  */
-void Mesh::offReader(string fileName)
+bool Mesh::readCache(string cacheFileName, string sourceFileName, bool verifyData)
 {
-    ifstream file(fileName.c_str(), ios::in);
+    uint64_t sourceSize = 0;
+    int64_t sourceModificationTime = 0;
+
+    if(!fileStatus(sourceFileName, sourceSize, sourceModificationTime))
+    {
+        return false;
+    }
+
+    size_t mappingSize = 0;
+    const char* mapping = (const char*) mapFile(cacheFileName, mappingSize);
+
+    if(mapping == NULL)
+    {
+        return false;
+    }
+
+    const MeshCacheHeader* header = (const MeshCacheHeader*) mapping;
+
+    bool valid = mappingSize >= sizeof(MeshCacheHeader)
+            && memcmp(header->magic, "R3DMESH", 8) == 0
+            && header->version == MESH_CACHE_VERSION
+            && header->byteOrderMark == MESH_CACHE_BYTE_ORDER_MARK
+            && header->headerChecksum == hashData(header, offsetof(MeshCacheHeader, headerChecksum))
+            && header->fileSize == mappingSize
+            && header->sourceSize == sourceSize
+            && header->sourceModificationTime == sourceModificationTime
+            && header->numberOfVertices <= INT_MAX/sizeof(QVector4D)
+            && header->numberOfIndices <= INT_MAX/sizeof(GLuint)
+            && header->numberOfIndices%3 == 0;
+
+    //Each array must be in the file
+    const uint64_t offsets[5] = {header->verticesOffset, header->normalsOffset, header->textureCoordinatesOffset, header->tangentsOffset, header->indicesOffset};
+    const uint64_t sizes[5] = {header->numberOfVertices*sizeof(QVector3D), header->numberOfVertices*sizeof(QVector3D),
+                               header->numberOfVertices*sizeof(QVector2D), header->numberOfVertices*sizeof(QVector4D), header->numberOfIndices*sizeof(GLuint)};
+
+    for(int k = 0 ; k<5 && valid ; k++)
+    {
+        valid = offsets[k] >= sizeof(MeshCacheHeader) && offsets[k]%MESH_CACHE_ALIGNMENT == 0 && offsets[k] <= mappingSize && sizes[k] <= mappingSize-offsets[k];
+    }
+
+    if(valid && verifyData)
+    {
+        valid = (header->dataChecksum == hashData(mapping+sizeof(MeshCacheHeader), mappingSize-sizeof(MeshCacheHeader)));
+    }
+    else if(valid)
+    {
+        //Only the index block is read (the hash covers it when verifyData is true)
+        const GLuint* indices = (const GLuint*) (mapping+header->indicesOffset);
 
-    string fileType;
-    string numberOfVertices, numberOfTriangles, numberOfEdges;
-    string data;
-    string xVertex, yVertex, zVertex;
-    string vertex1, vertex2, vertex3;
-    int index1 = 0, index2 = 0, index3 = 0;
-    string numberOfIndices;
+        for(uint64_t k = 0 ; k<header->numberOfIndices && valid ; k++)
+        {
+            valid = indices[k] < header->numberOfVertices;
+        }
+    }
+
+    if(!valid)
+    {
+        unmapFile((void*) mapping, mappingSize);
+        return false;
+    }
 
-    file >> fileType;
-    //Add and exception
+    m_vertices.clear();
+    m_indices.clear();
+    m_indicesArray.clear();
+    m_triangleNormals.clear();
+    m_vertexNormals.clear();
+    m_textureCoordinates.clear();
+    m_vertexTangents.clear();
 
+    //The mapping is released with the last copy of the mesh
+    m_cache = shared_ptr<const char>(mapping, [mappingSize](const char* cache) { unmapFile((void*) cache, mappingSize); });
+    m_compressedMesh.reset();
 
-    file >> numberOfVertices >> numberOfTriangles >> numberOfEdges;
-    m_vertices.resize(atoi(numberOfVertices.c_str()));
-    m_indices.resize(atoi(numberOfTriangles.c_str()));
+    return true;
+}
 
-    //Blank line
-    getline(file, data);
+/**
+ * Returns the minimum and the maximum of the coordinates of the vertices.
+ * @brief getBoundingBox
+ * @param minimum
+ * @param maximum
+ */
+void Mesh::getBoundingBox(QVector3D& minimum, QVector3D& maximum) const
+{
+    const MeshCacheHeader* header = cacheHeader();
 
-     //Vertices
-    for(int i = 0 ; i< atoi(numberOfVertices.c_str()) ; i++)
+    if(header)
     {
-        file >> xVertex >> yVertex >>zVertex;
-        m_vertices[i] = QVector3D(atof(xVertex.c_str()),atof(yVertex.c_str()),atof(zVertex.c_str()));
+        minimum = QVector3D(header->boundingBoxMinimum[0], header->boundingBoxMinimum[1], header->boundingBoxMinimum[2]);
+        maximum = QVector3D(header->boundingBoxMaximum[0], header->boundingBoxMaximum[1], header->boundingBoxMaximum[2]);
+        return;
     }
 
-    //Indices and normals for each triangle
-    QVector3D crossProduct;
-    for(int i = 0 ; i< atoi(numberOfTriangles.c_str()) ; i++)
+    //The positions are quantized in the bounding box
+    if(m_compressedMesh)
     {
-         file >> numberOfIndices >> vertex1 >> vertex2 >> vertex3;
-         index1 = atoi(vertex1.c_str());
-         index2 = atoi(vertex2.c_str());
-         index3 = atoi(vertex3.c_str());
+        minimum = m_compressedMesh->getPositionOffset();
+        maximum = minimum+m_compressedMesh->getPositionExtent();
+        return;
+    }
+
+    minimum = m_vertices.isEmpty() ? QVector3D() : m_vertices[0];
+    maximum = minimum;
 
-         //Indices for each triangle
-         m_indices[i] = QVector3D(index1, index2, index3);
+    for(int k = 1 ; k<m_vertices.size() ; k++)
+    {
+        minimum = QVector3D(min(minimum.x(), m_vertices[k].x()), min(minimum.y(), m_vertices[k].y()), min(minimum.z(), m_vertices[k].z()));
+        maximum = QVector3D(max(maximum.x(), m_vertices[k].x()), max(maximum.y(), m_vertices[k].y()), max(maximum.z(), m_vertices[k].z()));
+    }
+}
 
-         //List of indices for OpenGL rendering
-         m_indicesArray.push_back(index1);
-         m_indicesArray.push_back(index2);
-         m_indicesArray.push_back(index3);
+/**
+ * Sets the triangles of the mesh from a list of indices where each consecutive triplet is a triangle.
+ * @brief setTriangles
+ * @param triangles
+ */
+void Mesh::setTriangles(const vector<GLuint>& triangles)
+{
+    m_indicesArray.resize((int) triangles.size());
+    m_indices.resize((int) triangles.size()/3);
 
-         //Compute the normal NORMALIZED
-         /*   v3
-          * v1__v2
-          * normal = (v2-v1)^(v3-v1)
-          */
-         crossProduct = QVector3D::crossProduct(m_vertices[index1]-m_vertices[index2],m_vertices[index1]-m_vertices[index3]);
-         crossProduct.normalize();
-         m_triangleNormals.push_back(crossProduct);
+    for(size_t k = 0 ; k+2<triangles.size() ; k += 3)
+    {
+        m_indicesArray[(int) k] = triangles[k];
+        m_indicesArray[(int) k+1] = triangles[k+1];
+        m_indicesArray[(int) k+2] = triangles[k+2];
+        m_indices[(int) k/3] = QVector3D(triangles[k], triangles[k+1], triangles[k+2]);
     }
+}
+
+/**
+ * Copies the arrays of the cache file (or decodes the arrays of the compressed copy) in the QVectors of the mesh
+ * and releases the mapping, before the mesh is modified.
+ * @brief detachCache
+ */
+void Mesh::detachCache()
+{
+    if(!cacheHeader() && !m_compressedMesh)
+        return;
+
+    m_vertices = getVertices();
+    m_indices = getIndices();
+    m_indicesArray = getIndicesArray();
+    m_vertexNormals = getVertexNormals();
+    m_textureCoordinates = getTextureCoordinates();
+    m_vertexTangents = getVertexTangents();
+    m_cache.reset();
+    m_compressedMesh.reset();
+}
+
+/**
+ * Returns the header of the cache file the mesh was read from (NULL if the mesh was not read from a cache file).
+ * @brief cacheHeader
+ * @return
+ */
+const MeshCacheHeader* Mesh::cacheHeader() const
+{
+    return (const MeshCacheHeader*) m_cache.get();
+}
 
-    m_vertexNormals.resize(m_vertices.size());
-    QVector3D vector1;
-    QVector3D vector2;
+/**
+ * Computes the normal of each triangle and the normal of each vertex.
+ * The normal of a vertex is the average of the normals of its triangles weighted by the angle of the triangle at the vertex.
+ * The triangles of each vertex are listed once (in the order of the triangles) so that the cost is linear in the number of triangles.
+ * The triangles, then the vertices, are split between the cores of the machine : each vertex sums its own triangles, without locks.
+ * @brief computeNormals
+ */
+void Mesh::computeNormals()
+{
+    detachCache();
+    m_compressedMesh.reset();
+    m_vertexTangents.clear();
+
+    const int numberOfTriangles = m_indices.size();
+    const int numberOfVertices = m_vertices.size();
+
+    const QVector3D* vertices = m_vertices.constData();
+    const QVector3D* indices = m_indices.constData();
+
+    //Normal of each triangle and angle of each of its corners
+    m_triangleNormals.resize(numberOfTriangles);
+    vector<float> cornerAngles(3*numberOfTriangles, 0.0f);
+    QVector3D* triangleNormals = m_triangleNormals.data();
+
+    parallelFor(0, numberOfTriangles, [&](int firstTriangle, int lastTriangle)
+    {
+        for(int i = firstTriangle ; i<lastTriangle ; i++)
+        {
+             int index[3] = {(int) indices[i].x(), (int) indices[i].y(), (int) indices[i].z()};
+
+             //Compute the normal NORMALIZED
+             /*   v3
+              * v1__v2
+              * normal = (v2-v1)^(v3-v1)
+              */
+             QVector3D crossProduct = QVector3D::crossProduct(vertices[index[0]]-vertices[index[1]],vertices[index[0]]-vertices[index[2]]);
+             crossProduct.normalize();
+             triangleNormals[i] = crossProduct;
+
+             /*   z
+              * kx__y
+              * angle at the corner k = acos(kxy.kxz) where the corner k is followed by the corners y and z
+              */
+             for(int c = 0 ; c<3 ; c++)
+             {
+                 QVector3D vector1 = vertices[index[(c+1)%3]]-vertices[index[c]];
+                 QVector3D vector2 = vertices[index[(c+2)%3]]-vertices[index[c]];
+                 vector1.normalize();
+                 vector2.normalize();
+                 cornerAngles[3*i+c] = acos(QVector3D::dotProduct(vector1, vector2));
+             }
+        }
+    });
+
+    //Corners of each vertex (index 3*triangle+corner) sorted by triangle : vertexCorners[firstCorner[k]] to vertexCorners[firstCorner[k+1]-1]
+    vector<int> firstCorner, vertexCorners;
+    listVertexCorners(indices, numberOfTriangles, numberOfVertices, firstCorner, vertexCorners);
 
     //Compute the normals for each vertex
-    for(int k = 0 ; k<m_vertices.size() ; k++)
+    m_vertexNormals.resize(numberOfVertices);
+    QVector3D* vertexNormals = m_vertexNormals.data();
+
+    parallelFor(0, numberOfVertices, [&](int firstVertex, int lastVertex)
     {
-        m_vertexNormals[k] = QVector3D(0.0, 0.0, 0.0);
-        for(int i = 0 ; i<m_indices.size() ; i++)
+        for(int k = firstVertex ; k<lastVertex ; k++)
         {
-            //If the vertex k belongs to triangle i
-            if(m_indices[i].x() == k)
+            QVector3D normal(0.0, 0.0, 0.0);
+
+            for(int corner = firstCorner[k] ; corner<firstCorner[k+1] ; corner++)
             {
-                /*   z
-                 * kx__y
-                 * angle = acos(kxy.kxz)
-                 */
-                vector1 = m_vertices[m_indices[i].y()]- m_vertices[k];
-                vector2 = m_vertices[m_indices[i].z()]- m_vertices[k];
-                vector1.normalize();
-                vector2.normalize();
-                m_vertexNormals[k] += acos(QVector3D::dotProduct(vector1, vector2))*m_triangleNormals[i];
+                normal += cornerAngles[vertexCorners[corner]]*triangleNormals[vertexCorners[corner]/3];
             }
-            else if(m_indices[i].y() == k)
+
+            normal.normalize();
+            vertexNormals[k] = normal;
+        }
+    });
+}
+
+/**
+ * Computes the tangent of each vertex for normal mapping, with the conventions of MikkTSpace (used by the tools that bake normal maps).
+ * The tangent of a triangle is the direction of increasing u (first texture coordinate) and its orientation is the sign of its area in texture space.
+ * The tangent of a vertex is the average of the tangents of its triangles projected on the plane of the vertex normal, weighted by the angle
+ * of the triangle at the vertex. The fourth component is the sign of the bitangent : bitangent = w*cross(normal, tangent).
+ * A vertex shared by triangles of both orientations (mirrored texture coordinates) is split in two vertices, one per orientation.
+ * As for the normals, the triangles then the vertices are split between the cores of the machine and the cost is linear in the number of triangles.
+ * The normals are computed first if the mesh does not have a normal per vertex.
+ * @brief computeTangents
+ */
+void Mesh::computeTangents()
+{
+    detachCache();
+    m_compressedMesh.reset();
+
+    if(m_vertexNormals.size() != m_vertices.size())
+        computeNormals();
+
+    m_textureCoordinates.resize(m_vertices.size());
+
+    const int numberOfTriangles = m_indices.size();
+
+    //Tangent of each triangle, orientation of its texture coordinates (0 if their area is null) and angle of each of its corners
+    vector<QVector3D> triangleTangents(numberOfTriangles);
+    vector<signed char> triangleOrientations(numberOfTriangles, 0);
+    vector<float> cornerAngles(3*numberOfTriangles, 0.0f);
+
+    const QVector3D* vertices = m_vertices.constData();
+    const QVector2D* textureCoordinates = m_textureCoordinates.constData();
+    const QVector3D* indices = m_indices.constData();
+
+    parallelFor(0, numberOfTriangles, [&](int firstTriangle, int lastTriangle)
+    {
+        for(int i = firstTriangle ; i<lastTriangle ; i++)
+        {
+            int index[3] = {(int) indices[i].x(), (int) indices[i].y(), (int) indices[i].z()};
+
+            /* p = p0 + (u-u0)*tangent + (v-v0)*bitangent in the plane of the triangle
+             * tangent = (edge1*dv2 - edge2*dv1)/area where area = du1*dv2 - du2*dv1 is twice the signed area in texture space
+             */
+            const QVector3D edge1 = vertices[index[1]]-vertices[index[0]];
+            const QVector3D edge2 = vertices[index[2]]-vertices[index[0]];
+            const QVector2D uv1 = textureCoordinates[index[1]]-textureCoordinates[index[0]];
+            const QVector2D uv2 = textureCoordinates[index[2]]-textureCoordinates[index[0]];
+            const float area = uv1.x()*uv2.y() - uv2.x()*uv1.y();
+
+            QVector3D tangent = edge1*uv2.y() - edge2*uv1.y();
+
+            if(area != 0.0f && tangent.lengthSquared() > 0.0f)
             {
-                /*   z
-                 * x__ky
-                 * angle = acos(kxy.kxz)
-                 */
-                vector1 = m_vertices[m_indices[i].z()]- m_vertices[k];
-                vector2 = m_vertices[m_indices[i].x()]- m_vertices[k];
-                vector1.normalize();
-                vector2.normalize();
-                m_vertexNormals[k] += acos(QVector3D::dotProduct(vector1, vector2))*m_triangleNormals[i];
+                triangleOrientations[i] = (area > 0.0f) ? 1 : -1;
+                triangleTangents[i] = (area > 0.0f ? tangent : -tangent).normalized();
             }
-            else if(m_indices[i].z() == k)
+
+            for(int c = 0 ; c<3 ; c++)
             {
-                /*   kz
-                 * x__y
-                 * angle = acos(kxy.kxz)
-                 */
-                vector1 = m_vertices[m_indices[i].x()]- m_vertices[k];
-                vector2 = m_vertices[m_indices[i].y()]- m_vertices[k];
+                QVector3D vector1 = vertices[index[(c+1)%3]]-vertices[index[c]];
+                QVector3D vector2 = vertices[index[(c+2)%3]]-vertices[index[c]];
                 vector1.normalize();
                 vector2.normalize();
-                m_vertexNormals[k] += acos(QVector3D::dotProduct(vector1, vector2))*m_triangleNormals[i];
+                cornerAngles[3*i+c] = acos(max(-1.0f, min(1.0f, (float) QVector3D::dotProduct(vector1, vector2))));
+            }
+        }
+    });
+
+    //Orientation of each vertex : the orientation of its first triangle. The corners of the triangles of the other orientation
+    //are moved to a copy of the vertex (the triangles with a null area in texture space keep the vertex)
+    vector<signed char> vertexOrientations(m_vertices.size(), 0);
+    vector<GLuint> mirroredVertex(m_vertices.size(), UINT_MAX);
+    vector<GLuint> triangles(m_indicesArray.constBegin(), m_indicesArray.constEnd());
+    bool splitVertices = false;
+
+    for(int i = 0 ; i<numberOfTriangles ; i++)
+    {
+        for(int c = 0 ; c<3 && triangleOrientations[i] != 0 ; c++)
+        {
+            const GLuint v = triangles[3*i+c];
+
+            if(vertexOrientations[v] == 0)
+            {
+                vertexOrientations[v] = triangleOrientations[i];
+            }
+            else if(vertexOrientations[v] != triangleOrientations[i])
+            {
+                if(mirroredVertex[v] == UINT_MAX)
+                {
+                    const QVector3D position = m_vertices[v];
+                    const QVector3D normal = m_vertexNormals[v];
+                    const QVector2D textureCoordinate = m_textureCoordinates[v];
+
+                    mirroredVertex[v] = (GLuint) m_vertices.size();
+                    m_vertices.push_back(position);
+                    m_vertexNormals.push_back(normal);
+                    m_textureCoordinates.push_back(textureCoordinate);
+                    vertexOrientations.push_back(triangleOrientations[i]);
+                }
+
+                triangles[3*i+c] = mirroredVertex[v];
+                splitVertices = true;
             }
         }
-        m_vertexNormals[k].normalize();
     }
+
+    if(splitVertices)
+        setTriangles(triangles);
+
+    const int numberOfVertices = m_vertices.size();
+    const QVector3D* vertexNormals = m_vertexNormals.constData();
+
+    vector<int> firstCorner, vertexCorners;
+    listVertexCorners(m_indices.constData(), numberOfTriangles, numberOfVertices, firstCorner, vertexCorners);
+
+    //Compute the tangents for each vertex
+    m_vertexTangents.resize(numberOfVertices);
+    QVector4D* vertexTangents = m_vertexTangents.data();
+
+    parallelFor(0, numberOfVertices, [&](int firstVertex, int lastVertex)
+    {
+        for(int k = firstVertex ; k<lastVertex ; k++)
+        {
+            const QVector3D normal = vertexNormals[k];
+            QVector3D tangent(0.0, 0.0, 0.0);
+
+            for(int corner = firstCorner[k] ; corner<firstCorner[k+1] ; corner++)
+            {
+                const int triangle = vertexCorners[corner]/3;
+
+                if(triangleOrientations[triangle] == 0)
+                    continue;
+
+                //Tangent of the triangle projected on the plane of the vertex normal
+                QVector3D projectedTangent = triangleTangents[triangle] - QVector3D::dotProduct(normal, triangleTangents[triangle])*normal;
+                projectedTangent.normalize();
+                tangent += cornerAngles[vertexCorners[corner]]*projectedTangent;
+            }
+
+            //Any direction of the plane of the normal if the texture coordinates do not define one
+            if(tangent.lengthSquared() < 1e-12f)
+            {
+                const QVector3D axis = (fabs(normal.x()) < 0.9f) ? QVector3D(1.0, 0.0, 0.0) : QVector3D(0.0, 1.0, 0.0);
+                tangent = axis - QVector3D::dotProduct(normal, axis)*normal;
+            }
+
+            tangent.normalize();
+            vertexTangents[k] = QVector4D(tangent, vertexOrientations[k] < 0 ? -1.0f : 1.0f);
+        }
+    });
 }
 
 /**
  * Function that returns the path of the .off file corresponding to the object.
- * Also sets the texture coordinates
+ * Also sets the texture coordinates. Any other name is the path of a mesh file (.off, .ply or .obj).
  * @brief loadPathAndTextureCoordinates
  * @param objectName
  * @return
@@ -222,6 +2432,10 @@ string Mesh::loadPathAndTextureCoordinates(const string &objectName)
                  m_textureCoordinates.push_back(QVector2D(0.0,0.0));
                  m_textureCoordinates.push_back(QVector2D(1.0,0.0));
     }
+    else
+    {
+        objectPath = objectName;
+    }
 
     return objectPath;
 }
@@ -234,6 +2448,9 @@ string Mesh::loadPathAndTextureCoordinates(const string &objectName)
  */
 void Mesh::setTextureCoordinates(QVector<QVector2D> textureCoordinates)
 {
+    detachCache();
+    m_compressedMesh.reset();
+    m_vertexTangents.clear();
     m_textureCoordinates = textureCoordinates;
 }
 
@@ -244,6 +2461,12 @@ void Mesh::setTextureCoordinates(QVector<QVector2D> textureCoordinates)
  */
 QVector<QVector3D> Mesh::getVertices() const
 {
+    if(m_compressedMesh)
+        return decodeArray<QVector3D>(*m_compressedMesh, [&](const CompressedVertex& vertex) { return m_compressedMesh->decodePosition(vertex); });
+
+    if(cacheHeader())
+        return copyArray(getVertexData(), getNumberOfVertices());
+
     return m_vertices;
 }
 
@@ -256,6 +2479,20 @@ QVector<QVector3D> Mesh::getVertices() const
  */
 QVector<QVector3D> Mesh::getIndices() const
 {
+    if(cacheHeader() || m_compressedMesh)
+    {
+        const QVector<GLuint> indicesArray = m_compressedMesh ? decodeIndices(*m_compressedMesh) : QVector<GLuint>();
+        const GLuint* indices = m_compressedMesh ? indicesArray.constData() : getIndexData();
+        QVector<QVector3D> triangles(getNumberOfIndices()/3);
+
+        for(int k = 0 ; k<triangles.size() ; k++)
+        {
+            triangles[k] = QVector3D(indices[3*k], indices[3*k+1], indices[3*k+2]);
+        }
+
+        return triangles;
+    }
+
     return m_indices;
 }
 
@@ -268,6 +2505,12 @@ QVector<QVector3D> Mesh::getIndices() const
  */
 QVector<GLuint> Mesh::getIndicesArray() const
 {
+    if(m_compressedMesh)
+        return decodeIndices(*m_compressedMesh);
+
+    if(cacheHeader())
+        return copyArray(getIndexData(), getNumberOfIndices());
+
     return m_indicesArray;
 }
 
@@ -278,6 +2521,12 @@ QVector<GLuint> Mesh::getIndicesArray() const
  */
 QVector<QVector3D> Mesh::getVertexNormals() const
 {
+    if(m_compressedMesh)
+        return decodeArray<QVector3D>(*m_compressedMesh, [&](const CompressedVertex& vertex) { return m_compressedMesh->decodeNormal(vertex); });
+
+    if(cacheHeader())
+        return copyArray(getVertexNormalData(), getNumberOfVertices());
+
     return m_vertexNormals;
 }
 
@@ -288,6 +2537,126 @@ QVector<QVector3D> Mesh::getVertexNormals() const
  */
 QVector<QVector2D> Mesh::getTextureCoordinates() const
 {
+    if(m_compressedMesh)
+        return decodeArray<QVector2D>(*m_compressedMesh, [&](const CompressedVertex& vertex) { return m_compressedMesh->decodeTextureCoordinate(vertex); });
+
+    if(cacheHeader())
+        return copyArray(getTextureCoordinateData(), getNumberOfVertices());
+
     return m_textureCoordinates;
 }
 
+/**
+ * Returns the tangents at each vertex (see computeTangents), or an empty array if they were not computed.
+ * @brief getVertexTangents
+ * @return
+ */
+QVector<QVector4D> Mesh::getVertexTangents() const
+{
+    if(m_compressedMesh)
+        return decodeArray<QVector4D>(*m_compressedMesh, [&](const CompressedVertex& vertex) { return m_compressedMesh->decodeTangent(vertex); });
+
+    const QVector4D* vertexTangents = getVertexTangentData();
+    return vertexTangents ? copyArray(vertexTangents, getNumberOfVertices()) : QVector<QVector4D>();
+}
+
+/**
+ * Returns the number of vertices.
+ * @brief getNumberOfVertices
+ * @return
+ */
+int Mesh::getNumberOfVertices() const
+{
+    if(m_compressedMesh)
+        return m_compressedMesh->getNumberOfVertices();
+
+    const MeshCacheHeader* header = cacheHeader();
+    return header ? (int) header->numberOfVertices : m_vertices.size();
+}
+
+/**
+ * Returns the number of indices (3 per triangle).
+ * @brief getNumberOfIndices
+ * @return
+ */
+int Mesh::getNumberOfIndices() const
+{
+    if(m_compressedMesh)
+        return m_compressedMesh->getNumberOfIndices();
+
+    const MeshCacheHeader* header = cacheHeader();
+    return header ? (int) header->numberOfIndices : m_indicesArray.size();
+}
+
+/**
+ * Returns a pointer to the vertices, without any copy (in the cache file if the mesh was read from the cache).
+ * The pointer is valid as long as a copy of the mesh is not modified or destroyed.
+ * @brief getVertexData
+ * @return
+ */
+const QVector3D* Mesh::getVertexData() const
+{
+    if(m_compressedMesh)
+        return NULL;
+
+    const MeshCacheHeader* header = cacheHeader();
+    return header ? (const QVector3D*) (m_cache.get()+header->verticesOffset) : m_vertices.constData();
+}
+
+/**
+ * Returns a pointer to the surface normals at each vertex, without any copy.
+ * @brief getVertexNormalData
+ * @return
+ */
+const QVector3D* Mesh::getVertexNormalData() const
+{
+    if(m_compressedMesh)
+        return NULL;
+
+    const MeshCacheHeader* header = cacheHeader();
+    return header ? (const QVector3D*) (m_cache.get()+header->normalsOffset) : m_vertexNormals.constData();
+}
+
+/**
+ * Returns a pointer to the texture coordinates at each vertex, without any copy.
+ * @brief getTextureCoordinateData
+ * @return
+ */
+const QVector2D* Mesh::getTextureCoordinateData() const
+{
+    if(m_compressedMesh)
+        return NULL;
+
+    const MeshCacheHeader* header = cacheHeader();
+    return header ? (const QVector2D*) (m_cache.get()+header->textureCoordinatesOffset) : m_textureCoordinates.constData();
+}
+
+/**
+ * Returns a pointer to the tangents at each vertex without any copy, or NULL if they were not computed.
+ * @brief getVertexTangentData
+ * @return
+ */
+const QVector4D* Mesh::getVertexTangentData() const
+{
+    const MeshCacheHeader* header = cacheHeader();
+
+    if(header)
+        return (const QVector4D*) (m_cache.get()+header->tangentsOffset);
+
+    return (!m_vertexTangents.isEmpty() && m_vertexTangents.size() == m_vertices.size()) ? m_vertexTangents.constData() : NULL;
+}
+
+/**
+ * Returns a pointer to the indices of the triangles (each consecutive triplet is a triangle), without any copy.
+ * @brief getIndexData
+ * @return
+ */
+const GLuint* Mesh::getIndexData() const
+{
+    if(m_compressedMesh)
+        return NULL;
+
+    const MeshCacheHeader* header = cacheHeader();
+    return header ? (const GLuint*) (m_cache.get()+header->indicesOffset) : m_indicesArray.constData();
+}
+
@@ -34,24 +34,61 @@
  * \author Antoine Toisoul Le Cann
  * \date September, 1st, 2016
  *
- * Implementation of a Mesh. Stores the vertices, triangles, normals and texture coordinates.
+ * Implementation of a Mesh. Stores the vertices, triangles, normals, texture coordinates and tangents.
  */
 
 #ifndef MESH_H
 #define MESH_H
 
 #include "openglheaders.h"
+#include "opengl/compressedmesh.h"
 #include <QApplication>
 
 #include <QVector>
 
 #include <QVector2D>
 #include <QVector3D>
+#include <QVector4D>
 
 #include <iostream>
 #include <fstream>
 #include <string>
+#include <vector>
+#include <memory>
 #include <cmath>
+#include <stdint.h>
+
+#define MESH_CACHE_VERSION 3 /*!< Version of the layout of the mesh cache files. The files of other versions are ignored. */
+#define MESH_CACHE_ALIGNMENT 64 /*!< Alignment in bytes of the arrays in the mesh cache files. */
+#define MESH_CACHE_EXTENSION ".meshcache" /*!< Extension added to the path of a mesh file to get the path of its cache file. */
+#define MESH_VERTEX_CACHE_SIZE 32 /*!< Number of vertices of the post transform cache the triangles are ordered for. */
+
+/**
+ * Header at the beginning of each mesh cache file. The file is stored in the byte order of the machine.
+ * The arrays are stored after the header at the given offsets in the layout OpenGL expects :
+ * positions and normals (3 floats per vertex), texture coordinates (2 floats per vertex), tangents (4 floats per vertex, see computeTangents)
+ * and indices (unsigned 32 bits integers, 3 per triangle).
+ */
+struct MeshCacheHeader
+{
+    char magic[8]; /*!< "R3DMESH" followed by a null character. */
+    uint32_t version; /*!< MESH_CACHE_VERSION. */
+    uint32_t byteOrderMark; /*!< 0x01020304 in the byte order of the machine that wrote the file. */
+    uint64_t fileSize; /*!< Size of the file in bytes. */
+    uint64_t sourceSize; /*!< Size of the mesh file the cache was generated from. */
+    int64_t sourceModificationTime; /*!< Modification date of the mesh file the cache was generated from. */
+    uint32_t numberOfVertices; /*!< Number of vertices. */
+    uint32_t numberOfIndices; /*!< Number of indices (3 per triangle). */
+    uint64_t verticesOffset; /*!< Offset of the positions from the beginning of the file in bytes. */
+    uint64_t normalsOffset; /*!< Offset of the normals from the beginning of the file in bytes. */
+    uint64_t textureCoordinatesOffset; /*!< Offset of the texture coordinates from the beginning of the file in bytes. */
+    uint64_t tangentsOffset; /*!< Offset of the tangents from the beginning of the file in bytes. */
+    uint64_t indicesOffset; /*!< Offset of the indices from the beginning of the file in bytes. */
+    float boundingBoxMinimum[3]; /*!< Minimum of the coordinates of the vertices. */
+    float boundingBoxMaximum[3]; /*!< Maximum of the coordinates of the vertices. */
+    uint64_t dataChecksum; /*!< Hash of the arrays (from the end of the header to the end of the file). */
+    uint64_t headerChecksum; /*!< Hash of the header up to this field. */
+};
 
 class Mesh
 {
@@ -69,16 +106,151 @@ class Mesh
          */
         Mesh(const std::string &objectName);
 
+        /**
+         * Reads a mesh file. The format is given by the extension of the file : .ply, .obj or .off (default).
+         * Vertices without texture coordinates are given the texture coordinate (0,0).
+         * The cache file next to the mesh file (MESH_CACHE_EXTENSION) is mapped instead if it was generated from the current mesh file,
+         * otherwise it is written after the mesh file is read, its tangents are computed (see computeTangents) and its triangles are reordered (see optimizeIndices).
+         * The average cache miss ratio (ACMR) before and after the reordering is printed.
+         * Returns true if the mesh was read.
+         * @brief readFile
+         * @param fileName
+         * @return
+         */
+        bool readFile(std::string fileName);
+
         /**
          * Reads the triangles from a .off file.
+         * The file is mapped in memory and split in blocks of lines parsed in parallel. Polygons with more than 3 vertices
+         * are split in a fan of triangles around their first vertex.
          * @brief offReader
          * @param fileName
          */
         void offReader(std::string fileName);
 
+        /**
+         * Reads the vertices (positions, normals and texture coordinates) and the faces from a .ply file
+         * (binary little endian, binary big endian or ascii). The file is mapped in memory and read in a single pass
+         * into arrays allocated from the number of elements given in the header. Polygons with more than 3 vertices
+         * are split in a fan of triangles around their first vertex. The normals are computed if the file does not contain them.
+         * Returns true if the mesh was read.
+         * @brief plyReader
+         * @param fileName
+         * @return
+         */
+        bool plyReader(std::string fileName);
+
+        /**
+         * Reads the vertices (positions, texture coordinates and normals) and the faces from a .obj file.
+         * A first pass over the mapped file counts the elements so that every array is allocated once.
+         * Corners of the faces that use the same position, texture coordinate and normal are merged in one vertex with a hash table.
+         * Polygons with more than 3 vertices are split in a fan of triangles around their first vertex.
+         * The normals are computed if some corners of the faces do not have one.
+         * Returns true if the mesh was read.
+         * @brief objReader
+         * @param fileName
+         * @return
+         */
+        bool objReader(std::string fileName);
+
+        /**
+         * Reorders the triangles for the post transform vertex cache then for overdraw, and numbers the vertices
+         * in the order they are first used by the triangles so that they are fetched from memory in order.
+         * @brief optimizeIndices
+         */
+        void optimizeIndices();
+
+        /**
+         * Returns a simplified copy of the mesh with at most targetNumberOfTriangles triangles, or as close as the edges that can be collapsed allow.
+         * The vertices that remain keep their positions, normals, texture coordinates and tangents, and the unused vertices are removed.
+         * @brief simplify
+         * @param targetNumberOfTriangles
+         * @return
+         */
+        Mesh simplify(int targetNumberOfTriangles) const;
+
+        /**
+         * Replaces the arrays of the mesh by a compressed copy for the compact vertex format (see CompressedMesh).
+         * The float arrays (or the mapping of the cache file) are released : the pointers to the arrays are NULL and the
+         * arrays returned by the other functions are decoded. The mesh is decoded back to floats before it is modified.
+         * @brief compress
+         */
+        void compress();
+
+        /**
+         * Returns the compressed copy of the mesh, or NULL if the mesh is not compressed.
+         * @brief getCompressedMesh
+         * @return
+         */
+        const CompressedMesh* getCompressedMesh() const;
+
+        /**
+         * Returns the average cache miss ratio (ACMR) of the triangles : the number of vertices transformed per triangle (between 0.5 and 3)
+         * with a FIFO post transform cache of cacheSize vertices.
+         * @brief getAverageCacheMissRatio
+         * @param cacheSize
+         * @return
+         */
+        float getAverageCacheMissRatio(int cacheSize = MESH_VERTEX_CACHE_SIZE) const;
+
+        /**
+         * Writes the mesh in a cache file that can be mapped in memory by readCache.
+         * The size and the modification date of the mesh file sourceFileName are stored to detect when the cache is outdated.
+         * The file is written under another name then renamed : a cache file is either complete or missing.
+         * Returns true if the file was written.
+         * @brief writeCache
+         * @param cacheFileName
+         * @param sourceFileName
+         * @return
+         */
+        bool writeCache(std::string cacheFileName, std::string sourceFileName) const;
+
+        /**
+         * Maps a cache file written by writeCache in memory. The arrays are used directly from the mapping (without any copy),
+         * so the time to read the mesh does not depend on its size and the pages are read from the disk when they are first used.
+         * Returns false if the file is not a valid cache file of the current version or if the mesh file sourceFileName changed.
+         * The hash of the arrays is only checked if verifyData is true, as it reads the whole file. Otherwise the indices are checked
+         * to be smaller than the number of vertices, so a corrupted index block cannot make OpenGL read outside of the arrays.
+         * @brief readCache
+         * @param cacheFileName
+         * @param sourceFileName
+         * @param verifyData
+         * @return
+         */
+        bool readCache(std::string cacheFileName, std::string sourceFileName, bool verifyData = false);
+
+        /**
+         * Returns the minimum and the maximum of the coordinates of the vertices.
+         * @brief getBoundingBox
+         * @param minimum
+         * @param maximum
+         */
+        void getBoundingBox(QVector3D& minimum, QVector3D& maximum) const;
+
+        /**
+         * Computes the normal of each triangle and the normal of each vertex.
+         * The normal of a vertex is the average of the normals of its triangles weighted by the angle of the triangle at the vertex.
+         * The triangles of each vertex are listed once (in the order of the triangles) so that the cost is linear in the number of triangles.
+         * The triangles, then the vertices, are split between the cores of the machine : each vertex sums its own triangles, without locks.
+         * @brief computeNormals
+         */
+        void computeNormals();
+
+        /**
+         * Computes the tangent of each vertex for normal mapping, with the conventions of MikkTSpace (used by the tools that bake normal maps).
+         * The tangent of a triangle is the direction of increasing u (first texture coordinate) and its orientation is the sign of its area in texture space.
+         * The tangent of a vertex is the average of the tangents of its triangles projected on the plane of the vertex normal, weighted by the angle
+         * of the triangle at the vertex. The fourth component is the sign of the bitangent : bitangent = w*cross(normal, tangent).
+         * A vertex shared by triangles of both orientations (mirrored texture coordinates) is split in two vertices, one per orientation.
+         * As for the normals, the triangles then the vertices are split between the cores of the machine and the cost is linear in the number of triangles.
+         * The normals are computed first if the mesh does not have a normal per vertex.
+         * @brief computeTangents
+         */
+        void computeTangents();
+
         /**
          * Function that returns the path of the .off file corresponding to the object.
-         * Also sets the texture coordinates
+         * Also sets the texture coordinates. Any other name is the path of a mesh file (.off, .ply or .obj).
          * @brief loadPathAndTextureCoordinates
          * @param objectName
          * @return
@@ -131,7 +303,84 @@ class Mesh
          */
         QVector<QVector2D> getTextureCoordinates() const;
 
+        /**
+         * Returns the tangents at each vertex (see computeTangents), or an empty array if they were not computed.
+         * @brief getVertexTangents
+         * @return
+         */
+        QVector<QVector4D> getVertexTangents() const;
+
+        /**
+         * Returns the number of vertices.
+         * @brief getNumberOfVertices
+         * @return
+         */
+        int getNumberOfVertices() const;
+
+        /**
+         * Returns the number of indices (3 per triangle).
+         * @brief getNumberOfIndices
+         * @return
+         */
+        int getNumberOfIndices() const;
+
+        /**
+         * Returns a pointer to the vertices, without any copy (in the cache file if the mesh was read from the cache).
+         * The pointer is valid as long as a copy of the mesh is not modified or destroyed.
+         * @brief getVertexData
+         * @return
+         */
+        const QVector3D* getVertexData() const;
+
+        /**
+         * Returns a pointer to the surface normals at each vertex, without any copy.
+         * @brief getVertexNormalData
+         * @return
+         */
+        const QVector3D* getVertexNormalData() const;
+
+        /**
+         * Returns a pointer to the texture coordinates at each vertex, without any copy.
+         * @brief getTextureCoordinateData
+         * @return
+         */
+        const QVector2D* getTextureCoordinateData() const;
+
+        /**
+         * Returns a pointer to the tangents at each vertex without any copy, or NULL if they were not computed.
+         * @brief getVertexTangentData
+         * @return
+         */
+        const QVector4D* getVertexTangentData() const;
+
+        /**
+         * Returns a pointer to the indices of the triangles (each consecutive triplet is a triangle), without any copy.
+         * @brief getIndexData
+         * @return
+         */
+        const GLuint* getIndexData() const;
+
     private:
+        /**
+         * Sets the triangles of the mesh from a list of indices where each consecutive triplet is a triangle.
+         * @brief setTriangles
+         * @param triangles
+         */
+        void setTriangles(const std::vector<GLuint>& triangles);
+
+        /**
+         * Copies the arrays of the cache file (or decodes the arrays of the compressed copy) in the QVectors of the mesh
+         * and releases the mapping, before the mesh is modified.
+         * @brief detachCache
+         */
+        void detachCache();
+
+        /**
+         * Returns the header of the cache file the mesh was read from (NULL if the mesh was not read from a cache file).
+         * @brief cacheHeader
+         * @return
+         */
+        const MeshCacheHeader* cacheHeader() const;
 
         QVector<QVector3D> m_vertices; /*!< Array of vertices. Each vertex is a position : QVector3D. */
         QVector<QVector3D> m_indices; /*!< Contains the list of indices for each triangle. QVector3D contains the 3 indices for a given triangle. */
@@ -142,6 +391,10 @@ class Mesh
         QVector<QVector3D> m_triangleNormals;/*!< Array that contains the normal of each triangle.. */
         QVector<QVector3D> m_vertexNormals;/*!< Array that contains the normal of each vertex. */
         QVector<QVector2D> m_textureCoordinates;/*!< Array that contains the UV texture coordinate of each triangle. */
+        QVector<QVector4D> m_vertexTangents;/*!< Array that contains the tangent of each vertex and the sign of its bitangent (w). Empty if the tangents were not computed. */
+
+        std::shared_ptr<const char> m_cache; /*!< Mapping of the cache file that contains the arrays (shared by the copies of the mesh). Empty if the arrays are in the QVectors. */
+        std::shared_ptr<const CompressedMesh> m_compressedMesh; /*!< Compressed arrays of the mesh (shared by the copies of the mesh). Empty if the mesh is not compressed. */
 };
 
 #endif // MESH_H
@@ -35,20 +35,80 @@
  * \date September, 1st, 2016
  *
  * Implementation of an Object. Stores the mesh and textures.
+ * The meshes and textures are shared with the other objects that use the same files (see ResourceRegistry).
  */
 
 #include "opengl/object.h"
+#include "maths/mathfunctions.h"
 
 using namespace std;
 
+/**
+ * Returns the mesh of the objects without a mesh (shared by all of them).
+ * @brief emptyMesh
+ * @return
+ */
+static shared_ptr<const Mesh> emptyMesh()
+{
+    static const shared_ptr<const Mesh> mesh = make_shared<const Mesh>();
+    return mesh;
+}
+
+/**
+ * Returns the mesh registered with a key, compressed for the compact vertex format if compactVertices is true.
+ * @brief registeredMesh
+ * @param key
+ * @param load
+ * @param compactVertices
+ * @return
+ */
+static shared_ptr<const Mesh> registeredMesh(const string key, function<bool(Mesh&)> load, bool compactVertices)
+{
+    return compactVertices ? ResourceRegistry::compactMesh(key, load) : ResourceRegistry::mesh(key, load);
+}
+
+/**
+ * Returns the texture of the objects without a texture (shared by all of them).
+ * @brief emptyTexture
+ * @return
+ */
+static shared_ptr<const Texture> emptyTexture()
+{
+    static const shared_ptr<const Texture> texture = make_shared<const Texture>();
+    return texture;
+}
+
+/**
+ * Gets the texture of an image file from the registry. If the file could not be loaded, the texture is replaced
+ * by a texture that is not loaded with the path of the file.
+ * Returns true if the texture was correctly loaded.
+ * @brief loadTexture
+ * @param filePath
+ * @param texture
+ * @return
+ */
+static bool loadTexture(const string filePath, shared_ptr<const Texture>& texture)
+{
+    texture = ResourceRegistry::texture(filePath);
+
+    if(!texture)
+    {
+        texture = make_shared<const Texture>(filePath);
+        return false;
+    }
+
+    return true;
+}
+
 
 /**
  * Default Object constructor.
  * @brief Object
  */
-Object::Object(): m_mesh(Mesh()), m_material(Material()), m_modelMatrix(QMatrix4x4()),
-    m_diffuseTexture(Texture()), m_specularTexture(),
-    m_normalMap(Texture()), m_roughnessMap(Texture())
+Object::Object(): m_mesh(emptyMesh()), m_meshKey(""), m_loadMesh(), m_compactVertices(false), m_simplifiedMeshes(QVector<shared_ptr<const Mesh> >()), m_boundingSphereCenter(QVector3D()), m_boundingSphereRadius(0.0),
+    m_material(Material()), m_modelMatrix(QMatrix4x4()), m_meshMatrix(QMatrix4x4()),
+    m_diffuseTexture(emptyTexture()), m_specularTexture(emptyTexture()),
+    m_normalMap(emptyTexture()), m_roughnessMap(emptyTexture())
 {
 
 }
@@ -58,15 +118,21 @@ Object::Object(): m_mesh(Mesh()), m_material(Material()), m_modelMatrix(QMatrix4
  * @brief Object::Object
  * @param objectName
  */
-Object::Object(string objectName): m_mesh(Mesh()), m_material(Material()), m_modelMatrix(QMatrix4x4()),
-m_diffuseTexture(Texture()), m_specularTexture(Texture()),
-m_normalMap(Texture()), m_roughnessMap(Texture())
+Object::Object(string objectName): m_mesh(emptyMesh()), m_meshKey(objectName), m_loadMesh(), m_compactVertices(false), m_simplifiedMeshes(QVector<shared_ptr<const Mesh> >()), m_boundingSphereCenter(QVector3D()), m_boundingSphereRadius(0.0),
+    m_material(Material()), m_modelMatrix(QMatrix4x4()), m_meshMatrix(QMatrix4x4()),
+m_diffuseTexture(emptyTexture()), m_specularTexture(emptyTexture()),
+m_normalMap(emptyTexture()), m_roughnessMap(emptyTexture())
 {
-    m_mesh = Mesh(objectName);
+    //The objects with the same name share their mesh
+    m_loadMesh = [objectName](Mesh& mesh) { mesh = Mesh(objectName); return true; };
+
+    shared_ptr<const Mesh> mesh = ResourceRegistry::mesh(m_meshKey, m_loadMesh);
+    m_mesh = mesh ? mesh : emptyMesh();
     m_material = Material(QColor(128,128,0), QColor(128,128,0), QColor(255,255,255), (float) 0.1, (float) 1.0, (float)1.0, (float)500.0);
 
     m_modelMatrix = QMatrix4x4();
     m_modelMatrix.setToIdentity();
+    m_meshMatrix.setToIdentity();
 }
 
 
@@ -92,10 +158,11 @@ bool Object::loadTextures()
     bool normalMapLoaded = false;
     bool roughnessMapLoaded = false;
 
-    normalMapLoaded = m_normalMap.load_8UC3();
-    diffuseTextureLoaded = m_diffuseTexture.load_32FC3();
-    specularTextureLoaded = m_specularTexture.load_32FC3();
-    roughnessMapLoaded = m_roughnessMap.load_32FC3();
+    //The textures already loaded by an object are shared
+    normalMapLoaded = loadTexture(m_normalMap->getFilePath(), m_normalMap);
+    diffuseTextureLoaded = loadTexture(m_diffuseTexture->getFilePath(), m_diffuseTexture);
+    specularTextureLoaded = loadTexture(m_specularTexture->getFilePath(), m_specularTexture);
+    roughnessMapLoaded = loadTexture(m_roughnessMap->getFilePath(), m_roughnessMap);
 
     bool correctlyLoaded = (diffuseTextureLoaded && specularTextureLoaded && normalMapLoaded && roughnessMapLoaded);
 
@@ -131,21 +198,21 @@ void Object::setAspectRatio()
     float aspectRatio = 1.0;
 
     //Choose the aspect ratio depending on which texture is loaded
-    if(m_diffuseTexture.isLoaded())
+    if(m_diffuseTexture->isLoaded())
     {
-        aspectRatio = m_diffuseTexture.getAspectRatio();
+        aspectRatio = m_diffuseTexture->getAspectRatio();
     }
-    else if(m_specularTexture.isLoaded())
+    else if(m_specularTexture->isLoaded())
     {
-        aspectRatio = m_diffuseTexture.getAspectRatio();
+        aspectRatio = m_diffuseTexture->getAspectRatio();
     }
-    else if(m_normalMap.isLoaded())
+    else if(m_normalMap->isLoaded())
     {
-        aspectRatio = m_diffuseTexture.getAspectRatio();
+        aspectRatio = m_diffuseTexture->getAspectRatio();
     }
-    else if(m_roughnessMap.isLoaded())
+    else if(m_roughnessMap->isLoaded())
     {
-        aspectRatio = m_diffuseTexture.getAspectRatio();
+        aspectRatio = m_diffuseTexture->getAspectRatio();
     }
 
     m_modelMatrix.scale(1.0, 1.0/aspectRatio);
@@ -229,21 +296,8 @@ void Object::rotateZ(int angleZ)
  */
 bool Object::loadDiffuseTexture(const std::string filePath)
 {
-    m_diffuseTexture = Texture(filePath);
-
-    bool loaded = false;
-
-    //PFM for HDR textures
-    if(filePath.substr(filePath.size()-3, 3) == string("pfm"))
-    {
-        loaded = m_diffuseTexture.load_32FC3();
-    }
-    else
-    {
-        loaded = m_diffuseTexture.load_8UC3();
-    }
-
-    return loaded;
+    //PFM or Radiance HDR for HDR textures, 8 bits images otherwise
+    return loadTexture(filePath, m_diffuseTexture);
 }
 
 /**
@@ -254,21 +308,8 @@ bool Object::loadDiffuseTexture(const std::string filePath)
  */
 bool Object::loadSpecularTexture(const std::string filePath)
 {
-    m_specularTexture = Texture(filePath);
-
-    bool loaded = false;
-
-    //PFM for HDR textures
-    if(filePath.substr(filePath.size()-3, 3) == string("pfm"))
-    {
-        loaded = m_specularTexture.load_32FC3();
-    }
-    else
-    {
-        loaded = m_specularTexture.load_8UC3();
-    }
-
-    return loaded;
+    //PFM or Radiance HDR for HDR textures, 8 bits images otherwise
+    return loadTexture(filePath, m_specularTexture);
 }
 
 /**
@@ -280,21 +321,8 @@ bool Object::loadSpecularTexture(const std::string filePath)
  */
 bool Object::loadNormalMap(const std::string filePath)
 {
-    m_normalMap = Texture(filePath);
-
-    bool loaded = false;
-
-    //PFM for HDR textures
-    if(filePath.substr(filePath.size()-3, 3) == string("pfm"))
-    {
-        loaded = m_normalMap.load_32FC3();
-    }
-    else
-    {
-        loaded = m_normalMap.load_8UC3();
-    }
-
-    return loaded;
+    //PFM or Radiance HDR for HDR textures, 8 bits images otherwise
+    return loadTexture(filePath, m_normalMap);
 }
 
 /**
@@ -306,18 +334,45 @@ bool Object::loadNormalMap(const std::string filePath)
  */
 bool Object::loadRoughnessMap(const std::string filePath)
 {
-    m_roughnessMap = Texture(filePath);
+    //PFM or Radiance HDR for HDR textures, 8 bits images otherwise
+    return loadTexture(filePath, m_roughnessMap);
+}
 
-    bool loaded = false;
+/**
+ * Loads the mesh of the object given a path of a mesh file (.off, .ply or .obj).
+ * The mesh is centered at the origin and scaled to the size of the square by the mesh matrix (the vertices are not modified).
+ * Returns true if the mesh was correctly loaded. The previous mesh is kept otherwise.
+ * @brief loadMesh
+ * @param filePath
+ * @return
+ */
+bool Object::loadMesh(const std::string filePath)
+{
+    //The objects that use the same mesh file share the mesh
+    function<bool(Mesh&)> loadMesh = [filePath](Mesh& mesh) { return mesh.readFile(filePath); };
 
-    //PFM for HDR textures
-    if(filePath.substr(filePath.size()-3, 3) == string("pfm"))
-    {
-        loaded = m_roughnessMap.load_32FC3();
-    }
-    else
+    shared_ptr<const Mesh> mesh = registeredMesh(filePath, loadMesh, m_compactVertices);
+    bool loaded = (mesh.get() != NULL);
+
+    if(loaded)
     {
-        loaded = m_roughnessMap.load_8UC3();
+        QVector3D minimum, maximum;
+        mesh->getBoundingBox(minimum, maximum);
+
+        const QVector3D size = maximum-minimum;
+        const float largestSize = max(size.x(), max(size.y(), size.z()));
+
+        m_mesh = mesh;
+        m_meshKey = filePath;
+        m_loadMesh = loadMesh;
+        m_meshMatrix.setToIdentity();
+        m_meshMatrix.scale(largestSize > 0.0 ? 1.0/largestSize : 1.0);
+        m_meshMatrix.translate(-0.5*(minimum+maximum));
+
+        m_boundingSphereCenter = 0.5*(minimum+maximum);
+        m_boundingSphereRadius = 0.5*size.length();
+
+        generateLevelsOfDetail(filePath);
     }
 
     return loaded;
@@ -334,23 +389,171 @@ Material Object::getMaterial() const
 }
 
 /**
- * Returns the object mesh.
+ * Generates the levels of detail of the mesh, each one with reduction times the triangles of the finer level,
+ * until maximumNumberOfLevels levels (including the mesh) or less than OBJECT_LOD_MINIMUM_TRIANGLES triangles.
+ * Each level is stored in a cache file next to the mesh file filePath and is only simplified again when the mesh file changes.
+ * @brief generateLevelsOfDetail
+ * @param filePath
+ * @param maximumNumberOfLevels
+ * @param reduction
+ */
+void Object::generateLevelsOfDetail(const std::string filePath, int maximumNumberOfLevels, float reduction)
+{
+    //The previous levels are kept until the new ones are registered : they are copied instead of read again when only their format changes
+    QVector<shared_ptr<const Mesh> > simplifiedMeshes;
+
+    //Each level is simplified from the previous one
+    shared_ptr<const Mesh> finerMesh = m_mesh;
+
+    for(int level = 1 ; level<maximumNumberOfLevels ; level++)
+    {
+        const int finerNumberOfTriangles = finerMesh->getNumberOfIndices()/3;
+        const int targetNumberOfTriangles = (int) (reduction*finerNumberOfTriangles);
+
+        if(targetNumberOfTriangles < OBJECT_LOD_MINIMUM_TRIANGLES)
+            break;
+
+        stringstream cacheFileName;
+        cacheFileName << filePath << ".lod" << targetNumberOfTriangles << MESH_CACHE_EXTENSION;
+
+        //The levels are shared by the objects that use the same mesh file
+        shared_ptr<const Mesh> simplifiedMesh = registeredMesh(cacheFileName.str(), [&](Mesh& mesh)
+        {
+            if(mesh.readCache(cacheFileName.str(), filePath))
+                return true;
+
+            mesh = finerMesh->simplify(targetNumberOfTriangles);
+
+            //No more edges can be collapsed
+            if(mesh.getNumberOfIndices()/3 > OBJECT_LOD_MINIMUM_PROGRESS*finerNumberOfTriangles)
+                return false;
+
+            mesh.optimizeIndices();
+            mesh.writeCache(cacheFileName.str(), filePath);
+
+            return true;
+        }, m_compactVertices);
+
+        if(!simplifiedMesh)
+            break;
+
+        cout << "Level of detail " << level << " of " << filePath << " : " << simplifiedMesh->getNumberOfIndices()/3 << " triangles" << endl;
+
+        simplifiedMeshes.push_back(simplifiedMesh);
+        finerMesh = simplifiedMesh;
+    }
+
+    m_simplifiedMeshes = simplifiedMeshes;
+}
+
+/**
+ * Switches the meshes of the object (and its levels of detail) between the float arrays and the compact vertex format.
+ * The compressed meshes are only built when the compact vertex format is first used, and the float meshes are released
+ * when no object uses them anymore.
+ * @brief setCompactVertices
+ * @param compactVertices
+ */
+void Object::setCompactVertices(bool compactVertices)
+{
+    if(compactVertices == m_compactVertices)
+        return;
+
+    m_compactVertices = compactVertices;
+
+    //The objects without a mesh keep the empty mesh
+    if(!m_loadMesh)
+        return;
+
+    shared_ptr<const Mesh> mesh = registeredMesh(m_meshKey, m_loadMesh, m_compactVertices);
+
+    if(!mesh)
+    {
+        cerr << "The mesh " << m_meshKey << " could not be loaded with the compact vertex format" << endl;
+        m_compactVertices = !compactVertices;
+        return;
+    }
+
+    m_mesh = mesh;
+
+    //The levels of detail are read from their cache files
+    if(!m_simplifiedMeshes.isEmpty())
+        generateLevelsOfDetail(m_meshKey);
+}
+
+/**
+ * Returns the level of detail to render the object with : the coarsest level with at least one triangle
+ * per OBJECT_LOD_PIXELS_PER_TRIANGLE pixels of the projection of the bounding sphere of the object on the viewport.
+ * @brief levelOfDetail
+ * @param viewMatrix
+ * @param projectionMatrix
+ * @param viewportHeight
+ * @return
+ */
+int Object::levelOfDetail(const QMatrix4x4& viewMatrix, const QMatrix4x4& projectionMatrix, int viewportHeight) const
+{
+    if(m_simplifiedMeshes.isEmpty())
+        return 0;
+
+    //Bounding sphere in the camera space
+    const QMatrix4x4 modelViewMatrix = viewMatrix*getModelMatrix();
+    const QVector3D center = modelViewMatrix.map(m_boundingSphereCenter);
+    const float scale = max(modelViewMatrix.mapVector(QVector3D(1.0, 0.0, 0.0)).length(),
+                            max(modelViewMatrix.mapVector(QVector3D(0.0, 1.0, 0.0)).length(), modelViewMatrix.mapVector(QVector3D(0.0, 0.0, 1.0)).length()));
+    const float radius = scale*m_boundingSphereRadius;
+
+    //w is the distance to the camera for a perspective projection and 1 for an orthographic projection
+    const float w = projectionMatrix(3,0)*center.x() + projectionMatrix(3,1)*center.y() + projectionMatrix(3,2)*center.z() + projectionMatrix(3,3);
+
+    //The camera is inside the bounding sphere
+    if(w <= radius*fabs(projectionMatrix(3,2)))
+        return 0;
+
+    const float diameterInPixels = radius*projectionMatrix(1,1)*viewportHeight/w;
+    const float numberOfTriangles = 0.25*M_PI*diameterInPixels*diameterInPixels/OBJECT_LOD_PIXELS_PER_TRIANGLE;
+
+    int level = 0;
+
+    while(level < m_simplifiedMeshes.size() && m_simplifiedMeshes[level]->getNumberOfIndices()/3 >= numberOfTriangles)
+    {
+        level++;
+    }
+
+    return level;
+}
+
+/**
+ * Returns the number of levels of detail of the object, including the mesh itself.
+ * @brief getNumberOfLevelsOfDetail
+ * @return
+ */
+int Object::getNumberOfLevelsOfDetail() const
+{
+    return m_simplifiedMeshes.size()+1;
+}
+
+/**
+ * Returns the object mesh at a level of detail (0 is the mesh loaded, each level is coarser than the previous one).
+ * The mesh is shared with the other objects that use it and is not copied.
  * @brief getMesh
+ * @param level
  * @return
  */
-Mesh Object::getMesh() const
+const Mesh& Object::getMesh(int level) const
 {
-   return m_mesh;
+   if(level <= 0 || m_simplifiedMeshes.isEmpty())
+       return *m_mesh;
+
+   return *m_simplifiedMeshes[min(level, m_simplifiedMeshes.size())-1];
 }
 
 /**
- * Returns the object model matrix.
+ * Returns the object model matrix (applied after the mesh matrix).
  * @brief getModelMatrix
  * @return
  */
 QMatrix4x4 Object::getModelMatrix() const
 {
-    return m_modelMatrix;
+    return m_modelMatrix*m_meshMatrix;
 }
 
 
@@ -361,7 +564,7 @@ QMatrix4x4 Object::getModelMatrix() const
  */
 QVector<QVector2D> Object::getTextureCoordinates() const
 {
-    return m_mesh.getTextureCoordinates();
+    return m_mesh->getTextureCoordinates();
 }
 
 
@@ -370,9 +573,9 @@ QVector<QVector2D> Object::getTextureCoordinates() const
  * @brief getDiffuseTexture
  * @return
  */
-Texture Object::getDiffuseTexture() const
+const Texture& Object::getDiffuseTexture() const
 {
-    return m_diffuseTexture;
+    return *m_diffuseTexture;
 }
 
 /**
@@ -380,9 +583,9 @@ Texture Object::getDiffuseTexture() const
  * @brief getSpecularTexture
  * @return
  */
-Texture Object::getSpecularTexture() const
+const Texture& Object::getSpecularTexture() const
 {
-    return m_specularTexture;
+    return *m_specularTexture;
 }
 
 /**
@@ -390,9 +593,9 @@ Texture Object::getSpecularTexture() const
  * @brief getNormalMap
  * @return
  */
-Texture Object::getNormalMap() const
+const Texture& Object::getNormalMap() const
 {
-    return m_normalMap;
+    return *m_normalMap;
 }
 
 /**
@@ -400,7 +603,7 @@ Texture Object::getNormalMap() const
  * @brief getNormalMap
  * @return
  */
-Texture Object::getRoughnessMap() const
+const Texture& Object::getRoughnessMap() const
 {
-    return m_roughnessMap;
+    return *m_roughnessMap;
 }
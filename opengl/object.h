@@ -35,6 +35,7 @@
  * \date September, 1st, 2016
  *
  * Implementation of an Object. Stores the mesh and textures.
+ * The meshes and textures are shared with the other objects that use the same files (see ResourceRegistry).
  */
 
 
@@ -44,6 +45,7 @@
 #include "opengl/mesh.h"
 #include "opengl/material.h"
 #include "opengl/texture.h"
+#include "opengl/resourceregistry.h"
 
 #include <QApplication>
 #include <QVector3D>
@@ -52,6 +54,14 @@
 
 #include <string>
 #include <sstream>
+#include <memory>
+#include <functional>
+
+#define OBJECT_LOD_MAXIMUM_LEVELS 5 /*!< Maximum number of levels of detail of a mesh, including the mesh itself. */
+#define OBJECT_LOD_REDUCTION 0.25f /*!< Number of triangles of a level of detail relative to the finer level. */
+#define OBJECT_LOD_MINIMUM_TRIANGLES 1024 /*!< No level of detail is generated with less triangles. */
+#define OBJECT_LOD_MINIMUM_PROGRESS 0.9f /*!< The levels of detail stop when a simplification keeps more than this fraction of the triangles. */
+#define OBJECT_LOD_PIXELS_PER_TRIANGLE 2.0f /*!< Area in pixels of the projection of the object per triangle of the level of detail rendered. */
 
 class Object
 {
@@ -176,11 +186,61 @@ class Object
         bool loadRoughnessMap(const std::string filePath);
 
         /**
-         * Returns the object mesh.
+         * Loads the mesh of the object given a path of a mesh file (.off, .ply or .obj).
+         * The mesh is centered at the origin and scaled to the size of the square by the mesh matrix (the vertices are not modified).
+         * Returns true if the mesh was correctly loaded. The previous mesh is kept otherwise.
+         * @brief loadMesh
+         * @param filePath
+         * @return
+         */
+        bool loadMesh(const std::string filePath);
+
+        /**
+         * Generates the levels of detail of the mesh, each one with reduction times the triangles of the finer level,
+         * until maximumNumberOfLevels levels (including the mesh) or less than OBJECT_LOD_MINIMUM_TRIANGLES triangles.
+         * Each level is stored in a cache file next to the mesh file filePath and is only simplified again when the mesh file changes.
+         * @brief generateLevelsOfDetail
+         * @param filePath
+         * @param maximumNumberOfLevels
+         * @param reduction
+         */
+        void generateLevelsOfDetail(const std::string filePath, int maximumNumberOfLevels = OBJECT_LOD_MAXIMUM_LEVELS, float reduction = OBJECT_LOD_REDUCTION);
+
+        /**
+         * Switches the meshes of the object (and its levels of detail) between the float arrays and the compact vertex format.
+         * The compressed meshes are only built when the compact vertex format is first used, and the float meshes are released
+         * when no object uses them anymore.
+         * @brief setCompactVertices
+         * @param compactVertices
+         */
+        void setCompactVertices(bool compactVertices);
+
+        /**
+         * Returns the level of detail to render the object with : the coarsest level with at least one triangle
+         * per OBJECT_LOD_PIXELS_PER_TRIANGLE pixels of the projection of the bounding sphere of the object on the viewport.
+         * @brief levelOfDetail
+         * @param viewMatrix
+         * @param projectionMatrix
+         * @param viewportHeight
+         * @return
+         */
+        int levelOfDetail(const QMatrix4x4& viewMatrix, const QMatrix4x4& projectionMatrix, int viewportHeight) const;
+
+        /**
+         * Returns the number of levels of detail of the object, including the mesh itself.
+         * @brief getNumberOfLevelsOfDetail
+         * @return
+         */
+        int getNumberOfLevelsOfDetail() const;
+
+        /**
+         * Returns the object mesh at a level of detail (0 is the mesh loaded, each level is coarser than the previous one).
+         * The mesh is shared with the other objects that use it and is not copied.
          * @brief getMesh
+         * @param level
          * @return
          */
-        Mesh getMesh() const;
+        const Mesh& getMesh(int level = 0) const;
 
         /**
          * Returns the object material.
@@ -190,7 +250,7 @@ class Object
         Material getMaterial() const;
 
         /**
-         * Returns the object model matrix.
+         * Returns the object model matrix (applied after the mesh matrix).
          * @brief getModelMatrix
          * @return
          */
@@ -208,38 +268,45 @@ class Object
          * @brief getDiffuseTexture
          * @return
          */
-        Texture getDiffuseTexture() const;
+        const Texture& getDiffuseTexture() const;
 
         /**
          * Returns the object specular texture.
          * @brief getSpecularTexture
          * @return
          */
-        Texture getSpecularTexture() const;
+        const Texture& getSpecularTexture() const;
 
         /**
          * Returns the object normal map texture.
          * @brief getNormalMap
          * @return
          */
-        Texture getNormalMap() const;
+        const Texture& getNormalMap() const;
 
         /**
          * Returns the object roughness map texture.
          * @brief getNormalMap
          * @return
          */
-        Texture getRoughnessMap() const;
+        const Texture& getRoughnessMap() const;
 
     private:
-        Mesh m_mesh;/*!< Object mesh. */
+        std::shared_ptr<const Mesh> m_mesh;/*!< Object mesh. */
+        std::string m_meshKey; /*!< Key of the mesh in the registry (name of the object or path of the mesh file). */
+        std::function<bool(Mesh&)> m_loadMesh; /*!< Loads the mesh when it is not in the registry (empty for the objects without a mesh). */
+        bool m_compactVertices; /*!< Boolean that is true if the meshes are compressed for the compact vertex format. */
+        QVector<std::shared_ptr<const Mesh> > m_simplifiedMeshes; /*!< Levels of detail of the mesh from the finest to the coarsest (without the mesh itself). */
+        QVector3D m_boundingSphereCenter; /*!< Center of a sphere that contains the mesh (in the coordinates of the mesh). */
+        float m_boundingSphereRadius; /*!< Radius of a sphere that contains the mesh (in the coordinates of the mesh). */
         Material m_material; /*!< Object material */
         QMatrix4x4 m_modelMatrix; /*!< Object model matrix */
+        QMatrix4x4 m_meshMatrix; /*!< Matrix that centers the mesh at the origin and scales it to the size of the square. Applied before the model matrix. */
 
-        Texture m_diffuseTexture; /*!< Object diffuse texture */
-        Texture m_specularTexture; /*!< Object specular texture */
-        Texture m_normalMap; /*!< Object normal map */
-        Texture m_roughnessMap; /*!< Object roughness map */
+        std::shared_ptr<const Texture> m_diffuseTexture; /*!< Object diffuse texture */
+        std::shared_ptr<const Texture> m_specularTexture; /*!< Object specular texture */
+        std::shared_ptr<const Texture> m_normalMap; /*!< Object normal map */
+        std::shared_ptr<const Texture> m_roughnessMap; /*!< Object roughness map */
 };
 
 #endif // OBJECT_H
@@ -0,0 +1,207 @@
+/*
+ *     Real3D
+ *
+ *     Author:  Antoine TOISOUL LE CANN
+ *
+ *     Copyright © 2016 Antoine TOISOUL LE CANN, Imperial College London
+ *              All rights reserved
+ *
+ *
+ * Real3D is free software: you can redistribute it and/or modify
+ *
+ * it under the terms of the GNU Lesser General Public License as published by
+ *
+ * the Free Software Foundation, either version 3 of the License, or
+ *
+ * (at your option) any later version.
+ *
+ * Real3D is distributed in the hope that it will be useful,
+ *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ *
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * \file resourceregistry.cpp
+ * \brief Registry of the meshes and textures shared by the objects.
+ * \author Antoine Toisoul Le Cann
+ * \date October, 16th, 2026
+ *
+ * Loads each mesh and texture once and shares it between the objects that use it.
+ * The objects hold reference counted handles : a resource is released when the last object that uses it is destroyed.
+ */
+
+#include "opengl/resourceregistry.h"
+#include "other/datacache.h"
+
+using namespace std;
+
+map<string, ResourceRegistry::Entry<Mesh> > ResourceRegistry::m_meshes;
+map<string, ResourceRegistry::Entry<Mesh> > ResourceRegistry::m_compactMeshes;
+map<string, ResourceRegistry::Entry<Texture> > ResourceRegistry::m_textures;
+
+/**
+ * Returns the mesh of a mesh file (.off, .ply or .obj). The file is read only if no object uses it yet or if it changed since.
+ * Returns an empty handle if the file could not be read.
+ * @brief mesh
+ * @param filePath
+ * @return
+ */
+shared_ptr<const Mesh> ResourceRegistry::mesh(const string filePath)
+{
+    return mesh(filePath, [&](Mesh& mesh) { return mesh.readFile(filePath); });
+}
+
+/**
+ * Returns the mesh registered with a key. If no object uses it yet (or if the key is a file that changed since),
+ * the mesh is created by load. Returns an empty handle if load returns false.
+ * @brief mesh
+ * @param key
+ * @param load
+ * @return
+ */
+shared_ptr<const Mesh> ResourceRegistry::mesh(const string key, function<bool(Mesh&)> load)
+{
+    return findOrLoad<Mesh>(m_meshes, key, load, [](Mesh* mesh) { delete mesh; });
+}
+
+/**
+ * Returns the compressed mesh registered with a key for the compact vertex format (see Mesh::compress).
+ * If no object uses it yet, the mesh is copied from the mesh registered with the same key if an object uses it,
+ * or created by load otherwise, then compressed. Returns an empty handle if load returns false.
+ * @brief compactMesh
+ * @param key
+ * @param load
+ * @return
+ */
+shared_ptr<const Mesh> ResourceRegistry::compactMesh(const string key, function<bool(Mesh&)> load)
+{
+    function<bool(Mesh&)> loadAndCompress = [&](Mesh& mesh)
+    {
+        //The float mesh is not kept : it is released with the last object that uses it
+        map<string, Entry<Mesh> >::const_iterator entry = m_meshes.find(key);
+        shared_ptr<const Mesh> floatMesh = (entry != m_meshes.end()) ? entry->second.resource.lock() : shared_ptr<const Mesh>();
+
+        if(floatMesh)
+            mesh = *floatMesh;
+        else if(!load(mesh))
+            return false;
+
+        mesh.compress();
+        return true;
+    };
+
+    return findOrLoad<Mesh>(m_compactMeshes, key, loadAndCompress, [](Mesh* mesh) { delete mesh; });
+}
+
+/**
+ * Returns the texture of an image file (8 bits, or 32 bits floats for .pfm and .hdr files). The file is read and sent
+ * to the GPU only if no object uses it yet or if it changed since. The OpenGL texture is deleted when it is not used anymore.
+ * Returns an empty handle if the file could not be read.
+ * @brief texture
+ * @param filePath
+ * @return
+ */
+shared_ptr<const Texture> ResourceRegistry::texture(const string filePath)
+{
+    function<bool(Texture&)> load = [&](Texture& texture)
+    {
+        texture = Texture(filePath);
+
+        //PFM or Radiance HDR for HDR textures
+        string extension = filePath.substr(filePath.size() >= 3 ? filePath.size()-3 : 0);
+        if(extension == string("pfm") || extension == string("hdr"))
+        {
+            return texture.load_32FC3();
+        }
+
+        return texture.load_8UC3();
+    };
+
+    return findOrLoad<Texture>(m_textures, filePath, load, [](Texture* texture) { texture->release(); delete texture; });
+}
+
+/**
+ * Returns the number of meshes and textures used by the objects.
+ * @brief numberOfResources
+ * @return
+ */
+int ResourceRegistry::numberOfResources()
+{
+    int numberOfResources = 0;
+
+    for(map<string, Entry<Mesh> >::const_iterator it = m_meshes.begin() ; it != m_meshes.end() ; ++it)
+        numberOfResources += it->second.resource.expired() ? 0 : 1;
+
+    for(map<string, Entry<Mesh> >::const_iterator it = m_compactMeshes.begin() ; it != m_compactMeshes.end() ; ++it)
+        numberOfResources += it->second.resource.expired() ? 0 : 1;
+
+    for(map<string, Entry<Texture> >::const_iterator it = m_textures.begin() ; it != m_textures.end() ; ++it)
+        numberOfResources += it->second.resource.expired() ? 0 : 1;
+
+    return numberOfResources;
+}
+
+/**
+ * Returns the resource registered with a key if it is still used and its file did not change.
+ * Otherwise creates it with load and registers it. The resource is destroyed by destroy.
+ * @brief findOrLoad
+ * @param entries
+ * @param key
+ * @param load
+ * @param destroy
+ * @return
+ */
+template<typename T>
+shared_ptr<const T> ResourceRegistry::findOrLoad(map<string, Entry<T> >& entries, const string key,
+                                                 function<bool(T&)> load, function<void(T*)> destroy)
+{
+    //The keys that are not files have a size and a modification date of 0
+    uint64_t size = 0;
+    int64_t modificationTime = 0;
+    fileStatus(key, size, modificationTime);
+
+    typename map<string, Entry<T> >::iterator entry = entries.find(key);
+
+    if(entry != entries.end())
+    {
+        shared_ptr<const T> resource = entry->second.resource.lock();
+
+        if(resource && entry->second.size == size && entry->second.modificationTime == modificationTime)
+            return resource;
+    }
+
+    T* resource = new T();
+
+    if(!load(*resource))
+    {
+        destroy(resource);
+        return shared_ptr<const T>();
+    }
+
+    shared_ptr<const T> sharedResource(resource, [destroy](const T* resource) { destroy(const_cast<T*>(resource)); });
+
+    //The resources that are not used anymore are removed from the registry
+    for(entry = entries.begin() ; entry != entries.end() ; )
+    {
+        if(entry->second.resource.expired())
+            entries.erase(entry++);
+        else
+            ++entry;
+    }
+
+    //Loading a resource may have written its file (for example a mesh cache)
+    fileStatus(key, size, modificationTime);
+
+    Entry<T> newEntry = {sharedResource, size, modificationTime};
+    entries[key] = newEntry;
+
+    return sharedResource;
+}
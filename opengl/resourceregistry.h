@@ -0,0 +1,135 @@
+/*
+ *     Real3D
+ *
+ *     Author:  Antoine TOISOUL LE CANN
+ *
+ *     Copyright © 2016 Antoine TOISOUL LE CANN, Imperial College London
+ *              All rights reserved
+ *
+ *
+ * Real3D is free software: you can redistribute it and/or modify
+ *
+ * it under the terms of the GNU Lesser General Public License as published by
+ *
+ * the Free Software Foundation, either version 3 of the License, or
+ *
+ * (at your option) any later version.
+ *
+ * Real3D is distributed in the hope that it will be useful,
+ *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ *
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * \file resourceregistry.h
+ * \brief Registry of the meshes and textures shared by the objects.
+ * \author Antoine Toisoul Le Cann
+ * \date October, 16th, 2026
+ *
+ * Loads each mesh and texture once and shares it between the objects that use it.
+ * The objects hold reference counted handles : a resource is released when the last object that uses it is destroyed.
+ */
+
+#ifndef RESOURCEREGISTRY_H
+#define RESOURCEREGISTRY_H
+
+#include "opengl/mesh.h"
+#include "opengl/texture.h"
+
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+
+class ResourceRegistry
+{
+    public:
+        /**
+         * Returns the mesh of a mesh file (.off, .ply or .obj). The file is read only if no object uses it yet or if it changed since.
+         * Returns an empty handle if the file could not be read.
+         * @brief mesh
+         * @param filePath
+         * @return
+         */
+        static std::shared_ptr<const Mesh> mesh(const std::string filePath);
+
+        /**
+         * Returns the mesh registered with a key. If no object uses it yet (or if the key is a file that changed since),
+         * the mesh is created by load. Returns an empty handle if load returns false.
+         * @brief mesh
+         * @param key
+         * @param load
+         * @return
+         */
+        static std::shared_ptr<const Mesh> mesh(const std::string key, std::function<bool(Mesh&)> load);
+
+        /**
+         * Returns the compressed mesh registered with a key for the compact vertex format (see Mesh::compress).
+         * If no object uses it yet, the mesh is copied from the mesh registered with the same key if an object uses it,
+         * or created by load otherwise, then compressed. Returns an empty handle if load returns false.
+         * @brief compactMesh
+         * @param key
+         * @param load
+         * @return
+         */
+        static std::shared_ptr<const Mesh> compactMesh(const std::string key, std::function<bool(Mesh&)> load);
+
+        /**
+         * Returns the texture of an image file (8 bits, or 32 bits floats for .pfm and .hdr files). The file is read and sent
+         * to the GPU only if no object uses it yet or if it changed since. The OpenGL texture is deleted when it is not used anymore.
+         * Returns an empty handle if the file could not be read.
+         * @brief texture
+         * @param filePath
+         * @return
+         */
+        static std::shared_ptr<const Texture> texture(const std::string filePath);
+
+        /**
+         * Returns the number of meshes and textures used by the objects.
+         * @brief numberOfResources
+         * @return
+         */
+        static int numberOfResources();
+
+    private:
+        /**
+         * Resource of the registry : the resource is not kept alive by the registry, only by the objects.
+         * The size and the modification date of the file are compared to reload the resources of files that changed.
+         * @brief The Entry struct
+         */
+        template<typename T>
+        struct Entry
+        {
+            std::weak_ptr<const T> resource; /*!< Resource, expired when no object uses it. */
+            uint64_t size; /*!< Size of the file of the resource when it was loaded (0 if the key is not a file). */
+            int64_t modificationTime; /*!< Modification date of the file of the resource when it was loaded (0 if the key is not a file). */
+        };
+
+        /**
+         * Returns the resource registered with a key if it is still used and its file did not change.
+         * Otherwise creates it with load and registers it. The resource is destroyed by destroy.
+         * @brief findOrLoad
+         * @param entries
+         * @param key
+         * @param load
+         * @param destroy
+         * @return
+         */
+        template<typename T>
+        static std::shared_ptr<const T> findOrLoad(std::map<std::string, Entry<T> >& entries, const std::string key,
+                                                   std::function<bool(T&)> load, std::function<void(T*)> destroy);
+
+        static std::map<std::string, Entry<Mesh> > m_meshes; /*!< Meshes by file path or key. */
+        static std::map<std::string, Entry<Mesh> > m_compactMeshes; /*!< Compressed meshes by file path or key. */
+        static std::map<std::string, Entry<Texture> > m_textures; /*!< Textures by file path. */
+};
+
+#endif // RESOURCEREGISTRY_H
@@ -39,7 +39,92 @@
 
 #include "opengl/scene.h"
 
+#include <chrono>
+#include <functional>
+#include <sstream>
+
 using namespace std;
+using namespace cv;
+
+/**
+ * Loads a PFM or Radiance HDR image depending on the extension of the file.
+ * @brief loadFloatImage
+ * @param filePath
+ * @return
+ */
+static Mat loadFloatImage(const string filePath)
+{
+    bool isHDRFile = (filePath.size() >= 3 && filePath.substr(filePath.size()-3, 3) == string("hdr"));
+    return isHDRFile ? loadHDR(filePath) : loadPFMParallel(filePath);
+}
+
+/**
+ * Saves a PFM or Radiance HDR image depending on the extension of the file.
+ * @brief saveFloatImage
+ * @param image
+ * @param filePath
+ * @return
+ */
+static bool saveFloatImage(const Mat& image, const string filePath)
+{
+    bool isHDRFile = (filePath.size() >= 3 && filePath.substr(filePath.size()-3, 3) == string("hdr"));
+    return isHDRFile ? saveHDR(image, filePath) : savePFM(image, filePath);
+}
+
+/**
+ * Saves a PFM or Radiance HDR image depending on the extension of the file. The PFM files are written by the
+ * writer thread of savePFMAsync : the pixels of image must not be modified afterwards.
+ * @brief saveFloatImageAsync
+ * @param image
+ * @param filePath
+ */
+static void saveFloatImageAsync(const Mat& image, const string filePath)
+{
+    bool isHDRFile = (filePath.size() >= 3 && filePath.substr(filePath.size()-3, 3) == string("hdr"));
+
+    if(isHDRFile)
+        saveHDR(image, filePath);
+    else
+        savePFMAsync(image, filePath);
+}
+
+/**
+ * Loads a texture from the entry of the key in the cache. If the cache does not contain the key,
+ * the levels of the texture are generated by generateLevels, stored in the cache and loaded.
+ * The levels are the faces of a cubemap (see latLongToCubemap) if cubemap is true.
+ * The cache is not used if the key is 0 (the source file could not be hashed).
+ * Returns true if the texture was loaded.
+ * @brief loadCachedTexture
+ * @param cache
+ * @param key
+ * @param cubemap
+ * @param texture
+ * @param generateLevels
+ * @return
+ */
+static bool loadCachedTexture(DataCache& cache, const uint64_t key, const bool cubemap, Texture& texture, function<bool(vector<Mat>&)> generateLevels)
+{
+    DataCacheEntry entry;
+
+    if(key != 0 && cache.load(key, entry))
+    {
+        return cubemap ? texture.loadCubemapFromCacheEntry(entry) : texture.loadFromCacheEntry(entry);
+    }
+
+    vector<Mat> levels;
+
+    if(!generateLevels(levels))
+    {
+        return false;
+    }
+
+    if(key != 0)
+    {
+        cache.store(key, levels);
+    }
+
+    return cubemap ? texture.loadCubemapFromMat_32FC3(levels) : texture.loadMipChainFromMat_32FC3(levels);
+}
 
 /**
  * Default scene constructor.
@@ -49,7 +134,8 @@ using namespace std;
 Scene::Scene(): m_objects(QVector<Object>()), m_pointLights(QVector<Light>()),
     m_environmentMap(Texture("")),
     m_environmentMapRough(Texture("")),
-    m_environmentMapDiffuse(Texture(""))
+    m_environmentMapDiffuse(Texture("")), m_brdfLUT(Texture("")),
+    m_environmentMapRoughPrefilter(), m_environmentMapRoughBatch(), m_environmentMapRoughPath(""), m_environmentMapRoughKey(0), m_cacheDirectory("")
 {
 
     buildScene();
@@ -102,6 +188,19 @@ void Scene::removeObjects()
     m_objects.clear();
 }
 
+/**
+ * Switches the meshes of the objects between the float arrays and the compact vertex format (see Object::setCompactVertices).
+ * @brief setCompactVertices
+ * @param compactVertices
+ */
+void Scene::setCompactVertices(bool compactVertices)
+{
+    for(int k = 0 ; k<m_objects.size() ; k++)
+    {
+        m_objects[k].setCompactVertices(compactVertices);
+    }
+}
+
 /**
  * Reset the objects and the lights to their original position
  * @brief resetScene
@@ -355,8 +454,36 @@ bool Scene::loadRoughnessMap(const string filePath, const int objectNumber)
     return loaded;
 }
 
+/**
+ * Loads the mesh of object objectNumber from a .off, .ply or .obj file.
+ * returns true if the mesh was correctly loaded.
+ * @brief loadMesh
+ * @param filePath
+ * @param objectNumber
+ * @return
+ */
+bool Scene::loadMesh(const string filePath, const int objectNumber)
+{
+
+    bool loaded = false;
+
+    if(objectNumber<m_objects.size())
+    {
+        loaded = m_objects[objectNumber].loadMesh(filePath);
+    }
+
+    return loaded;
+}
+
 /**
  * Loads the environment map (EM), the EM with diffuse convolution and the EM for rough specular reflection.
+ * The EMs can be PFM or Radiance HDR files. The diffuse convolution is computed and saved if the file does not exist.
+ * The EM for rough specular reflection is a mip chain packed in one image (see packMipChain), one level per roughness.
+ * If the file does not exist, a preview of the mip chain is computed with a few samples : call refineEnvironmentMapRough
+ * to add samples progressively. A single latitude longitude map is used for every roughness.
+ * The EMs are resampled as cubemaps for the shaders (see latLongToCubemap) : the EM files stay latitude longitude maps.
+ * The textures are kept in a cache next to the EMs (see DataCache) : loading the same EMs again does not decode or compute anything.
+ * The table of the integral of the BRDF is computed (or read from the cache) with the first EM.
  * @brief loadEnvironmentMap
  * @param EMPath
  * @param EMDiffusePath
@@ -365,25 +492,249 @@ bool Scene::loadRoughnessMap(const string filePath, const int objectNumber)
  */
 bool Scene::loadEnvironmentMap(const string EMPath, const string EMDiffusePath, const string EMRoughPath)
 {
+    DataCache cache(cacheDirectory(EMPath));
+    const uint64_t EMHash = hashFile(EMPath);
+
+    //The EM is decoded once, only if a texture is not in the cache
+    Mat environmentMap;
+    auto decodeEnvironmentMap = [&]()
+    {
+        if(environmentMap.empty())
+        {
+            environmentMap = loadFloatImage(EMPath);
+        }
+
+        return !environmentMap.empty() && environmentMap.channels() == 3;
+    };
+
     //Sets the file path of the EM
     m_environmentMap = Texture(EMPath);
     m_environmentMapDiffuse = Texture(EMDiffusePath);
     m_environmentMapRough = Texture(EMRoughPath);
 
-    //Load the EMs
-    bool EMLoaded = m_environmentMap.load_32FC3();
-    bool EMRoughLoaded = m_environmentMapRough.load_32FC3();
-    bool EMDiffuseLoaded = m_environmentMapDiffuse.load_32FC3();
+    bool EMLoaded = loadCachedTexture(cache, cacheKey(EMHash, "environment map cubemap"), true, m_environmentMap, [&](vector<Mat>& levels)
+    {
+        if(!decodeEnvironmentMap())
+            return false;
+
+        levels.push_back(latLongToCubemap(environmentMap, cubemapFaceSize(environmentMap)));
+        return true;
+    });
+
+    //The diffuse convolution is computed and saved if it does not exist
+    bool EMDiffuseLoaded = false;
+    ifstream EMDiffuseFile(EMDiffusePath.c_str(), ios::in | ios::binary);
+
+    if(EMDiffuseFile)
+    {
+        EMDiffuseLoaded = loadCachedTexture(cache, cacheKey(hashFile(EMDiffusePath), "environment map cubemap"), true, m_environmentMapDiffuse, [&](vector<Mat>& levels)
+        {
+            Mat diffuse = loadFloatImage(EMDiffusePath);
+
+            if(diffuse.empty())
+                return false;
+
+            levels.push_back(latLongToCubemap(diffuse, cubemapFaceSize(diffuse)));
+            return !levels[0].empty();
+        });
+    }
+    else
+    {
+        ostringstream parameters;
+        parameters << "diffuse convolution " << EM_DIFFUSE_WIDTH << "x" << EM_DIFFUSE_HEIGHT << " cubemap";
+
+        EMDiffuseLoaded = loadCachedTexture(cache, cacheKey(EMHash, parameters.str()), true, m_environmentMapDiffuse, [&](vector<Mat>& levels)
+        {
+            if(!decodeEnvironmentMap())
+            {
+                cout << "Could not compute the diffuse convolution of : " << EMPath << endl;
+                return false;
+            }
+
+            cout << "Computing the diffuse convolution of : " << EMPath << endl;
+            Mat diffuse = diffuseConvolution(environmentMap);
+            saveFloatImage(diffuse, EMDiffusePath);
+
+            levels.push_back(latLongToCubemap(diffuse, cubemapFaceSize(diffuse)));
+            return true;
+        });
+    }
+
+    //The mip chain of the rough specular convolution is prefiltered progressively if it does not exist
+    //(waits for the batch of samples of the previous EM)
+    m_environmentMapRoughBatch = shared_future<vector<Mat> >();
+    m_environmentMapRoughPrefilter.reset();
+    m_environmentMapRoughPath = EMRoughPath;
+    m_cacheDirectory = cache.getDirectory();
+
+    bool EMRoughLoaded = false;
+    ifstream EMRoughFile(EMRoughPath.c_str(), ios::in | ios::binary);
+
+    if(EMRoughFile)
+    {
+        EMRoughLoaded = loadCachedTexture(cache, cacheKey(hashFile(EMRoughPath), "mip chain cubemap"), true, m_environmentMapRough, [&](vector<Mat>& levels)
+        {
+            vector<Mat> mipChain;
+
+            if(!unpackMipChain(loadFloatImage(EMRoughPath), mipChain))
+                return false;
+
+            latLongToCubemap(mipChain, levels);
+            return true;
+        });
+    }
+    else
+    {
+        ostringstream parameters;
+        parameters << "specular mip chain " << EM_SPECULAR_WIDTH << " " << EM_SPECULAR_LEVELS << " " << EM_SPECULAR_SAMPLES << " cubemap";
+        m_environmentMapRoughKey = cacheKey(EMHash, parameters.str());
+
+        DataCacheEntry entry;
 
-    return EMLoaded && EMRoughLoaded && EMDiffuseLoaded;
+        if(EMHash != 0 && cache.load(m_environmentMapRoughKey, entry))
+        {
+            EMRoughLoaded = m_environmentMapRough.loadCubemapFromCacheEntry(entry);
+        }
+        else if(decodeEnvironmentMap())
+        {
+            cout << "Prefiltering the rough specular convolution of : " << EMPath << endl;
+            m_environmentMapRoughPrefilter = make_shared<SpecularPrefilter>(environmentMap);
+            m_environmentMapRoughPrefilter->addSamples(EM_SPECULAR_PREVIEW_SAMPLES);
+
+            vector<Mat> mipChain, cubemapMipChain;
+            m_environmentMapRoughPrefilter->getMipChain(mipChain);
+            latLongToCubemap(mipChain, cubemapMipChain);
+            EMRoughLoaded = m_environmentMapRough.loadCubemapFromMat_32FC3(cubemapMipChain);
+        }
+    }
+
+    //The table of the integral of the BRDF does not depend on the EM
+    if(!m_brdfLUT.isLoaded())
+    {
+        ostringstream parameters;
+        parameters << "cook torrance beckmann brdf " << EM_BRDF_LUT_SIZE << " " << EM_BRDF_LUT_SAMPLES;
+
+        loadCachedTexture(cache, cacheKey(0, parameters.str()), false, m_brdfLUT, [&](vector<Mat>& levels)
+        {
+            cout << "Computing the integral of the BRDF" << endl;
+            levels.push_back(brdfIntegrationLUT());
+            return !levels[0].empty();
+        });
+
+        //The table is not periodic
+        glBindTexture(GL_TEXTURE_2D, m_brdfLUT.getTextureId());
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glBindTexture(GL_TEXTURE_2D, 0);
+    }
+
+    return EMLoaded && EMRoughLoaded && EMDiffuseLoaded && m_brdfLUT.isLoaded();
 }
 
 /**
- * Returns an array of objects.
+ * Refines the mip chain of the EM for rough specular reflection if it is being computed : the batches of samples are added
+ * on a worker thread, and this function only uploads a batch once it is finished then starts the next one.
+ * The mip chain is saved in the file given to loadEnvironmentMap and in the cache (on the worker thread) once all the samples are added.
+ * Returns true if more samples will be added by the next calls.
+ * @brief refineEnvironmentMapRough
+ * @return
+ */
+bool Scene::refineEnvironmentMapRough()
+{
+    if(!m_environmentMapRoughPrefilter)
+    {
+        return false;
+    }
+
+    if(m_environmentMapRoughBatch.valid())
+    {
+        //The previous cubemaps are rendered until the batch is finished
+        if(m_environmentMapRoughBatch.wait_for(chrono::seconds(0)) != future_status::ready)
+        {
+            return true;
+        }
+
+        m_environmentMapRough.loadCubemapFromMat_32FC3(m_environmentMapRoughBatch.get());
+        m_environmentMapRoughBatch = shared_future<vector<Mat> >();
+
+        if(m_environmentMapRoughPrefilter->getNumberOfSamples() >= EM_SPECULAR_SAMPLES)
+        {
+            m_environmentMapRoughPrefilter.reset();
+            return false;
+        }
+    }
+
+    //The worker thread only uses copies of the members : the scene can be modified while it runs
+    shared_ptr<SpecularPrefilter> prefilter = m_environmentMapRoughPrefilter;
+    const string filePath = m_environmentMapRoughPath;
+    const string cacheDirectory = m_cacheDirectory;
+    const uint64_t key = m_environmentMapRoughKey;
+
+    m_environmentMapRoughBatch = async(launch::async, [prefilter, filePath, cacheDirectory, key]()
+    {
+        prefilter->addSamples(EM_SPECULAR_PREVIEW_SAMPLES);
+
+        vector<Mat> mipChain, cubemapMipChain;
+        prefilter->getMipChain(mipChain);
+        latLongToCubemap(mipChain, cubemapMipChain);
+
+        if(prefilter->getNumberOfSamples() >= EM_SPECULAR_SAMPLES)
+        {
+            cout << "Saving the rough specular convolution : " << filePath << endl;
+            saveFloatImageAsync(packMipChain(mipChain), filePath);
+            DataCache(cacheDirectory).store(key, cubemapMipChain);
+        }
+
+        return cubemapMipChain;
+    }).share();
+
+    return true;
+}
+
+/**
+ * Returns the directory of the cache of the environment maps : the folder "Cache" next to the environment map EMPath.
+ * @brief cacheDirectory
+ * @param EMPath
+ * @return
+ */
+string Scene::cacheDirectory(const string EMPath)
+{
+    size_t separator = EMPath.find_last_of("/\\");
+
+    if(separator == string::npos)
+    {
+        return string("Cache");
+    }
+
+    return EMPath.substr(0, separator+1) + string("Cache");
+}
+
+/**
+ * Returns the path of an environment map given its path without the file extension.
+ * The Radiance HDR file (.hdr) is used if it exists, the PFM file (.pfm) otherwise.
+ * @brief environmentMapFilePath
+ * @param filePathNoExtension
+ * @return
+ */
+string Scene::environmentMapFilePath(const string filePathNoExtension)
+{
+    string HDRFilePath = filePathNoExtension + string(".hdr");
+    ifstream HDRFile(HDRFilePath.c_str(), ios::in | ios::binary);
+
+    if(HDRFile)
+    {
+        return HDRFilePath;
+    }
+
+    return filePathNoExtension + string(".pfm");
+}
+
+/**
+ * Returns the array of objects (without copy).
  * @brief getObjects
  * @return
  */
-QVector<Object> Scene::getObjects()
+const QVector<Object>& Scene::getObjects() const
 {
     return m_objects;
 }
@@ -419,6 +770,26 @@ GLuint Scene::getEnvironmentMapRoughId()
     return m_environmentMapRough.getTextureId();
 }
 
+/**
+ * Returns the number of mip levels of the environment map with rough specular convolution.
+ * @brief getEnvironmentMapRoughLevels
+ * @return
+ */
+int Scene::getEnvironmentMapRoughLevels()
+{
+    return m_environmentMapRough.getNumberOfLevels();
+}
+
+/**
+ * Returns the ID of the table of the integral of the BRDF used with the environment map with rough specular convolution.
+ * @brief getBRDFLUTId
+ * @return
+ */
+GLuint Scene::getBRDFLUTId()
+{
+    return m_brdfLUT.getTextureId();
+}
+
 
 /**
  * Returns the ID of the environment map with diffuse convolution.
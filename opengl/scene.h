@@ -42,10 +42,16 @@
 
 #include "opengl/object.h"
 #include "opengl/light.h"
+#include "maths/environmentmap.h"
+#include "other/datacache.h"
 
 #include <QVector>
 #include <QVector4D>
 
+#include <future>
+#include <memory>
+#include <vector>
+
 class Scene
 {
     public:
@@ -81,6 +87,13 @@ class Scene
          */
         void removeObjects();
 
+        /**
+         * Switches the meshes of the objects between the float arrays and the compact vertex format (see Object::setCompactVertices).
+         * @brief setCompactVertices
+         * @param compactVertices
+         */
+        void setCompactVertices(bool compactVertices);
+
         /*---Geometric transformations--*/
         /**
          * translate light source lightNumber along the X axis by the amount translationX.
@@ -204,8 +217,24 @@ class Scene
          */
         bool loadRoughnessMap(const std::string filePath, const int objectNumber);
 
+        /**
+         * Loads the mesh of object objectNumber from a .off, .ply or .obj file.
+         * returns true if the mesh was correctly loaded.
+         * @brief loadMesh
+         * @param filePath
+         * @param objectNumber
+         * @return
+         */
+        bool loadMesh(const std::string filePath, const int objectNumber);
+
         /**
          * Loads the environment map (EM), the EM with diffuse convolution and the EM for rough specular reflection.
+         * The EMs can be PFM or Radiance HDR files. The diffuse convolution is computed and saved if the file does not exist.
+         * The EM for rough specular reflection is a mip chain packed in one image (see packMipChain), one level per roughness.
+         * If the file does not exist, a preview of the mip chain is computed with a few samples : call refineEnvironmentMapRough
+         * to add samples progressively. A single latitude longitude map is used for every roughness.
+         * The textures are kept in a cache next to the EMs (see DataCache) : loading the same EMs again does not decode or compute anything.
+         * The table of the integral of the BRDF is computed (or read from the cache) with the first EM.
          * @brief loadEnvironmentMap
          * @param EMPath
          * @param EMDiffusePath
@@ -215,11 +244,38 @@ class Scene
         bool loadEnvironmentMap(const std::string EMPath, const std::string EMDiffusePath, const std::string EMRoughPath);
 
         /**
-         * Returns an array of objects.
+         * Refines the mip chain of the EM for rough specular reflection if it is being computed : the batches of samples are added
+         * on a worker thread, and this function only uploads a batch once it is finished then starts the next one.
+         * The mip chain is saved in the file given to loadEnvironmentMap and in the cache (on the worker thread) once all the samples are added.
+         * Returns true if more samples will be added by the next calls.
+         * @brief refineEnvironmentMapRough
+         * @return
+         */
+        bool refineEnvironmentMapRough();
+
+        /**
+         * Returns the directory of the cache of the environment maps : the folder "Cache" next to the environment map EMPath.
+         * @brief cacheDirectory
+         * @param EMPath
+         * @return
+         */
+        static std::string cacheDirectory(const std::string EMPath);
+
+        /**
+         * Returns the path of an environment map given its path without the file extension.
+         * The Radiance HDR file (.hdr) is used if it exists, the PFM file (.pfm) otherwise.
+         * @brief environmentMapFilePath
+         * @param filePathNoExtension
+         * @return
+         */
+        static std::string environmentMapFilePath(const std::string filePathNoExtension);
+
+        /**
+         * Returns the array of objects (without copy).
          * @brief getObjects
          * @return
          */
-        QVector<Object> getObjects();
+        const QVector<Object>& getObjects() const;
 
         /**
          * Returns an array of point light sources.
@@ -242,6 +298,20 @@ class Scene
          */
         GLuint getEnvironmentMapRoughId();
 
+        /**
+         * Returns the number of mip levels of the environment map with rough specular convolution.
+         * @brief getEnvironmentMapRoughLevels
+         * @return
+         */
+        int getEnvironmentMapRoughLevels();
+
+        /**
+         * Returns the ID of the table of the integral of the BRDF used with the environment map with rough specular convolution.
+         * @brief getBRDFLUTId
+         * @return
+         */
+        GLuint getBRDFLUTId();
+
         /**
          * Returns the ID of the environment map with diffuse convolution.
          * @brief getEnvironmentMapDiffuseId
@@ -252,9 +322,15 @@ class Scene
     private:
         QVector<Object> m_objects; /*!< Array of objects. */
         QVector<Light> m_pointLights; /*!< Array of point light sources. */
-        Texture m_environmentMap; /*!< Texture of the environment map (latitude longitude map). */
-        Texture m_environmentMapRough;  /*!< Texture of the environment map with rough specular convolution (latitude longitude map). */
-        Texture m_environmentMapDiffuse; /*!< Texture of the environment map with diffuse convolution (latitude longitude map). */
+        Texture m_environmentMap; /*!< Texture of the environment map (cubemap). */
+        Texture m_environmentMapRough;  /*!< Texture of the environment map with rough specular convolution (cubemap). */
+        Texture m_environmentMapDiffuse; /*!< Texture of the environment map with diffuse convolution (cubemap). */
+        Texture m_brdfLUT; /*!< Table of the integral of the Cook Torrance BRDF for the split sum approximation (see brdfIntegrationLUT). */
+        std::shared_ptr<SpecularPrefilter> m_environmentMapRoughPrefilter; /*!< Prefilter of the environment map while the rough specular convolution is refined (empty otherwise). */
+        std::shared_future<std::vector<cv::Mat> > m_environmentMapRoughBatch; /*!< Batch of samples being added on a worker thread : cubemap mip chain once finished. */
+        std::string m_environmentMapRoughPath; /*!< File where the rough specular convolution is saved once refined. */
+        uint64_t m_environmentMapRoughKey; /*!< Cache key of the rough specular convolution while it is refined. */
+        std::string m_cacheDirectory; /*!< Cache directory of the environment maps. */
 };
 
 #endif // SCENE_H
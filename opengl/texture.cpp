@@ -42,11 +42,47 @@
 using namespace std;
 using namespace cv;
 
+/**
+ * Sends an OpenCV image (BGR or grayscale, 8 bits or floats) to the mip level of the texture bound to GL_TEXTURE_2D
+ * or to a face of the cubemap bound to GL_TEXTURE_CUBE_MAP (target GL_TEXTURE_CUBE_MAP_POSITIVE_X + face).
+ * OpenCV stores the rows from the top to the bottom of the image and OpenGL from the bottom to the top :
+ * the rows are sent in the reverse order so that the image does not have to be flipped in memory.
+ * @brief texImage2DFlipped
+ * @param target
+ * @param internalFormat
+ * @param image
+ * @param level
+ */
+static void texImage2DFlipped(GLenum target, GLint internalFormat, const Mat& image, GLint level = 0)
+{
+    GLenum format = (image.channels() == 3) ? GL_BGR : GL_RED;
+    GLenum type = (image.depth() == CV_8U) ? GL_UNSIGNED_BYTE : GL_FLOAT;
+
+    //Allocate the texture then fill it row by row
+    glTexImage2D(target, level, internalFormat, image.cols, image.rows, 0, format, type, NULL);
+
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+    for(int i = 0 ; i<image.rows ; ++i)
+    {
+        glTexSubImage2D(target, level, 0, image.rows-1-i, image.cols, 1, format, type, image.ptr(i));
+    }
+
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+    if(image.channels() == 1)
+    {
+        //Grayscale images are replicated on the three color channels when sampled
+        GLint swizzle[4] = {GL_RED, GL_RED, GL_RED, GL_ONE};
+        glTexParameteriv(target == GL_TEXTURE_2D ? GL_TEXTURE_2D : GL_TEXTURE_CUBE_MAP, GL_TEXTURE_SWIZZLE_RGBA, swizzle);
+    }
+}
+
 /**
  * Texture default constructor.
  * @brief Texture
  */
-Texture::Texture(): m_textureId(0), m_filePath(""), m_isLoaded(false), m_width(0), m_height(0), m_numberOfComponents(0)
+Texture::Texture(): m_textureId(0), m_filePath(""), m_isLoaded(false), m_width(0), m_height(0), m_numberOfComponents(0), m_numberOfLevels(1)
 {
 
 }
@@ -56,7 +92,7 @@ Texture::Texture(): m_textureId(0), m_filePath(""), m_isLoaded(false), m_width(0
  * @brief Texture
  * @param filePath
  */
-Texture::Texture(string filePath): m_textureId(0), m_filePath(filePath), m_isLoaded(false), m_width(0), m_height(0), m_numberOfComponents(0)
+Texture::Texture(string filePath): m_textureId(0), m_filePath(filePath), m_isLoaded(false), m_width(0), m_height(0), m_numberOfComponents(0), m_numberOfLevels(1)
 {
 
 }
@@ -68,7 +104,7 @@ Texture::Texture(string filePath): m_textureId(0), m_filePath(filePath), m_isLoa
  * @param height
  * @param numberOfcomponents
  */
-Texture::Texture(int width, int height, int numberOfcomponents): m_textureId(0), m_filePath(string("")), m_isLoaded(false), m_width(width), m_height(height), m_numberOfComponents(numberOfcomponents)
+Texture::Texture(int width, int height, int numberOfcomponents): m_textureId(0), m_filePath(string("")), m_isLoaded(false), m_width(width), m_height(height), m_numberOfComponents(numberOfcomponents), m_numberOfLevels(1)
 {
 
 }
@@ -164,10 +200,14 @@ bool Texture::load_8UC3()
 
     //Load the texture in BGR format
     cout << m_filePath << endl;
-    Mat texture = imread(m_filePath, CV_LOAD_IMAGE_COLOR);
+    Mat image = imread(m_filePath, CV_LOAD_IMAGE_COLOR);
 
-    texture.convertTo(texture, CV_32FC3);
-    texture /= 255.0; //Divide by 255 to have float values
+    //Float values between 0 and 1 in a single pass
+    Mat texture;
+    if(image.data)
+    {
+        convert8UTo32F(image, texture, 1.0/255.0, 1.0);
+    }
 
     //If the texture cannot be loaded
     if(!texture.data)
@@ -181,6 +221,7 @@ bool Texture::load_8UC3()
         m_width = texture.cols;
         m_height = texture.rows;
         m_numberOfComponents = texture.channels();
+        m_numberOfLevels = 1;
 
         //Generate the texture id
         glGenTextures(1, &m_textureId);
@@ -188,17 +229,11 @@ bool Texture::load_8UC3()
         //Bind a texture 2D to the texture
         glBindTexture(GL_TEXTURE_2D, m_textureId);
 
-        //Send the data to the memory
-        Mat inversedTexture = texture.clone();
-
-        //The texture has to be inverted as the coordinate system for the (u,v) coordinate and the OpenCV image are different
-        inverseYAxis(texture, inversedTexture);
-
-        //The first GL_RGB says that the data used will be in the RGB format
+        //The texture is sent upside down as the coordinate system for the (u,v) coordinate and the OpenCV image are different
+        //GL_RGB says that the data used will be in the RGB format
         // !!!!!!!!!!!!!!!!!!!!!! GL_RGB clamps the texture between 0 and 1 range.
         // To use floats above 1 : us GL_RGB32F
-        //The second one says that texture.data is stored in BGR format (OpenCV)
-        glTexImage2D(GL_TEXTURE_2D , 0, GL_RGB, m_width, m_height, 0, GL_BGR, GL_FLOAT, inversedTexture.data);
+        texImage2DFlipped(GL_TEXTURE_2D, GL_RGB, texture);
 
         //Smooth close textures
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
@@ -216,7 +251,7 @@ bool Texture::load_8UC3()
 }
 
 /**
- * Load textures saved as PFM files.
+ * Load textures saved as PFM or Radiance HDR files.
  * Returns true if the texture has been correctly loaded.
  * @brief load_32FC3
  * @return
@@ -229,10 +264,69 @@ bool Texture::load_32FC3()
         glDeleteTextures(1, &m_textureId);
     }
 
-    //Load the texture in BGR format
     cout << m_filePath << endl;
-    Mat texture = loadPFM(m_filePath);
-    texture.convertTo(texture, CV_32FC3);
+
+    //Radiance HDR files are always decoded
+    bool isHDRFile = (m_filePath.size() >= 3 && m_filePath.substr(m_filePath.size()-3, 3) == string("hdr"));
+
+    //PFM files stored in the byte order of the machine without scale factor are mapped in memory and sent directly to OpenGL.
+    //The rows are stored from the bottom to the top of the image, as OpenGL expects, in RGB order : no copy is required.
+    MappedPFM mappedTexture;
+
+    if(!isHDRFile)
+    {
+        mappedTexture.open(m_filePath);
+    }
+
+    if(mappedTexture.isOpen() && mappedTexture.isNativeByteOrder() && mappedTexture.hasUnitScale())
+    {
+        const PFMHeader& header = mappedTexture.getHeader();
+
+        m_width = header.width;
+        m_height = header.height;
+        m_numberOfComponents = header.numberOfComponents;
+        m_numberOfLevels = 1;
+
+        //Generate the texture id
+        glGenTextures(1, &m_textureId);
+
+        //Bind a texture 2D to the texture
+        glBindTexture(GL_TEXTURE_2D, m_textureId);
+
+        //Rows of floats are always aligned on 4 bytes
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+        if(m_numberOfComponents == 3)
+        {
+            glTexImage2D(GL_TEXTURE_2D , 0, GL_RGB32F, m_width, m_height, 0, GL_RGB, GL_FLOAT, mappedTexture.getPixels());
+        }
+        else
+        {
+            //Grayscale images are replicated on the three color channels when sampled
+            GLint swizzle[4] = {GL_RED, GL_RED, GL_RED, GL_ONE};
+            glTexImage2D(GL_TEXTURE_2D , 0, GL_R32F, m_width, m_height, 0, GL_RED, GL_FLOAT, mappedTexture.getPixels());
+            glTexParameteriv(GL_TEXTURE_2D, GL_TEXTURE_SWIZZLE_RGBA, swizzle);
+        }
+
+        //Smooth close textures
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+
+        //Do not smooth textures that are far away (performance optimisation)
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+        //Unbind
+        glBindTexture(GL_TEXTURE_2D, 0);
+
+        //Texture correctly loaded
+        m_isLoaded = true;
+        return m_isLoaded;
+    }
+
+    //Otherwise the HDR or PFM file is decoded
+    mappedTexture.close();
+
+    //Load the texture in BGR format
+    Mat texture = isHDRFile ? loadHDR(m_filePath) : loadPFMParallel(m_filePath);
 
     //If the texture cannot be loaded
     if(!texture.data)
@@ -246,6 +340,7 @@ bool Texture::load_32FC3()
         m_width = texture.cols;
         m_height = texture.rows;
         m_numberOfComponents = texture.channels();
+        m_numberOfLevels = 1;
 
         //Generate the texture id
         glGenTextures(1, &m_textureId);
@@ -253,17 +348,9 @@ bool Texture::load_32FC3()
         //Bind a texture 2D to the texture
         glBindTexture(GL_TEXTURE_2D, m_textureId);
 
-        //Send the data to the memory
-        Mat inversedTexture = texture.clone();
-
-        //The texture has to be inverted as the coordinate system for the (u,v) coordinate and the OpenCV image are different
-        inverseYAxis(texture, inversedTexture);
-
-        //The first GL_RGB says that the data used will be in the RGB format
-        // !!!!!!!!!!!!!!!!!!!!!! GL_RGB clamps the texture between 0 and 1 range.
-        // To use floats above 1 : us GL_RGB32F
-        //The second one says that texture.data is stored in BGR format (OpenCV)
-        glTexImage2D(GL_TEXTURE_2D , 0, GL_RGB32F, m_width, m_height, 0, GL_BGR, GL_FLOAT, inversedTexture.data);
+        //The texture is sent upside down as the coordinate system for the (u,v) coordinate and the OpenCV image are different
+        //GL_RGB32F keeps the values above 1 (GL_RGB clamps the texture between 0 and 1 range)
+        texImage2DFlipped(GL_TEXTURE_2D, m_numberOfComponents == 3 ? GL_RGB32F : GL_R32F, texture);
 
 
         //Smooth close textures
@@ -308,6 +395,7 @@ bool Texture::loadFromMat_32FC3(Mat &matrix)
         m_width = matrix.cols;
         m_height = matrix.rows;
         m_numberOfComponents = matrix.channels();
+        m_numberOfLevels = 1;
 
         //Generate the texture id
         glGenTextures(1, &m_textureId);
@@ -315,17 +403,9 @@ bool Texture::loadFromMat_32FC3(Mat &matrix)
         //Bind a texture 2D to the texture
         glBindTexture(GL_TEXTURE_2D, m_textureId);
 
-        //Send the data to the memory
-        Mat inversedTexture = matrix.clone();
-
-        //The texture has to be inverted as the coordinate system for the (u,v) coordinate and the OpenCV image are different
-        inverseYAxis(matrix, inversedTexture);
-
-        //The first GL_RGB says that the data used will be in the RGB format
-        // !!!!!!!!!!!!!!!!!!!!!! GL_RGB clamps the texture between 0 and 1 range.
-        // To use floats above 1 : us GL_RGB32F
-        //The second one says that texture.data is stored in BGR format (OpenCV)
-        glTexImage2D(GL_TEXTURE_2D , 0, GL_RGB32F, m_width, m_height, 0, GL_BGR, GL_FLOAT, inversedTexture.data);
+        //The texture is sent upside down as the coordinate system for the (u,v) coordinate and the OpenCV image are different
+        //GL_RGB32F keeps the values above 1 (GL_RGB clamps the texture between 0 and 1 range)
+        texImage2DFlipped(GL_TEXTURE_2D, m_numberOfComponents == 3 ? GL_RGB32F : GL_R32F, matrix);
 
         //Smooth close textures
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
@@ -343,6 +423,253 @@ bool Texture::loadFromMat_32FC3(Mat &matrix)
 }
 
 
+/**
+ * Load a mip chain from opencv matrices (CV_32FC3 or CV_32FC1) : the level l is the level 0 divided by 2^l.
+ * The texture is sampled with trilinear interpolation between the levels.
+ * Returns true if the texture has been correctly loaded.
+ * @brief loadMipChainFromMat_32FC3
+ * @param mipChain
+ * @return
+ */
+bool Texture::loadMipChainFromMat_32FC3(const vector<Mat>& mipChain)
+{
+    //remove an eventual previous picture from the memory
+    if(glIsTexture(m_textureId) == GL_TRUE)
+    {
+        glDeleteTextures(1, &m_textureId);
+    }
+
+    if(mipChain.empty() || !mipChain[0].data)
+    {
+        cout << "Could not load from empty mip chain " << endl;
+        m_isLoaded = false;
+        return m_isLoaded;
+    }
+
+    m_width = mipChain[0].cols;
+    m_height = mipChain[0].rows;
+    m_numberOfComponents = mipChain[0].channels();
+    m_numberOfLevels = (int) mipChain.size();
+
+    //Generate the texture id
+    glGenTextures(1, &m_textureId);
+
+    //Bind a texture 2D to the texture
+    glBindTexture(GL_TEXTURE_2D, m_textureId);
+
+    for(int l = 0 ; l<m_numberOfLevels ; ++l)
+    {
+        texImage2DFlipped(GL_TEXTURE_2D, m_numberOfComponents == 3 ? GL_RGB32F : GL_R32F, mipChain[l], l);
+    }
+
+    //Only the levels given are used
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, 0);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, m_numberOfLevels-1);
+
+    //Trilinear interpolation between the levels
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, m_numberOfLevels > 1 ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+    //Unbind
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    //Texture correctly loaded
+    m_isLoaded = true;
+    return m_isLoaded;
+}
+
+/**
+ * Load a texture (and its mip levels) from an entry of the cache. The pixels are sent directly from the mapped file.
+ * Returns true if the texture has been correctly loaded.
+ * @brief loadFromCacheEntry
+ * @param entry
+ * @return
+ */
+bool Texture::loadFromCacheEntry(const DataCacheEntry& entry)
+{
+    //remove an eventual previous picture from the memory
+    if(glIsTexture(m_textureId) == GL_TRUE)
+    {
+        glDeleteTextures(1, &m_textureId);
+    }
+
+    if(!entry.isOpen())
+    {
+        cout << "Could not load from the cache entry " << endl;
+        m_isLoaded = false;
+        return m_isLoaded;
+    }
+
+    m_width = entry.getWidth(0);
+    m_height = entry.getHeight(0);
+    m_numberOfComponents = entry.getNumberOfComponents();
+    m_numberOfLevels = entry.getNumberOfLevels();
+
+    //Generate the texture id
+    glGenTextures(1, &m_textureId);
+
+    //Bind a texture 2D to the texture
+    glBindTexture(GL_TEXTURE_2D, m_textureId);
+
+    //The rows are stored from the bottom to the top in RGB order : no conversion is required
+    for(int l = 0 ; l<m_numberOfLevels ; ++l)
+    {
+        if(m_numberOfComponents == 3)
+            glTexImage2D(GL_TEXTURE_2D, l, GL_RGB32F, entry.getWidth(l), entry.getHeight(l), 0, GL_RGB, GL_FLOAT, entry.getPixels(l));
+        else
+            glTexImage2D(GL_TEXTURE_2D, l, GL_R32F, entry.getWidth(l), entry.getHeight(l), 0, GL_RED, GL_FLOAT, entry.getPixels(l));
+    }
+
+    if(m_numberOfComponents == 1)
+    {
+        //Grayscale images are replicated on the three color channels when sampled
+        GLint swizzle[4] = {GL_RED, GL_RED, GL_RED, GL_ONE};
+        glTexParameteriv(GL_TEXTURE_2D, GL_TEXTURE_SWIZZLE_RGBA, swizzle);
+    }
+
+    //Only the levels given are used
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, 0);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, m_numberOfLevels-1);
+
+    //Trilinear interpolation between the levels
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, m_numberOfLevels > 1 ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+    //Unbind
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    //Texture correctly loaded
+    m_isLoaded = true;
+    return m_isLoaded;
+}
+
+/**
+ * Load a cubemap and its mip levels from opencv matrices (CV_32FC3 or CV_32FC1). Each level stores the six faces side by side
+ * in the order +X, -X, +Y, -Y, +Z, -Z (see latLongToCubemap) and the faces of the level l are the faces of the level 0 divided by 2^l.
+ * The cubemap is sampled with trilinear interpolation between the levels.
+ * Returns true if the texture has been correctly loaded.
+ * @brief loadCubemapFromMat_32FC3
+ * @param mipChain
+ * @return
+ */
+bool Texture::loadCubemapFromMat_32FC3(const vector<Mat>& mipChain)
+{
+    //remove an eventual previous picture from the memory
+    if(glIsTexture(m_textureId) == GL_TRUE)
+    {
+        glDeleteTextures(1, &m_textureId);
+    }
+
+    if(mipChain.empty() || !mipChain[0].data || mipChain[0].cols != 6*mipChain[0].rows)
+    {
+        cout << "Could not load the cubemap from an empty mip chain or from faces that are not square " << endl;
+        m_isLoaded = false;
+        return m_isLoaded;
+    }
+
+    m_width = mipChain[0].rows;
+    m_height = mipChain[0].rows;
+    m_numberOfComponents = mipChain[0].channels();
+    m_numberOfLevels = (int) mipChain.size();
+
+    //Generate the texture id
+    glGenTextures(1, &m_textureId);
+
+    //Bind a cubemap to the texture
+    glBindTexture(GL_TEXTURE_CUBE_MAP, m_textureId);
+
+    for(int l = 0 ; l<m_numberOfLevels ; ++l)
+    {
+        const int faceSize = mipChain[l].rows;
+
+        for(int f = 0 ; f<6 ; ++f)
+        {
+            texImage2DFlipped(GL_TEXTURE_CUBE_MAP_POSITIVE_X+f, m_numberOfComponents == 3 ? GL_RGB32F : GL_R32F,
+                              mipChain[l](Rect(f*faceSize, 0, faceSize, faceSize)), l);
+        }
+    }
+
+    setCubemapParameters();
+
+    //Unbind
+    glBindTexture(GL_TEXTURE_CUBE_MAP, 0);
+
+    //Texture correctly loaded
+    m_isLoaded = true;
+    return m_isLoaded;
+}
+
+/**
+ * Load a cubemap (and its mip levels) from an entry of the cache created from the levels given to loadCubemapFromMat_32FC3.
+ * The pixels of each face are sent directly from the mapped file.
+ * Returns true if the texture has been correctly loaded.
+ * @brief loadCubemapFromCacheEntry
+ * @param entry
+ * @return
+ */
+bool Texture::loadCubemapFromCacheEntry(const DataCacheEntry& entry)
+{
+    //remove an eventual previous picture from the memory
+    if(glIsTexture(m_textureId) == GL_TRUE)
+    {
+        glDeleteTextures(1, &m_textureId);
+    }
+
+    if(!entry.isOpen() || entry.getWidth(0) != 6*entry.getHeight(0))
+    {
+        cout << "Could not load the cubemap from the cache entry " << endl;
+        m_isLoaded = false;
+        return m_isLoaded;
+    }
+
+    m_width = entry.getHeight(0);
+    m_height = entry.getHeight(0);
+    m_numberOfComponents = entry.getNumberOfComponents();
+    m_numberOfLevels = entry.getNumberOfLevels();
+
+    //Generate the texture id
+    glGenTextures(1, &m_textureId);
+
+    //Bind a cubemap to the texture
+    glBindTexture(GL_TEXTURE_CUBE_MAP, m_textureId);
+
+    //The rows are stored from the bottom to the top in RGB order : each face is read from the rows of the level
+    for(int l = 0 ; l<m_numberOfLevels ; ++l)
+    {
+        const int faceSize = entry.getHeight(l);
+        glPixelStorei(GL_UNPACK_ROW_LENGTH, entry.getWidth(l));
+
+        for(int f = 0 ; f<6 ; ++f)
+        {
+            glPixelStorei(GL_UNPACK_SKIP_PIXELS, f*faceSize);
+
+            if(m_numberOfComponents == 3)
+                glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X+f, l, GL_RGB32F, faceSize, faceSize, 0, GL_RGB, GL_FLOAT, entry.getPixels(l));
+            else
+                glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X+f, l, GL_R32F, faceSize, faceSize, 0, GL_RED, GL_FLOAT, entry.getPixels(l));
+        }
+    }
+
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+    glPixelStorei(GL_UNPACK_SKIP_PIXELS, 0);
+
+    if(m_numberOfComponents == 1)
+    {
+        //Grayscale images are replicated on the three color channels when sampled
+        GLint swizzle[4] = {GL_RED, GL_RED, GL_RED, GL_ONE};
+        glTexParameteriv(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_SWIZZLE_RGBA, swizzle);
+    }
+
+    setCubemapParameters();
+
+    //Unbind
+    glBindTexture(GL_TEXTURE_CUBE_MAP, 0);
+
+    //Texture correctly loaded
+    m_isLoaded = true;
+    return m_isLoaded;
+}
+
 /**
  * Set the filename of the texture.
  * @brief setFileName
@@ -395,6 +722,16 @@ int Texture::getHeight() const
     return m_height;
 }
 
+/**
+ * Returns the number of mip levels of the texture.
+ * @brief getNumberOfLevels
+ * @return
+ */
+int Texture::getNumberOfLevels() const
+{
+    return m_numberOfLevels;
+}
+
 /**
  * Return true if the texture was loaded previously.
  * @brief isLoaded
@@ -404,3 +741,48 @@ bool Texture::isLoaded() const
 {
     return m_isLoaded;
 }
+
+/**
+ * Returns the path to the image file of the texture.
+ * @brief getFilePath
+ * @return
+ */
+string Texture::getFilePath() const
+{
+    return m_filePath;
+}
+
+/**
+ * Deletes the OpenGL texture. The copies of the texture share its ID : only the last one must release it.
+ * @brief release
+ */
+void Texture::release()
+{
+    if(glIsTexture(m_textureId) == GL_TRUE)
+    {
+        glDeleteTextures(1, &m_textureId);
+    }
+
+    m_textureId = 0;
+    m_isLoaded = false;
+}
+
+/**
+ * Sets the filtering of the cubemap bound to GL_TEXTURE_CUBE_MAP : trilinear interpolation between its levels
+ * and no wrapping, the faces are joined by GL_TEXTURE_CUBE_MAP_SEAMLESS.
+ * @brief setCubemapParameters
+ */
+void Texture::setCubemapParameters()
+{
+    //Only the levels given are used
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_BASE_LEVEL, 0);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAX_LEVEL, m_numberOfLevels-1);
+
+    //Trilinear interpolation between the levels
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, m_numberOfLevels > 1 ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+}
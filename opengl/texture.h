@@ -42,6 +42,7 @@
 
 #include <iostream>
 #include <string>
+#include <vector>
 
 #include <QApplication>
 
@@ -53,6 +54,7 @@
 #include "opencv2/imgproc/imgproc.hpp"
 
 #include "maths/imageprocessing.h"
+#include "other/datacache.h"
 
 class Texture
 {
@@ -108,7 +110,7 @@ class Texture
         bool load_8UC3();
 
         /**
-         * Load textures saved as PFM files.
+         * Load textures saved as PFM or Radiance HDR files.
          * Returns true if the texture has been correctly loaded.
          * @brief load_32FC3
          * @return
@@ -124,6 +126,46 @@ class Texture
          */
         bool loadFromMat_32FC3(cv::Mat &matrix);
 
+        /**
+         * Load a mip chain from opencv matrices (CV_32FC3 or CV_32FC1) : the level l is the level 0 divided by 2^l.
+         * The texture is sampled with trilinear interpolation between the levels.
+         * Returns true if the texture has been correctly loaded.
+         * @brief loadMipChainFromMat_32FC3
+         * @param mipChain
+         * @return
+         */
+        bool loadMipChainFromMat_32FC3(const std::vector<cv::Mat>& mipChain);
+
+        /**
+         * Load a texture (and its mip levels) from an entry of the cache. The pixels are sent directly from the mapped file.
+         * Returns true if the texture has been correctly loaded.
+         * @brief loadFromCacheEntry
+         * @param entry
+         * @return
+         */
+        bool loadFromCacheEntry(const DataCacheEntry& entry);
+
+        /**
+         * Load a cubemap and its mip levels from opencv matrices (CV_32FC3 or CV_32FC1). Each level stores the six faces side by side
+         * in the order +X, -X, +Y, -Y, +Z, -Z (see latLongToCubemap) and the faces of the level l are the faces of the level 0 divided by 2^l.
+         * The cubemap is sampled with trilinear interpolation between the levels.
+         * Returns true if the texture has been correctly loaded.
+         * @brief loadCubemapFromMat_32FC3
+         * @param mipChain
+         * @return
+         */
+        bool loadCubemapFromMat_32FC3(const std::vector<cv::Mat>& mipChain);
+
+        /**
+         * Load a cubemap (and its mip levels) from an entry of the cache created from the levels given to loadCubemapFromMat_32FC3.
+         * The pixels of each face are sent directly from the mapped file.
+         * Returns true if the texture has been correctly loaded.
+         * @brief loadCubemapFromCacheEntry
+         * @param entry
+         * @return
+         */
+        bool loadCubemapFromCacheEntry(const DataCacheEntry& entry);
+
         /**
          * Set the filename of the texture.
          * @brief setFileName
@@ -159,6 +201,13 @@ class Texture
          */
         int getHeight() const;
 
+        /**
+         * Returns the number of mip levels of the texture.
+         * @brief getNumberOfLevels
+         * @return
+         */
+        int getNumberOfLevels() const;
+
         /**
          * Return true if the texture was loaded previously.
          * @brief isLoaded
@@ -166,8 +215,28 @@ class Texture
          */
         bool isLoaded() const;
 
+        /**
+         * Returns the path to the image file of the texture.
+         * @brief getFilePath
+         * @return
+         */
+        std::string getFilePath() const;
+
+        /**
+         * Deletes the OpenGL texture. The copies of the texture share its ID : only the last one must release it.
+         * @brief release
+         */
+        void release();
+
 
     private:
+        /**
+         * Sets the filtering of the cubemap bound to GL_TEXTURE_CUBE_MAP : trilinear interpolation between its levels
+         * and no wrapping, the faces are joined by GL_TEXTURE_CUBE_MAP_SEAMLESS.
+         * @brief setCubemapParameters
+         */
+        void setCubemapParameters();
+
         GLuint m_textureId; /*!< Texture ID. */
         std::string m_filePath; /*!< Path to the texture image file. */
         bool m_isLoaded; /*!< Boolean that tells if the texture has previously been loaded. */
@@ -175,6 +244,7 @@ class Texture
         int m_width; /*!< Width of the texture */
         int m_height; /*!< Height of the texture */
         int m_numberOfComponents; /*!< Number of color channels of the texture */
+        int m_numberOfLevels; /*!< Number of mip levels of the texture */
 
 };
 
@@ -0,0 +1,522 @@
+/*
+ *     Real3D
+ *
+ *     Author:  Antoine TOISOUL LE CANN
+ *
+ *     Copyright © 2016 Antoine TOISOUL LE CANN, Imperial College London
+ *              All rights reserved
+ *
+ *
+ * Real3D is free software: you can redistribute it and/or modify
+ *
+ * it under the terms of the GNU Lesser General Public License as published by
+ *
+ * the Free Software Foundation, either version 3 of the License, or
+ *
+ * (at your option) any later version.
+ *
+ * Real3D is distributed in the hope that it will be useful,
+ *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ *
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * \file HDRReadWrite.cpp
+ * \brief Implementation of loadHDR and saveHDR functions.
+ * \author Antoine Toisoul Le Cann
+ * \date October, 16th, 2026
+ *
+ * Reads and writes Radiance RGBE (.hdr) images with run length encoded scanlines.
+ */
+
+#include "HDRReadWrite.h"
+
+#include <algorithm>
+#include <sstream>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define HDR_USE_SSE2
+#endif
+
+using namespace std;
+using namespace cv;
+
+#define HDR_MIN_RUN_LENGTH 4 /*!< Shortest run of identical bytes stored as a run by saveHDR. */
+
+/**
+ * Decodes width RGBE pixels to floating point BGR pixels.
+ * A pixel (r,g,b,e) is (b,g,r)*2^(e-136). Exponents below 10 give values below 2^-126 that are flushed to zero.
+ * @brief decodeRGBE
+ * @param rgbe
+ * @param bgr
+ * @param width
+ */
+static void decodeRGBE(const unsigned char* rgbe, float* bgr, int width)
+{
+    int j = 0;
+
+#ifdef HDR_USE_SSE2
+    //4 pixels per iteration. Each pixel is stored with 4 floats : the last one is overwritten by the next pixel.
+    //The loop stops before the last pixel of the row so that no float is written past the end of the row.
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i minimumExponent = _mm_set1_epi32(9);
+
+    for( ; j+4<width ; j += 4)
+    {
+        __m128i pixels = _mm_loadu_si128((const __m128i*) (rgbe+4*j));
+        __m128i low = _mm_unpacklo_epi8(pixels, zero);
+        __m128i high = _mm_unpackhi_epi8(pixels, zero);
+
+        __m128i pixel[4] = {_mm_unpacklo_epi16(low, zero), _mm_unpackhi_epi16(low, zero),
+                            _mm_unpacklo_epi16(high, zero), _mm_unpackhi_epi16(high, zero)};
+
+        for(int k = 0 ; k<4 ; ++k)
+        {
+            //2^(e-136) is built directly from its exponent bits
+            __m128i exponent = _mm_shuffle_epi32(pixel[k], _MM_SHUFFLE(3,3,3,3));
+            __m128i factor = _mm_slli_epi32(_mm_sub_epi32(exponent, minimumExponent), 23);
+            factor = _mm_and_si128(factor, _mm_cmpgt_epi32(exponent, minimumExponent));
+
+            __m128 color = _mm_mul_ps(_mm_cvtepi32_ps(pixel[k]), _mm_castsi128_ps(factor));
+
+            //RGB to BGR
+            _mm_storeu_ps(bgr+3*(j+k), _mm_shuffle_ps(color, color, _MM_SHUFFLE(3,0,1,2)));
+        }
+    }
+#endif
+
+    for( ; j<width ; ++j)
+    {
+        const unsigned char* pixel = rgbe+4*j;
+
+        if(pixel[3] > 9)
+        {
+            float factor = ldexp(1.0f, (int) pixel[3]-136);
+            bgr[3*j] = pixel[2]*factor;
+            bgr[3*j+1] = pixel[1]*factor;
+            bgr[3*j+2] = pixel[0]*factor;
+        }
+        else
+        {
+            bgr[3*j] = bgr[3*j+1] = bgr[3*j+2] = 0.0f;
+        }
+    }
+}
+
+/**
+ * Decodes a flat or old style run length encoded scanline in rgbe.
+ * In old style scanlines, a pixel (1,1,1,n) repeats the previous pixel n times (n is shifted by 8 bits for consecutive runs).
+ * Returns false if the data ends before the end of the scanline.
+ * @brief readFlatScanline
+ * @param data
+ * @param end
+ * @param rgbe
+ * @param width
+ * @return
+ */
+static bool readFlatScanline(const unsigned char*& data, const unsigned char* end, unsigned char* rgbe, int width)
+{
+    int shift = 0;
+    int j = 0;
+
+    while(j<width)
+    {
+        if(end-data < 4)
+            return false;
+
+        if(data[0] == 1 && data[1] == 1 && data[2] == 1)
+        {
+            //A run cannot start the scanline
+            if(j == 0)
+                return false;
+
+            int count = min((int) (data[3] << shift), width-j);
+
+            for(int k = 0 ; k<count ; ++k, ++j)
+            {
+                memcpy(rgbe+4*j, rgbe+4*(j-1), 4);
+            }
+
+            shift += 8;
+        }
+        else
+        {
+            memcpy(rgbe+4*j, data, 4);
+            ++j;
+            shift = 0;
+        }
+
+        data += 4;
+    }
+
+    return true;
+}
+
+/**
+ * Decodes a scanline in rgbe. Adaptive run length encoded scanlines store the 4 components separately.
+ * Returns false if the scanline is corrupted.
+ * @brief readScanline
+ * @param data
+ * @param end
+ * @param rgbe
+ * @param width
+ * @param component
+ * @return
+ */
+static bool readScanline(const unsigned char*& data, const unsigned char* end, unsigned char* rgbe, int width, vector<unsigned char>& component)
+{
+    //Adaptive run length encoding starts with 2 2 and the width on 15 bits
+    if(width < 8 || width > 0x7fff || end-data < 4 || data[0] != 2 || data[1] != 2 || (data[2] & 0x80))
+    {
+        return readFlatScanline(data, end, rgbe, width);
+    }
+
+    if(((data[2] << 8) | data[3]) != width)
+        return false;
+
+    data += 4;
+
+    for(int c = 0 ; c<4 ; ++c)
+    {
+        int j = 0;
+
+        while(j<width)
+        {
+            if(data >= end)
+                return false;
+
+            int count = *data++;
+
+            if(count > 128)
+            {
+                //Run of the same value
+                count -= 128;
+
+                if(count > width-j || data >= end)
+                    return false;
+
+                memset(&component[j], *data++, count);
+            }
+            else
+            {
+                //Sequence of different values
+                if(count == 0 || count > width-j || end-data < count)
+                    return false;
+
+                memcpy(&component[j], data, count);
+                data += count;
+            }
+
+            j += count;
+        }
+
+        for(j = 0 ; j<width ; ++j)
+        {
+            rgbe[4*j+c] = component[j];
+        }
+    }
+
+    return true;
+}
+
+/**
+ * Loads a Radiance RGBE (.hdr) image and returns the image as an OpenCV Mat (CV_32FC3 in BGR format).
+ * Flat, old style and adaptive run length encoded scanlines are supported.
+ * Returns an empty Mat if the file cannot be read.
+ * @brief loadHDR
+ * @param filePath
+ * @return
+ */
+Mat loadHDR(const string filePath)
+{
+    //Open the file as binary and read it at once
+    ifstream file(filePath.c_str(), ios::in | ios::binary);
+
+    if(!file)
+    {
+        cerr << "Could not open the file : " << filePath << endl;
+        return Mat();
+    }
+
+    file.seekg(0, ios::end);
+    streamoff fileSize = file.tellg();
+    file.seekg(0, ios::beg);
+
+    vector<unsigned char> content((size_t) max(fileSize, (streamoff) 0));
+
+    if(content.empty() || !file.read((char*) &content[0], content.size()))
+    {
+        cerr << "Could not read the file : " << filePath << endl;
+        return Mat();
+    }
+
+    file.close();
+
+    const unsigned char* data = &content[0];
+    const unsigned char* end = data + content.size();
+
+    //The header is a list of lines ended by an empty line
+    if(content.size() < 2 || data[0] != '#' || data[1] != '?')
+    {
+        cerr << "Not a Radiance HDR file : " << filePath << endl;
+        return Mat();
+    }
+
+    string line;
+    bool emptyLine = false;
+
+    while(!emptyLine)
+    {
+        const unsigned char* lineEnd = find(data, end, (unsigned char) '\n');
+
+        if(lineEnd == end)
+        {
+            cerr << "Incomplete HDR header : " << filePath << endl;
+            return Mat();
+        }
+
+        line.assign((const char*) data, (const char*) lineEnd);
+        data = lineEnd+1;
+        emptyLine = line.empty();
+
+        if(line.compare(0, 7, "FORMAT=") == 0 && line != "FORMAT=32-bit_rle_rgbe")
+        {
+            cerr << "Unsupported HDR format " << line.substr(7) << " : " << filePath << endl;
+            return Mat();
+        }
+    }
+
+    //Resolution : -Y height +X width for images stored from top to bottom, +Y height +X width from bottom to top
+    const unsigned char* lineEnd = find(data, end, (unsigned char) '\n');
+    istringstream resolution(string((const char*) data, (const char*) lineEnd));
+    data = min(lineEnd+1, end);
+
+    string axisY, axisX;
+    int width(0), height(0);
+    resolution >> axisY >> height >> axisX >> width;
+
+    if(!resolution || (axisY != "-Y" && axisY != "+Y") || axisX != "+X" || width <= 0 || height <= 0)
+    {
+        cerr << "Unsupported HDR resolution : " << filePath << endl;
+        return Mat();
+    }
+
+    Mat imageHDR(height, width, CV_32FC3);
+
+    vector<unsigned char> rgbe(4*(size_t) width);
+    vector<unsigned char> component(width);
+
+    for(int i = 0 ; i<height ; ++i)
+    {
+        if(!readScanline(data, end, &rgbe[0], width, component))
+        {
+            cerr << "Corrupted HDR file : " << filePath << endl;
+            return Mat();
+        }
+
+        int row = (axisY == "-Y") ? i : height-1-i;
+        decodeRGBE(&rgbe[0], imageHDR.ptr<float>(row), width);
+    }
+
+    return imageHDR;
+}
+
+/**
+ * Encodes a floating point color in the RGBE format.
+ * @brief encodeRGBE
+ * @param red
+ * @param green
+ * @param blue
+ * @param rgbe
+ */
+static void encodeRGBE(float red, float green, float blue, unsigned char* rgbe)
+{
+    red = max(red, 0.0f);
+    green = max(green, 0.0f);
+    blue = max(blue, 0.0f);
+
+    float maximum = max(red, max(green, blue));
+
+    if(maximum < 1e-32f)
+    {
+        rgbe[0] = rgbe[1] = rgbe[2] = rgbe[3] = 0;
+        return;
+    }
+
+    //Largest value that can be stored
+    maximum = min(maximum, ldexp(255.0f/256.0f, 127));
+    red = min(red, maximum);
+    green = min(green, maximum);
+    blue = min(blue, maximum);
+
+    int exponent;
+    float factor = frexp(maximum, &exponent)*256.0f/maximum;
+
+    rgbe[0] = (unsigned char) (red*factor);
+    rgbe[1] = (unsigned char) (green*factor);
+    rgbe[2] = (unsigned char) (blue*factor);
+    rgbe[3] = (unsigned char) (exponent+128);
+}
+
+/**
+ * Appends the run length encoding of size bytes to output.
+ * Runs of at least HDR_MIN_RUN_LENGTH identical bytes are stored as (128+length, value),
+ * the other bytes as sequences (length, values...) of at most 128 bytes.
+ * @brief encodeRunLength
+ * @param data
+ * @param size
+ * @param output
+ */
+static void encodeRunLength(const unsigned char* data, int size, vector<unsigned char>& output)
+{
+    int current = 0;
+
+    while(current<size)
+    {
+        //Find the next run long enough
+        int beginRun = current;
+        int runLength = 0;
+        int previousRunLength = 0;
+
+        while(runLength < HDR_MIN_RUN_LENGTH && beginRun < size)
+        {
+            beginRun += runLength;
+            previousRunLength = runLength;
+            runLength = 1;
+
+            while(beginRun+runLength < size && runLength < 127 && data[beginRun] == data[beginRun+runLength])
+                ++runLength;
+        }
+
+        //A short run just before the long run is stored as a run
+        if(previousRunLength > 1 && previousRunLength == beginRun-current)
+        {
+            output.push_back((unsigned char) (128+previousRunLength));
+            output.push_back(data[current]);
+            current = beginRun;
+        }
+
+        //Sequence of different values up to the run
+        while(current<beginRun)
+        {
+            int length = min(128, beginRun-current);
+
+            output.push_back((unsigned char) length);
+            output.insert(output.end(), data+current, data+current+length);
+            current += length;
+        }
+
+        if(runLength >= HDR_MIN_RUN_LENGTH)
+        {
+            output.push_back((unsigned char) (128+runLength));
+            output.push_back(data[beginRun]);
+            current += runLength;
+        }
+    }
+}
+
+/**
+ * Saves an image as a Radiance RGBE (.hdr) file with adaptive run length encoded scanlines.
+ * The image is an OpenCV Mat with 1 or 3 channels (BGR). Negative values are clamped to 0.
+ * Returns true if the image was correctly saved.
+ * @brief saveHDR
+ * @param image
+ * @param filePath
+ * @return
+ */
+bool saveHDR(const Mat image, const string filePath)
+{
+    int numberOfComponents(image.channels());
+
+    if(numberOfComponents != 3 && numberOfComponents != 1)
+    {
+        cerr << "HDR files can only store 1 or 3 channels : " << filePath << endl;
+        return false;
+    }
+
+    //Open the file as binary!
+    ofstream imageFile(filePath.c_str(), ios::out | ios::trunc | ios::binary);
+
+    if(!imageFile)
+    {
+        cerr << "Could not open the file : " << filePath << endl;
+        return false;
+    }
+
+    Mat image32F = image;
+    if(image.depth() != CV_32F)
+    {
+        image.convertTo(image32F, CV_32F);
+    }
+
+    int width(image32F.cols), height(image32F.rows);
+
+    ostringstream header;
+    header << "#?RADIANCE" << '\n';
+    header << "FORMAT=32-bit_rle_rgbe" << '\n' << '\n';
+    header << "-Y " << height << " +X " << width << '\n';
+
+    string headerString = header.str();
+    imageFile.write(headerString.c_str(), headerString.size());
+
+    //Scanlines that are too short or too long for the adaptive run length encoding are stored flat
+    bool runLengthEncoding = (width >= 8 && width <= 0x7fff);
+
+    vector<unsigned char> rgbe(4*(size_t) width);
+    vector<unsigned char> component(width);
+    vector<unsigned char> scanline;
+
+    for(int i = 0 ; i<height && imageFile ; ++i)
+    {
+        const float* row = image32F.ptr<float>(i);
+
+        for(int j = 0 ; j<width ; ++j)
+        {
+            if(numberOfComponents == 3)
+                encodeRGBE(row[3*j+2], row[3*j+1], row[3*j], &rgbe[4*j]);
+            else
+                encodeRGBE(row[j], row[j], row[j], &rgbe[4*j]);
+        }
+
+        if(!runLengthEncoding)
+        {
+            imageFile.write((const char*) &rgbe[0], rgbe.size());
+            continue;
+        }
+
+        scanline.clear();
+        scanline.push_back(2);
+        scanline.push_back(2);
+        scanline.push_back((unsigned char) (width >> 8));
+        scanline.push_back((unsigned char) (width & 0xff));
+
+        for(int c = 0 ; c<4 ; ++c)
+        {
+            for(int j = 0 ; j<width ; ++j)
+            {
+                component[j] = rgbe[4*j+c];
+            }
+
+            encodeRunLength(&component[0], width, scanline);
+        }
+
+        imageFile.write((const char*) &scanline[0], scanline.size());
+    }
+
+    if(!imageFile)
+    {
+        cerr << "Could not write the file : " << filePath << endl;
+        return false;
+    }
+
+    return true;
+}
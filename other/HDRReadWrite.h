@@ -0,0 +1,73 @@
+/*
+ *     Real3D
+ *
+ *     Author:  Antoine TOISOUL LE CANN
+ *
+ *     Copyright © 2016 Antoine TOISOUL LE CANN, Imperial College London
+ *              All rights reserved
+ *
+ *
+ * Real3D is free software: you can redistribute it and/or modify
+ *
+ * it under the terms of the GNU Lesser General Public License as published by
+ *
+ * the Free Software Foundation, either version 3 of the License, or
+ *
+ * (at your option) any later version.
+ *
+ * Real3D is distributed in the hope that it will be useful,
+ *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ *
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * \file HDRReadWrite.h
+ * \brief Implementation of loadHDR and saveHDR functions.
+ * \author Antoine Toisoul Le Cann
+ * \date October, 16th, 2026
+ *
+ * Reads and writes Radiance RGBE (.hdr) images with run length encoded scanlines.
+ */
+
+#ifndef HDRREADWRITE
+#define HDRREADWRITE
+
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <cmath>
+#include <cstring>
+
+#include <opencv2/core/core.hpp>
+
+/**
+ * Loads a Radiance RGBE (.hdr) image and returns the image as an OpenCV Mat (CV_32FC3 in BGR format).
+ * Flat, old style and adaptive run length encoded scanlines are supported.
+ * Returns an empty Mat if the file cannot be read.
+ * @brief loadHDR
+ * @param filePath
+ * @return
+ */
+cv::Mat loadHDR(const std::string filePath);
+
+/**
+ * Saves an image as a Radiance RGBE (.hdr) file with adaptive run length encoded scanlines.
+ * The image is an OpenCV Mat with 1 or 3 channels (BGR). Negative values are clamped to 0.
+ * Returns true if the image was correctly saved.
+ * @brief saveHDR
+ * @param image
+ * @param filePath
+ * @return
+ */
+bool saveHDR(const cv::Mat image, const std::string filePath);
+
+#endif // HDRREADWRITE
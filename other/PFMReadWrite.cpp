@@ -38,12 +38,307 @@
  */
 
 #include "PFMReadWrite.h"
+#include "parallel.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <sstream>
+#include <thread>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define PFM_USE_SSE2
+#endif
 
 using namespace std;
 using namespace cv;
 
 /**
- * Loads a PFM image stored in little endian and returns the image as an OpenCV Mat.
+ * Returns true if the machine stores numbers in little endian.
+ * @brief isLittleEndianMachine
+ * @return
+ */
+static bool isLittleEndianMachine()
+{
+    const unsigned short one = 1;
+    return *((const unsigned char*) &one) == 1;
+}
+
+/**
+ * Reads the header of a PFM file. The stream is left at the beginning of the pixels.
+ * Returns false if the stream does not contain a valid PFM header.
+ * @brief readPFMHeader
+ * @param file
+ * @param header
+ * @return
+ */
+bool readPFMHeader(istream& file, PFMHeader& header)
+{
+    //Type, width, height and scale are separated by white spaces (usually 0x0a UNIX return characters)
+    string type;
+    file >> type >> header.width >> header.height >> header.scale;
+
+    //A single white space character separates the scale from the pixels
+    file.get();
+
+    if(!file || header.width <= 0 || header.height <= 0)
+    {
+        return false;
+    }
+
+    //The type gets the number of color channels
+    if(type == "PF")
+    {
+        header.numberOfComponents = 3;
+    }
+    else if(type == "Pf")
+    {
+        header.numberOfComponents = 1;
+    }
+    else
+    {
+        return false;
+    }
+
+    header.dataOffset = file.tellg();
+
+    return true;
+}
+
+/**
+ * Reverses the order of the 4 bytes of a float.
+ * @brief byteSwap
+ * @param value
+ * @return
+ */
+static inline float byteSwap(float value)
+{
+    unsigned char bytes[4], swapped[4];
+    memcpy(bytes, &value, 4);
+
+    swapped[0] = bytes[3];
+    swapped[1] = bytes[2];
+    swapped[2] = bytes[1];
+    swapped[3] = bytes[0];
+
+    memcpy(&value, swapped, 4);
+    return value;
+}
+
+#ifdef PFM_USE_SSE2
+/**
+ * Reverses the order of the bytes of each of the 4 floats of a register.
+ * @brief byteSwap
+ * @param value
+ * @return
+ */
+static inline __m128 byteSwap(__m128 value)
+{
+    //Swap the two 16 bits halves of each float then the two bytes of each half
+    __m128i halves = _mm_castps_si128(value);
+    halves = _mm_shufflelo_epi16(halves, _MM_SHUFFLE(2,3,0,1));
+    halves = _mm_shufflehi_epi16(halves, _MM_SHUFFLE(2,3,0,1));
+
+    return _mm_castsi128_ps(_mm_or_si128(_mm_slli_epi16(halves, 8), _mm_srli_epi16(halves, 8)));
+}
+
+/**
+ * Swaps the red and blue channels of the 4 RGB pixels stored in the registers a, b and c.
+ * @brief swapRedBlue
+ * @param a
+ * @param b
+ * @param c
+ */
+static inline void swapRedBlue(__m128& a, __m128& b, __m128& c)
+{
+    //a = r0 g0 b0 r1 | b = g1 b1 r2 g2 | c = b2 r3 g3 b3
+
+    //b0 g0 r0 b1
+    __m128 t0 = _mm_shuffle_ps(a, b, _MM_SHUFFLE(1,1,0,0));
+    __m128 out0 = _mm_shuffle_ps(a, t0, _MM_SHUFFLE(2,0,1,2));
+
+    //g1 r1 b2 g2
+    __m128 t1 = _mm_shuffle_ps(b, a, _MM_SHUFFLE(3,3,0,0));
+    __m128 t2 = _mm_shuffle_ps(c, b, _MM_SHUFFLE(3,3,0,0));
+    __m128 out1 = _mm_shuffle_ps(t1, t2, _MM_SHUFFLE(2,0,2,0));
+
+    //r2 b3 g3 r3
+    __m128 t3 = _mm_shuffle_ps(b, c, _MM_SHUFFLE(3,3,2,2));
+    __m128 out2 = _mm_shuffle_ps(t3, c, _MM_SHUFFLE(1,2,2,0));
+
+    a = out0;
+    b = out1;
+    c = out2;
+}
+#endif
+
+/**
+ * Decodes numberOfPixels pixels of a PFM file in a single pass : swaps the bytes of the floats (file stored in
+ * the other byte order), swaps the red and blue channels (RGB -> BGR) and multiplies by the scale factor.
+ * source and destination can be the same array.
+ * @brief decodePixels
+ * @param source
+ * @param destination
+ * @param numberOfPixels
+ * @param scale
+ */
+template<int numberOfComponents, bool swapBytes, bool applyScale>
+static void decodePixels(const float* source, float* destination, size_t numberOfPixels, float scale)
+{
+    size_t i = 0;
+
+#ifdef PFM_USE_SSE2
+    const __m128 scale4 = _mm_set1_ps(scale);
+
+    if(numberOfComponents == 3)
+    {
+        //4 pixels (12 floats) are decoded at a time with 3 loads and 3 stores
+        for(; i+4<=numberOfPixels ; i += 4)
+        {
+            __m128 a = _mm_loadu_ps(source+3*i);
+            __m128 b = _mm_loadu_ps(source+3*i+4);
+            __m128 c = _mm_loadu_ps(source+3*i+8);
+
+            if(swapBytes)
+            {
+                a = byteSwap(a);
+                b = byteSwap(b);
+                c = byteSwap(c);
+            }
+
+            swapRedBlue(a, b, c);
+
+            if(applyScale)
+            {
+                a = _mm_mul_ps(a, scale4);
+                b = _mm_mul_ps(b, scale4);
+                c = _mm_mul_ps(c, scale4);
+            }
+
+            _mm_storeu_ps(destination+3*i, a);
+            _mm_storeu_ps(destination+3*i+4, b);
+            _mm_storeu_ps(destination+3*i+8, c);
+        }
+    }
+    else
+    {
+        for(; i+4<=numberOfPixels ; i += 4)
+        {
+            __m128 a = _mm_loadu_ps(source+i);
+
+            if(swapBytes)
+                a = byteSwap(a);
+
+            if(applyScale)
+                a = _mm_mul_ps(a, scale4);
+
+            _mm_storeu_ps(destination+i, a);
+        }
+    }
+#endif
+
+    //Remaining pixels
+    for(; i<numberOfPixels ; ++i)
+    {
+        float color[3];
+
+        for(int k = 0 ; k<numberOfComponents ; ++k)
+        {
+            color[k] = swapBytes ? byteSwap(source[numberOfComponents*i+k]) : source[numberOfComponents*i+k];
+
+            if(applyScale)
+                color[k] *= scale;
+        }
+
+        //OpenCV stores the color as BGR
+        for(int k = 0 ; k<numberOfComponents ; ++k)
+        {
+            destination[numberOfComponents*i+k] = color[numberOfComponents-1-k];
+        }
+    }
+}
+
+typedef void (*PixelDecoder)(const float*, float*, size_t, float);
+
+/**
+ * Returns the function that decodes the pixels of a PFM file with the given header.
+ * @brief pixelDecoder
+ * @param header
+ * @return
+ */
+static PixelDecoder pixelDecoder(const PFMHeader& header)
+{
+    //The sign of the scale gives the byte order : negative for little endian, positive for big endian
+    bool swapBytes = (header.scale < 0.0f) != isLittleEndianMachine();
+    bool applyScale = fabs(header.scale) != 1.0f;
+
+    if(header.numberOfComponents == 3)
+    {
+        if(swapBytes)
+            return applyScale ? decodePixels<3, true, true> : decodePixels<3, true, false>;
+        else
+            return applyScale ? decodePixels<3, false, true> : decodePixels<3, false, false>;
+    }
+    else
+    {
+        if(swapBytes)
+            return applyScale ? decodePixels<1, true, true> : decodePixels<1, true, false>;
+        else
+            return applyScale ? decodePixels<1, false, true> : decodePixels<1, false, false>;
+    }
+}
+
+/**
+ * Decodes in place the pixels of a PFM file that have been read in image.
+ * The image is flipped vertically and each pair of rows is decoded in a single pass with a temporary buffer of one row.
+ * @brief decodeImage
+ * @param image
+ * @param header
+ */
+static void decodeImage(Mat& image, const PFMHeader& header)
+{
+    const int height = image.rows;
+    const size_t numberOfPixels = image.cols;
+    const size_t rowSize = numberOfPixels*image.elemSize();
+    const float scale = fabs(header.scale);
+
+    PixelDecoder decode = pixelDecoder(header);
+    vector<float> rowBuffer(numberOfPixels*image.channels());
+
+    for(int i = 0 ; i<height/2 ; ++i)
+    {
+        float* top = image.ptr<float>(i);
+        float* bottom = image.ptr<float>(height-1-i);
+
+        decode(top, &rowBuffer[0], numberOfPixels, scale);
+        decode(bottom, top, numberOfPixels, scale);
+        memcpy(bottom, &rowBuffer[0], rowSize);
+    }
+
+    //The middle row of an image with an odd height stays in place
+    if(height%2 == 1)
+    {
+        float* middle = image.ptr<float>(height/2);
+        decode(middle, middle, numberOfPixels, scale);
+    }
+}
+
+/**
+ * Loads a PFM image stored in little or big endian and returns the image as an OpenCV Mat.
+ * The pixels are multiplied by the absolute value of the scale factor of the header.
  * @brief loadPFM
  * @param filePath
  * @return
@@ -59,82 +354,343 @@ Mat loadPFM(const string filePath)
     //If file correctly openened
     if(file)
     {
-        //Read the type of file plus the 0x0a UNIX return character at the end
-        char type[3];
-        file.read(type, 3*sizeof(char));
+        PFMHeader header;
+
+        if(!readPFMHeader(file, header))
+        {
+            cerr << "Not a PFM file : " << filePath << endl;
+            return imagePFM;
+        }
+
+        imagePFM = Mat(header.height, header.width, header.numberOfComponents == 3 ? CV_32FC3 : CV_32FC1);
+
+        //The pixels are stored contiguously after the header : read them all at once in the image
+        streamsize payloadSize = (streamsize) header.width*header.height*header.numberOfComponents*sizeof(float);
+        file.read((char*) imagePFM.data, payloadSize);
+
+        if(file.gcount() != payloadSize)
+        {
+            cerr << "Truncated PFM file : " << filePath << endl;
+            return Mat();
+        }
+
+        //In the PFM format the image is upside down, OpenCV stores the color as BGR
+        //and the floats may have been stored in the other byte order or with a scale factor
+        decodeImage(imagePFM, header);
+
+        //Close file
+        file.close();
+    }
+    else
+    {
+        cerr << "Could not open the file : " << filePath << endl;
+    }
+
+    return imagePFM;
+}
+
+
+/**
+ * Opens a PFM file and reads its header. The stream is left at the beginning of the pixels.
+ * Returns false and prints an error if the file cannot be opened or is not a PFM file.
+ * @brief openPFM
+ * @param file
+ * @param filePath
+ * @param header
+ * @return
+ */
+static bool openPFM(ifstream& file, const string& filePath, PFMHeader& header)
+{
+    file.open(filePath.c_str(), ios::in | ios::binary);
+
+    if(!file)
+    {
+        cerr << "Could not open the file : " << filePath << endl;
+        return false;
+    }
+
+    if(!readPFMHeader(file, header))
+    {
+        cerr << "Not a PFM file : " << filePath << endl;
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * Reads size bytes at the position offset of a file. The position of the file is not used :
+ * several threads can read the same file at the same time.
+ * Returns true if the size bytes were read.
+ * @brief readAt
+ * @param file
+ * @param buffer
+ * @param size
+ * @param offset
+ * @return
+ */
+#ifdef _WIN32
+static bool readAt(HANDLE file, char* buffer, size_t size, unsigned long long offset)
+{
+    while(size > 0)
+    {
+        //The size read by ReadFile is a 32 bits integer
+        DWORD bytesToRead = (DWORD) min(size, (size_t) (1u << 30));
+        DWORD bytesRead = 0;
+
+        OVERLAPPED position = OVERLAPPED();
+        position.Offset = (DWORD) (offset & 0xffffffffull);
+        position.OffsetHigh = (DWORD) (offset >> 32);
+
+        if(!ReadFile(file, buffer, bytesToRead, &bytesRead, &position) || bytesRead == 0)
+            return false;
+
+        buffer += bytesRead;
+        size -= bytesRead;
+        offset += bytesRead;
+    }
+
+    return true;
+}
+#else
+static bool readAt(int file, char* buffer, size_t size, unsigned long long offset)
+{
+    while(size > 0)
+    {
+        ssize_t bytesRead = pread(file, buffer, size, (off_t) offset);
+
+        if(bytesRead <= 0)
+            return false;
+
+        buffer += bytesRead;
+        size -= bytesRead;
+        offset += bytesRead;
+    }
+
+    return true;
+}
+#endif
+
+/**
+ * Loads a PFM image with several threads and returns the image as an OpenCV Mat.
+ * The image is split in bands of rows : each thread reads its band with a positional read and decodes it.
+ * If numberOfThreads <= 0, the number of cores of the machine is used.
+ * @brief loadPFMParallel
+ * @param filePath
+ * @param numberOfThreads
+ * @return
+ */
+Mat loadPFMParallel(const string filePath, const int numberOfThreads)
+{
+    PFMHeader header;
+
+    {
+        ifstream file;
+        if(!openPFM(file, filePath, header))
+        {
+            return Mat();
+        }
+    }
+
+#ifdef _WIN32
+    HANDLE file = CreateFileA(filePath.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    bool opened = (file != INVALID_HANDLE_VALUE);
+#else
+    int file = ::open(filePath.c_str(), O_RDONLY);
+    bool opened = (file >= 0);
+#endif
+
+    if(!opened)
+    {
+        cerr << "Could not open the file : " << filePath << endl;
+        return Mat();
+    }
+
+    Mat imagePFM(header.height, header.width, header.numberOfComponents == 3 ? CV_32FC3 : CV_32FC1);
+
+    const size_t rowSize = (size_t) header.width*header.numberOfComponents*sizeof(float);
+    atomic<bool> complete(true);
+
+    parallelFor(0, header.height, [&](int firstFileRow, int lastFileRow)
+    {
+        //The rows of the file [firstFileRow ; lastFileRow) are the rows of the image
+        //[height-lastFileRow ; height-firstFileRow) in the reverse order : decodeImage flips them
+        Mat band = imagePFM.rowRange(header.height-lastFileRow, header.height-firstFileRow);
+
+        if(!readAt(file, (char*) band.data, (lastFileRow-firstFileRow)*rowSize, header.dataOffset + firstFileRow*rowSize))
+        {
+            complete = false;
+            return;
+        }
+
+        decodeImage(band, header);
+    }, numberOfThreads);
+
+#ifdef _WIN32
+    CloseHandle(file);
+#else
+    ::close(file);
+#endif
+
+    if(!complete)
+    {
+        cerr << "Truncated PFM file : " << filePath << endl;
+        return Mat();
+    }
+
+    return imagePFM;
+}
+
+/**
+ * Loads the rectangular region of a PFM image and returns it as an OpenCV Mat.
+ * The region is given in the coordinates of the OpenCV image (origin at the top left corner) and is clipped to the image.
+ * Only the pixels of the region are read from the file.
+ * @brief loadPFMRegion
+ * @param filePath
+ * @param region
+ * @return
+ */
+Mat loadPFMRegion(const string filePath, const Rect region)
+{
+    ifstream file;
+    PFMHeader header;
+
+    if(!openPFM(file, filePath, header))
+    {
+        return Mat();
+    }
+
+    //Clip the region to the image
+    int left = max(region.x, 0);
+    int top = max(region.y, 0);
+    int right = min(region.x+region.width, header.width);
+    int bottom = min(region.y+region.height, header.height);
+
+    if(left >= right || top >= bottom)
+    {
+        cerr << "Empty region of the PFM file : " << filePath << endl;
+        return Mat();
+    }
 
-        //Read the width and height
-        unsigned int width(0), height(0);
-        file >> width >> height;
+    Mat imagePFM(bottom-top, right-left, header.numberOfComponents == 3 ? CV_32FC3 : CV_32FC1);
 
-        //Read the 0x0a UNIX return character at the end
-        char endOfLine;
-        file.read(&endOfLine, sizeof(char));
+    const size_t pixelSize = header.numberOfComponents*sizeof(float);
+    const streamsize rowSize = (streamsize) imagePFM.cols*pixelSize;
+    const float scale = fabs(header.scale);
+    PixelDecoder decode = pixelDecoder(header);
 
-        int numberOfComponents(0);
-        //The type gets the number of color channels
-        if(type[1] == 'F')
+    //The rows of the file are stored from the bottom to the top of the image : read them in the order of the file
+    for(int i = bottom-1 ; i>=top ; --i)
+    {
+        int fileRow = header.height-1-i;
+        float* row = imagePFM.ptr<float>(i-top);
+
+        file.seekg(header.dataOffset + (streamoff) ((size_t) fileRow*header.width+left)*pixelSize);
+        file.read((char*) row, rowSize);
+
+        if(file.gcount() != rowSize)
         {
-            imagePFM = Mat(height, width, CV_32FC3);
-            numberOfComponents = 3;
+            cerr << "Truncated PFM file : " << filePath << endl;
+            return Mat();
         }
-        else if(type[1] == 'f')
+
+        decode(row, row, imagePFM.cols, scale);
+    }
+
+    return imagePFM;
+}
+
+/**
+ * Loads a PFM image downsampled by a factor 2^levels with a box filter and returns it as an OpenCV Mat.
+ * The file is read one row at a time : only one row of the file and one row of the result are kept in memory.
+ * When the size of the image is not a multiple of 2^levels, the last boxes average the remaining pixels.
+ * @brief loadPFMDownsampled
+ * @param filePath
+ * @param levels
+ * @return
+ */
+Mat loadPFMDownsampled(const string filePath, const int levels)
+{
+    ifstream file;
+    PFMHeader header;
+
+    if(!openPFM(file, filePath, header))
+    {
+        return Mat();
+    }
+
+    if(levels < 0 || levels > 30)
+    {
+        cerr << "Invalid number of downsampling levels : " << levels << endl;
+        return Mat();
+    }
+
+    const int factor = 1 << levels;
+    const int numberOfComponents = header.numberOfComponents;
+    const int width = (header.width+factor-1)/factor;
+    const int height = (header.height+factor-1)/factor;
+
+    Mat imagePFM(height, width, numberOfComponents == 3 ? CV_32FC3 : CV_32FC1);
+
+    const streamsize rowSize = (streamsize) header.width*numberOfComponents*sizeof(float);
+    const float scale = fabs(header.scale);
+    PixelDecoder decode = pixelDecoder(header);
+
+    vector<float> row(header.width*numberOfComponents);
+    vector<float> boxSums(width*numberOfComponents, 0.0f);
+
+    //The rows of the file are stored from the bottom to the top of the image
+    for(int fileRow = 0 ; fileRow<header.height ; ++fileRow)
+    {
+        file.read((char*) &row[0], rowSize);
+
+        if(file.gcount() != rowSize)
         {
-            imagePFM = Mat(height, width, CV_32FC1);
-            numberOfComponents = 1;
+            cerr << "Truncated PFM file : " << filePath << endl;
+            return Mat();
         }
 
-        //TODO Read correctly depending on the endianness
-        //Read the endianness plus the 0x0a UNIX return character at the end
-        //Byte Order contains -1.0 or 1.0
-        char byteOrder[4];
-        file.read(byteOrder, 4*sizeof(char));
+        decode(&row[0], &row[0], header.width, scale);
 
-        //Find the last line return 0x0a before the pixels of the image
-        char findReturn = ' ';
-        while(findReturn != 0x0a)
+        //Sum the pixels of the row in their box
+        for(int j = 0 ; j<header.width ; ++j)
         {
-          file.read(&findReturn, sizeof(char));
+            float* boxSum = &boxSums[(j >> levels)*numberOfComponents];
+
+            for(int k = 0 ; k<numberOfComponents ; ++k)
+            {
+                boxSum[k] += row[j*numberOfComponents+k];
+            }
         }
 
-        //Read each RGB colors as 3 floats and store it in the image.
-        float *color = new float[numberOfComponents];
-        for(unsigned int i = 0 ; i<height ; ++i)
+        //The boxes are complete once their top row has been read
+        int i = header.height-1-fileRow;
+
+        if(i%factor == 0)
         {
-            for(unsigned int j = 0 ; j<width ; ++j)
+            int boxHeight = min(factor, header.height-i);
+            float* result = imagePFM.ptr<float>(i/factor);
+
+            for(int j = 0 ; j<width ; ++j)
             {
-                file.read((char*) color, numberOfComponents*sizeof(float));
+                int boxWidth = min(factor, header.width-j*factor);
+                float normalisation = 1.0f/(boxWidth*boxHeight);
 
-                //In the PFM format the image is upside down
-                if(numberOfComponents == 3)
-                {
-                    //OpenCV stores the color as BGR
-                    imagePFM.at<Vec3f>(height-1-i,j) = Vec3f(color[2], color[1], color[0]);
-                }
-                else if(numberOfComponents == 1)
+                for(int k = 0 ; k<numberOfComponents ; ++k)
                 {
-                    //OpenCV stores the color as BGR
-                    imagePFM.at<float>(height-1-i,j) = color[0];
+                    result[j*numberOfComponents+k] = boxSums[j*numberOfComponents+k]*normalisation;
                 }
             }
-        }
-
-        delete[] color;
 
-        //Close file
-        file.close();
-    }
-    else
-    {
-        cerr << "Could not open the file : " << filePath << endl;
+            fill(boxSums.begin(), boxSums.end(), 0.0f);
+        }
     }
 
     return imagePFM;
 }
 
-
 /**
- * Saves the image as a PFM file.
+ * Saves the image as a PFM file in the byte order of the machine.
  * @brief savePFM
  * @param image
  * @param filePath
@@ -142,81 +698,392 @@ Mat loadPFM(const string filePath)
  */
 bool savePFM(const cv::Mat image, const std::string filePath)
 {
+    int numberOfComponents(image.channels());
+
+    if(numberOfComponents != 3 && numberOfComponents != 1)
+    {
+        cerr << "PFM files can only store 1 or 3 channels : " << filePath << endl;
+        return false;
+    }
+
     //Open the file as binary!
     ofstream imageFile(filePath.c_str(), ios::out | ios::trunc | ios::binary);
 
     if(imageFile)
     {
-        int width(image.cols), height(image.rows);
-        int numberOfComponents(image.channels());
+        Mat image32F = image;
+        if(image.depth() != CV_32F)
+        {
+            image.convertTo(image32F, CV_32F);
+        }
+
+        int width(image32F.cols), height(image32F.rows);
+
+        //Type of the PFM file, width and height and scale : -1.0 for little endian or 1.0 for big endian.
+        //Each line ends with a line return 0x0a
+        ostringstream header;
+        header << (numberOfComponents == 3 ? "PF" : "Pf") << '\n';
+        header << width << " " << height << '\n';
+        header << (isLittleEndianMachine() ? "-1.000000" : "1.000000") << '\n';
+
+        string headerString = header.str();
+        imageFile.write(headerString.c_str(), headerString.size());
 
-        //Write the type of the PFM file and ends by a line return
-        char type[3];
-        type[0] = 'P';
-        type[2] = 0x0a;
+        //Store the floating points RGB color upside down, left to right.
+        //The rows are converted in a buffer of about PFM_WRITE_BUFFER_SIZE bytes written at once.
+        const size_t rowSize = (size_t) width*numberOfComponents;
+        const int rowsPerBatch = max(1, (int) (PFM_WRITE_BUFFER_SIZE/(rowSize*sizeof(float))));
 
-        if(numberOfComponents == 3)
+        //Swapping the red and blue channels converts BGR to RGB as well
+        PixelDecoder encode = (numberOfComponents == 3) ? decodePixels<3, false, false> : decodePixels<1, false, false>;
+        vector<float> buffer(rowSize*min(rowsPerBatch, height));
+
+        for(int i = 0 ; i<height && imageFile ; i += rowsPerBatch)
         {
-            type[1] = 'F';
+            int numberOfRows = min(rowsPerBatch, height-i);
+
+            for(int k = 0 ; k<numberOfRows ; ++k)
+            {
+                encode(image32F.ptr<float>(height-1-i-k), &buffer[k*rowSize], width, 1.0f);
+            }
+
+            //Write the values
+            imageFile.write((const char *) &buffer[0], numberOfRows*rowSize*sizeof(float));
         }
-        else if(numberOfComponents == 1)
+
+        if(!imageFile)
         {
-            type[1] = 'f';
+            cerr << "Could not write the file : " << filePath << endl;
+            return false;
         }
 
-        imageFile << type[0] << type[1] << type[2];
+        imageFile.close();
+    }
+    else
+    {
+        cerr << "Could not open the file : " << filePath << endl;
+        return false;
+    }
 
-        //Write the width and height and ends by a line return
-        imageFile << width << " " << height << type[2];
+    return true;
+}
 
-        //Assumes little endian storage and ends with a line return 0x0a
-        //Stores the type
-        char byteOrder[10];
-        byteOrder[0] = '-'; byteOrder[1] = '1'; byteOrder[2] = '.'; byteOrder[3] = '0';
-        byteOrder[4] = '0'; byteOrder[5] = '0'; byteOrder[6] = '0'; byteOrder[7] = '0';
-        byteOrder[8] = '0'; byteOrder[9] = 0x0a;
+/**
+ * Background thread that saves PFM files one after the other.
+ * At most PFM_MAX_PENDING_SAVES images wait in the queue.
+ */
+class PFMWriterThread
+{
+    public:
+        /**
+         * Starts the thread.
+         * @brief PFMWriterThread
+         */
+        PFMWriterThread(): m_stop(false)
+        {
+            m_thread = thread(&PFMWriterThread::run, this);
+        }
 
-        for(int i = 0 ; i<10 ; ++i)
+        /**
+          * Destructor. Writes the remaining images and stops the thread.
+          */
+        ~PFMWriterThread()
         {
-            imageFile << byteOrder[i];
+            {
+                lock_guard<mutex> lock(m_mutex);
+                m_stop = true;
+            }
+
+            m_queueNotEmpty.notify_one();
+            m_thread.join();
+        }
+
+        /**
+         * Adds an image to the queue. Blocks while the queue is full.
+         * @brief push
+         * @param image
+         * @param filePath
+         * @param callback
+         * @return
+         */
+        future<bool> push(const Mat& image, const string& filePath, const function<void(bool)>& callback)
+        {
+            SaveTask task;
+            task.image = image;
+            task.filePath = filePath;
+            task.callback = callback;
+
+            future<bool> result = task.saved.get_future();
+
+            {
+                unique_lock<mutex> lock(m_mutex);
+                m_queueNotFull.wait(lock, [this]{ return m_queue.size() < PFM_MAX_PENDING_SAVES; });
+                m_queue.push_back(move(task));
+            }
+
+            m_queueNotEmpty.notify_one();
+
+            return result;
         }
 
-        //Store the floating points RGB color upside down, left to right
-        float* buffer = new float[numberOfComponents];
+    private:
+        struct SaveTask
+        {
+            Mat image;
+            string filePath;
+            function<void(bool)> callback;
+            promise<bool> saved;
+        };
 
-        for(int i = 0 ; i<height ; ++i)
+        /**
+         * Saves the images of the queue until the thread is stopped.
+         * @brief run
+         */
+        void run()
         {
-            for(int j = 0 ; j<width ; ++j)
+            while(true)
             {
-                if(numberOfComponents == 1)
-                {
-                    buffer[0] = image.at<float>(height-1-i,j);
-                }
-                else
+                SaveTask task;
+
                 {
-                    Vec3f color = image.at<Vec3f>(height-1-i,j);
+                    unique_lock<mutex> lock(m_mutex);
+                    m_queueNotEmpty.wait(lock, [this]{ return m_stop || !m_queue.empty(); });
+
+                    if(m_queue.empty())
+                        return;
 
-                   //OpenCV stores as BGR
-                    buffer[0] = color.val[2];
-                    buffer[1] = color.val[1];
-                    buffer[2] = color.val[0];
+                    task = move(m_queue.front());
+                    m_queue.pop_front();
                 }
 
-                //Write the values
-                imageFile.write((char *) buffer, numberOfComponents*sizeof(float));
+                m_queueNotFull.notify_one();
+
+                bool saved = savePFM(task.image, task.filePath);
 
+                if(task.callback)
+                    task.callback(saved);
+
+                task.saved.set_value(saved);
             }
         }
 
-        delete[] buffer;
+        thread m_thread; /*!< Writer thread. */
+        mutex m_mutex; /*!< Protects the queue and the stop flag. */
+        condition_variable m_queueNotEmpty; /*!< Signaled when an image is added or when the thread has to stop. */
+        condition_variable m_queueNotFull; /*!< Signaled when an image is removed from the queue. */
+        deque<SaveTask> m_queue; /*!< Images waiting to be saved. */
+        bool m_stop; /*!< True when the thread has to stop once the queue is empty. */
+};
 
-        imageFile.close();
-    }
-    else
+/**
+ * Saves the image as a PFM file on a background thread and returns immediately, unless PFM_MAX_PENDING_SAVES
+ * images are already waiting to be saved.
+ * The pixels are shared with image (not copied) : image must not be modified until the file is written.
+ * The returned future and the optional callback (called on the background thread) give the result of savePFM.
+ * @brief savePFMAsync
+ * @param image
+ * @param filePath
+ * @param callback
+ * @return
+ */
+future<bool> savePFMAsync(const Mat image, const string filePath, function<void(bool)> callback)
+{
+    //Started on the first call, stopped at the end of the program once every image is saved
+    static PFMWriterThread writerThread;
+
+    return writerThread.push(image, filePath, callback);
+}
+
+/**
+ * Default constructor. No file is mapped.
+ * @brief MappedPFM
+ */
+MappedPFM::MappedPFM(): m_header(), m_mapping(NULL), m_mappingSize(0)
+{
+
+}
+
+/**
+ * Maps the PFM file filePath in memory.
+ * @brief MappedPFM
+ * @param filePath
+ */
+MappedPFM::MappedPFM(const string filePath): m_header(), m_mapping(NULL), m_mappingSize(0)
+{
+    open(filePath);
+}
+
+/**
+  * Destructor. Unmaps the file.
+  */
+MappedPFM::~MappedPFM()
+{
+    close();
+}
+
+/**
+ * Maps the PFM file filePath in memory. Any previously mapped file is unmapped.
+ * Returns true if the file was correctly mapped.
+ * @brief open
+ * @param filePath
+ * @return
+ */
+bool MappedPFM::open(const string filePath)
+{
+    close();
+
+    //Read the header with a stream to know where the pixels start
+    ifstream file(filePath.c_str(), ios::in | ios::binary);
+
+    if(!file)
     {
         cerr << "Could not open the file : " << filePath << endl;
         return false;
     }
 
+    PFMHeader header;
+
+    if(!readPFMHeader(file, header))
+    {
+        cerr << "Not a PFM file : " << filePath << endl;
+        return false;
+    }
+
+    file.close();
+
+    size_t fileSize = (size_t) header.dataOffset + (size_t) header.width*header.height*header.numberOfComponents*sizeof(float);
+    void* mapping = NULL;
+
+#ifdef _WIN32
+    HANDLE fileHandle = CreateFileA(filePath.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+
+    if(fileHandle != INVALID_HANDLE_VALUE)
+    {
+        LARGE_INTEGER actualSize;
+
+        if(GetFileSizeEx(fileHandle, &actualSize) && (unsigned long long) actualSize.QuadPart >= fileSize)
+        {
+            HANDLE mappingHandle = CreateFileMappingA(fileHandle, NULL, PAGE_READONLY, 0, 0, NULL);
+
+            //The view keeps the mapping alive once the handles are closed
+            if(mappingHandle != NULL)
+            {
+                mapping = MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, fileSize);
+                CloseHandle(mappingHandle);
+            }
+        }
+
+        CloseHandle(fileHandle);
+    }
+#else
+    int fileDescriptor = ::open(filePath.c_str(), O_RDONLY);
+
+    if(fileDescriptor >= 0)
+    {
+        struct stat fileStatus;
+
+        if(fstat(fileDescriptor, &fileStatus) == 0 && (size_t) fileStatus.st_size >= fileSize)
+        {
+            mapping = mmap(NULL, fileSize, PROT_READ, MAP_PRIVATE, fileDescriptor, 0);
+
+            if(mapping == MAP_FAILED)
+            {
+                mapping = NULL;
+            }
+            else
+            {
+                //The pixels are read once from the beginning to the end
+                madvise(mapping, fileSize, MADV_SEQUENTIAL);
+            }
+        }
+
+        //The mapping stays valid once the file is closed
+        ::close(fileDescriptor);
+    }
+#endif
+
+    if(mapping == NULL)
+    {
+        cerr << "Could not map the file : " << filePath << endl;
+        return false;
+    }
+
+    m_header = header;
+    m_mapping = mapping;
+    m_mappingSize = fileSize;
+
     return true;
 }
+
+/**
+ * Unmaps the file.
+ * @brief close
+ */
+void MappedPFM::close()
+{
+    if(m_mapping != NULL)
+    {
+#ifdef _WIN32
+        UnmapViewOfFile(m_mapping);
+#else
+        munmap(m_mapping, m_mappingSize);
+#endif
+    }
+
+    m_mapping = NULL;
+    m_mappingSize = 0;
+}
+
+/**
+ * Returns true if a file is mapped.
+ * @brief isOpen
+ * @return
+ */
+bool MappedPFM::isOpen() const
+{
+    return m_mapping != NULL;
+}
+
+/**
+ * Returns true if the pixels are stored in the byte order of the machine and can be used directly.
+ * @brief isNativeByteOrder
+ * @return
+ */
+bool MappedPFM::isNativeByteOrder() const
+{
+    return (m_header.scale < 0.0f) == isLittleEndianMachine();
+}
+
+/**
+ * Returns true if the absolute value of the scale factor is 1 : the pixels do not have to be rescaled.
+ * @brief hasUnitScale
+ * @return
+ */
+bool MappedPFM::hasUnitScale() const
+{
+    return fabs(m_header.scale) == 1.0f;
+}
+
+/**
+ * Returns the header of the file.
+ * @brief getHeader
+ * @return
+ */
+const PFMHeader& MappedPFM::getHeader() const
+{
+    return m_header;
+}
+
+/**
+ * Returns a pointer to the first pixel (bottom left corner of the image).
+ * The pointer is not necessarily aligned on a float.
+ * @brief getPixels
+ * @return
+ */
+const char* MappedPFM::getPixels() const
+{
+    if(m_mapping == NULL)
+        return NULL;
+
+    return (const char*) m_mapping + m_header.dataOffset;
+}
@@ -42,12 +42,44 @@
 
 #include <iostream>
 #include <fstream>
+#include <string>
+#include <vector>
+#include <cmath>
+#include <cstring>
+#include <functional>
+#include <future>
 
 #include <opencv2/core/core.hpp>
 #include <opencv/highgui.h>
 
+#define PFM_WRITE_BUFFER_SIZE (4 << 20) /*!< Size in bytes of the rows written at once by savePFM. */
+#define PFM_MAX_PENDING_SAVES 4 /*!< Maximum number of images waiting to be saved by savePFMAsync. */
+
+/**
+ * Header of a PFM file.
+ */
+struct PFMHeader
+{
+    int width; /*!< Width of the image. */
+    int height; /*!< Height of the image. */
+    int numberOfComponents; /*!< 3 for a RGB image (PF), 1 for a grayscale image (Pf). */
+    float scale; /*!< Scale factor applied to the pixels (absolute value). Negative for little endian pixels, positive for big endian pixels. */
+    std::streamoff dataOffset; /*!< Offset in bytes of the first pixel in the file. */
+};
+
 /**
- * Loads a PFM image stored in little endian and returns the image as an OpenCV Mat.
+ * Reads the header of a PFM file. The stream is left at the beginning of the pixels.
+ * Returns false if the stream does not contain a valid PFM header.
+ * @brief readPFMHeader
+ * @param file
+ * @param header
+ * @return
+ */
+bool readPFMHeader(std::istream& file, PFMHeader& header);
+
+/**
+ * Loads a PFM image stored in little or big endian and returns the image as an OpenCV Mat.
+ * The pixels are multiplied by the absolute value of the scale factor of the header.
  * @brief loadPFM
  * @param filePath
  * @return
@@ -55,7 +87,40 @@
 cv::Mat loadPFM(const std::string filePath);
 
 /**
- * Saves the image as a PFM file.
+ * Loads a PFM image with several threads and returns the image as an OpenCV Mat.
+ * The image is split in bands of rows : each thread reads its band with a positional read and decodes it.
+ * If numberOfThreads <= 0, the number of cores of the machine is used.
+ * @brief loadPFMParallel
+ * @param filePath
+ * @param numberOfThreads
+ * @return
+ */
+cv::Mat loadPFMParallel(const std::string filePath, const int numberOfThreads = 0);
+
+/**
+ * Loads the rectangular region of a PFM image and returns it as an OpenCV Mat.
+ * The region is given in the coordinates of the OpenCV image (origin at the top left corner) and is clipped to the image.
+ * Only the pixels of the region are read from the file.
+ * @brief loadPFMRegion
+ * @param filePath
+ * @param region
+ * @return
+ */
+cv::Mat loadPFMRegion(const std::string filePath, const cv::Rect region);
+
+/**
+ * Loads a PFM image downsampled by a factor 2^levels with a box filter and returns it as an OpenCV Mat.
+ * The file is read one row at a time : only one row of the file and one row of the result are kept in memory.
+ * When the size of the image is not a multiple of 2^levels, the last boxes average the remaining pixels.
+ * @brief loadPFMDownsampled
+ * @param filePath
+ * @param levels
+ * @return
+ */
+cv::Mat loadPFMDownsampled(const std::string filePath, const int levels);
+
+/**
+ * Saves the image as a PFM file in the byte order of the machine.
  * @brief savePFM
  * @param image
  * @param filePath
@@ -63,5 +128,105 @@ cv::Mat loadPFM(const std::string filePath);
  */
 bool savePFM(const cv::Mat image, const std::string filePath);
 
+/**
+ * Saves the image as a PFM file on a background thread and returns immediately, unless PFM_MAX_PENDING_SAVES
+ * images are already waiting to be saved.
+ * The pixels are shared with image (not copied) : image must not be modified until the file is written.
+ * The returned future and the optional callback (called on the background thread) give the result of savePFM.
+ * @brief savePFMAsync
+ * @param image
+ * @param filePath
+ * @param callback
+ * @return
+ */
+std::future<bool> savePFMAsync(const cv::Mat image, const std::string filePath,
+                               std::function<void(bool)> callback = std::function<void(bool)>());
+
+/**
+ * Read only memory mapping of a PFM file.
+ * The pixels are exposed directly from the file without any copy : RGB order, rows stored from the bottom to the top
+ * of the image (which is the OpenGL convention) and in the byte order given by the scale of the header.
+ */
+class MappedPFM
+{
+    public:
+        /**
+         * Default constructor. No file is mapped.
+         * @brief MappedPFM
+         */
+        MappedPFM();
+
+        /**
+         * Maps the PFM file filePath in memory.
+         * @brief MappedPFM
+         * @param filePath
+         */
+        MappedPFM(const std::string filePath);
+
+        /**
+          * Destructor. Unmaps the file.
+          */
+        ~MappedPFM();
+
+        /**
+         * Maps the PFM file filePath in memory. Any previously mapped file is unmapped.
+         * Returns true if the file was correctly mapped.
+         * @brief open
+         * @param filePath
+         * @return
+         */
+        bool open(const std::string filePath);
+
+        /**
+         * Unmaps the file.
+         * @brief close
+         */
+        void close();
+
+        /**
+         * Returns true if a file is mapped.
+         * @brief isOpen
+         * @return
+         */
+        bool isOpen() const;
+
+        /**
+         * Returns true if the pixels are stored in the byte order of the machine and can be used directly.
+         * @brief isNativeByteOrder
+         * @return
+         */
+        bool isNativeByteOrder() const;
+
+        /**
+         * Returns true if the absolute value of the scale factor is 1 : the pixels do not have to be rescaled.
+         * @brief hasUnitScale
+         * @return
+         */
+        bool hasUnitScale() const;
+
+        /**
+         * Returns the header of the file.
+         * @brief getHeader
+         * @return
+         */
+        const PFMHeader& getHeader() const;
+
+        /**
+         * Returns a pointer to the first pixel (bottom left corner of the image).
+         * The pointer is not necessarily aligned on a float.
+         * @brief getPixels
+         * @return
+         */
+        const char* getPixels() const;
+
+    private:
+        MappedPFM(const MappedPFM&) = delete;
+        MappedPFM& operator=(const MappedPFM&) = delete;
+
+        PFMHeader m_header; /*!< Header of the mapped file. */
+        void* m_mapping; /*!< Address of the mapping. */
+        size_t m_mappingSize; /*!< Size of the mapping in bytes. */
+};
+
 #endif // PFMREADWRITE
 
@@ -0,0 +1,898 @@
+/*
+ *     Real3D
+ *
+ *     Author:  Antoine TOISOUL LE CANN
+ *
+ *     Copyright © 2016 Antoine TOISOUL LE CANN, Imperial College London
+ *              All rights reserved
+ *
+ *
+ * Real3D is free software: you can redistribute it and/or modify
+ *
+ * it under the terms of the GNU Lesser General Public License as published by
+ *
+ * the Free Software Foundation, either version 3 of the License, or
+ *
+ * (at your option) any later version.
+ *
+ * Real3D is distributed in the hope that it will be useful,
+ *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ *
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * \file datacache.cpp
+ * \brief On disk cache of the images derived from source files.
+ * \author Antoine Toisoul Le Cann
+ * \date October, 16th, 2026
+ *
+ * Content addressed cache : the entries are keyed by a hash of the content of the source file and of the parameters
+ * used to generate the images. Each entry is a binary file that is mapped in memory and sent directly to OpenGL.
+ * The least recently used entries are removed when the cache exceeds its maximum size.
+ */
+
+#include "datacache.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <utime.h>
+#endif
+
+#include <algorithm>
+#include <cstdio>
+#include <map>
+#include <mutex>
+
+using namespace std;
+using namespace cv;
+
+#define XXHASH_PRIME1 11400714785074694791ULL
+#define XXHASH_PRIME2 14029467366897019727ULL
+#define XXHASH_PRIME3 1609587929392839161ULL
+#define XXHASH_PRIME4 9650029242287828579ULL
+#define XXHASH_PRIME5 2870177450012600261ULL
+
+#define DATA_CACHE_BYTE_ORDER_MARK 0x01020304u
+
+/**
+ * Size, modification date and hash of a file that was hashed.
+ * @brief The HashedFile struct
+ */
+struct HashedFile
+{
+    uint64_t size;
+    int64_t modificationTime;
+    uint64_t hash;
+};
+
+/**
+ * Cache file found in the cache directory.
+ * @brief The CacheFile struct
+ */
+struct CacheFile
+{
+    string filePath;
+    uint64_t size;
+    int64_t modificationTime;
+};
+
+static inline uint64_t rotateLeft(uint64_t value, int bits)
+{
+    return (value << bits) | (value >> (64-bits));
+}
+
+static inline uint64_t read64(const unsigned char* data)
+{
+    uint64_t value;
+    memcpy(&value, data, sizeof(value));
+    return value;
+}
+
+static inline uint32_t read32(const unsigned char* data)
+{
+    uint32_t value;
+    memcpy(&value, data, sizeof(value));
+    return value;
+}
+
+static inline uint64_t xxHashRound(uint64_t accumulator, uint64_t input)
+{
+    accumulator += input*XXHASH_PRIME2;
+    accumulator = rotateLeft(accumulator, 31);
+    return accumulator*XXHASH_PRIME1;
+}
+
+static inline uint64_t xxHashMerge(uint64_t accumulator, uint64_t value)
+{
+    accumulator ^= xxHashRound(0, value);
+    return accumulator*XXHASH_PRIME1 + XXHASH_PRIME4;
+}
+
+/**
+ * Returns the rounded up multiple of DATA_CACHE_ALIGNMENT.
+ * @brief alignedSize
+ * @param size
+ * @return
+ */
+static uint64_t alignedSize(uint64_t size)
+{
+    return (size + DATA_CACHE_ALIGNMENT-1)/DATA_CACHE_ALIGNMENT*DATA_CACHE_ALIGNMENT;
+}
+
+/**
+ * Maps a whole file in memory (read only). Returns NULL if the file cannot be mapped or is empty.
+ * The mapping must be released with unmapFile.
+ * @brief mapFile
+ * @param filePath
+ * @param size
+ * @return
+ */
+void* mapFile(const string filePath, size_t& size)
+{
+    void* mapping = NULL;
+    size = 0;
+
+#ifdef _WIN32
+    HANDLE fileHandle = CreateFileA(filePath.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+
+    if(fileHandle != INVALID_HANDLE_VALUE)
+    {
+        LARGE_INTEGER fileSize;
+
+        if(GetFileSizeEx(fileHandle, &fileSize) && fileSize.QuadPart > 0)
+        {
+            HANDLE mappingHandle = CreateFileMappingA(fileHandle, NULL, PAGE_READONLY, 0, 0, NULL);
+
+            //The view keeps the mapping alive once the handles are closed
+            if(mappingHandle != NULL)
+            {
+                mapping = MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, 0);
+                size = (size_t) fileSize.QuadPart;
+                CloseHandle(mappingHandle);
+            }
+        }
+
+        CloseHandle(fileHandle);
+    }
+#else
+    int fileDescriptor = ::open(filePath.c_str(), O_RDONLY);
+
+    if(fileDescriptor >= 0)
+    {
+        struct stat fileStatus;
+
+        if(fstat(fileDescriptor, &fileStatus) == 0 && fileStatus.st_size > 0)
+        {
+            mapping = mmap(NULL, (size_t) fileStatus.st_size, PROT_READ, MAP_PRIVATE, fileDescriptor, 0);
+            size = (size_t) fileStatus.st_size;
+
+            if(mapping == MAP_FAILED)
+            {
+                mapping = NULL;
+            }
+        }
+
+        //The mapping stays valid once the file is closed
+        ::close(fileDescriptor);
+    }
+#endif
+
+    if(mapping == NULL)
+    {
+        size = 0;
+    }
+
+    return mapping;
+}
+
+/**
+ * Unmaps a file mapped by mapFile.
+ * @brief unmapFile
+ * @param mapping
+ * @param size
+ */
+void unmapFile(void* mapping, size_t size)
+{
+    if(mapping != NULL)
+    {
+#ifdef _WIN32
+        (void) size;
+        UnmapViewOfFile(mapping);
+#else
+        munmap(mapping, size);
+#endif
+    }
+}
+
+/**
+ * Reads the size and the modification date of a file. Returns false if the file does not exist.
+ * @brief fileStatus
+ * @param filePath
+ * @param size
+ * @param modificationTime
+ * @return
+ */
+bool fileStatus(const string filePath, uint64_t& size, int64_t& modificationTime)
+{
+#ifdef _WIN32
+    WIN32_FILE_ATTRIBUTE_DATA attributes;
+
+    if(!GetFileAttributesExA(filePath.c_str(), GetFileExInfoStandard, &attributes))
+        return false;
+
+    size = ((uint64_t) attributes.nFileSizeHigh << 32) | attributes.nFileSizeLow;
+    modificationTime = (int64_t) (((uint64_t) attributes.ftLastWriteTime.dwHighDateTime << 32) | attributes.ftLastWriteTime.dwLowDateTime);
+#else
+    struct stat status;
+
+    if(stat(filePath.c_str(), &status) != 0)
+        return false;
+
+    size = (uint64_t) status.st_size;
+
+    //Nanoseconds : several entries can be used in the same second
+#ifdef __APPLE__
+    modificationTime = (int64_t) status.st_mtimespec.tv_sec*1000000000LL + status.st_mtimespec.tv_nsec;
+#else
+    modificationTime = (int64_t) status.st_mtim.tv_sec*1000000000LL + status.st_mtim.tv_nsec;
+#endif
+#endif
+
+    return true;
+}
+
+/**
+ * Sets the modification date of a file to the current date.
+ * @brief touchFile
+ * @param filePath
+ */
+static void touchFile(const string filePath)
+{
+#ifdef _WIN32
+    HANDLE fileHandle = CreateFileA(filePath.c_str(), FILE_WRITE_ATTRIBUTES, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, NULL, OPEN_EXISTING, 0, NULL);
+
+    if(fileHandle != INVALID_HANDLE_VALUE)
+    {
+        FILETIME now;
+        GetSystemTimeAsFileTime(&now);
+        SetFileTime(fileHandle, NULL, NULL, &now);
+        CloseHandle(fileHandle);
+    }
+#else
+    utime(filePath.c_str(), NULL);
+#endif
+}
+
+/**
+ * Lists the cache files of a directory.
+ * @brief listCacheFiles
+ * @param directory
+ * @return
+ */
+static vector<CacheFile> listCacheFiles(const string directory)
+{
+    vector<CacheFile> files;
+    const string extension = DATA_CACHE_EXTENSION;
+
+#ifdef _WIN32
+    WIN32_FIND_DATAA fileData;
+    HANDLE findHandle = FindFirstFileA((directory + "/*" + extension).c_str(), &fileData);
+
+    if(findHandle == INVALID_HANDLE_VALUE)
+        return files;
+
+    do
+    {
+        CacheFile file;
+        file.filePath = directory + "/" + fileData.cFileName;
+        file.size = ((uint64_t) fileData.nFileSizeHigh << 32) | fileData.nFileSizeLow;
+        file.modificationTime = (int64_t) (((uint64_t) fileData.ftLastWriteTime.dwHighDateTime << 32) | fileData.ftLastWriteTime.dwLowDateTime);
+        files.push_back(file);
+    }
+    while(FindNextFileA(findHandle, &fileData));
+
+    FindClose(findHandle);
+#else
+    DIR* directoryHandle = opendir(directory.c_str());
+
+    if(directoryHandle == NULL)
+        return files;
+
+    while(struct dirent* entry = readdir(directoryHandle))
+    {
+        string fileName = entry->d_name;
+
+        if(fileName.size() <= extension.size() || fileName.compare(fileName.size()-extension.size(), extension.size(), extension) != 0)
+            continue;
+
+        CacheFile file;
+        file.filePath = directory + "/" + fileName;
+
+        if(fileStatus(file.filePath, file.size, file.modificationTime))
+        {
+            files.push_back(file);
+        }
+    }
+
+    closedir(directoryHandle);
+#endif
+
+    return files;
+}
+
+/**
+ * Returns the 64 bits xxHash of size bytes of data.
+ * @brief hashData
+ * @param data
+ * @param size
+ * @param seed
+ * @return
+ */
+uint64_t hashData(const void* data, size_t size, uint64_t seed)
+{
+    const unsigned char* bytes = (const unsigned char*) data;
+    const unsigned char* end = bytes + size;
+    uint64_t hash;
+
+    if(size >= 32)
+    {
+        //Four independent accumulators of 8 bytes
+        uint64_t v1 = seed + XXHASH_PRIME1 + XXHASH_PRIME2;
+        uint64_t v2 = seed + XXHASH_PRIME2;
+        uint64_t v3 = seed;
+        uint64_t v4 = seed - XXHASH_PRIME1;
+
+        const unsigned char* limit = end - 32;
+
+        do
+        {
+            v1 = xxHashRound(v1, read64(bytes));
+            v2 = xxHashRound(v2, read64(bytes+8));
+            v3 = xxHashRound(v3, read64(bytes+16));
+            v4 = xxHashRound(v4, read64(bytes+24));
+            bytes += 32;
+        }
+        while(bytes <= limit);
+
+        hash = rotateLeft(v1, 1) + rotateLeft(v2, 7) + rotateLeft(v3, 12) + rotateLeft(v4, 18);
+        hash = xxHashMerge(hash, v1);
+        hash = xxHashMerge(hash, v2);
+        hash = xxHashMerge(hash, v3);
+        hash = xxHashMerge(hash, v4);
+    }
+    else
+    {
+        hash = seed + XXHASH_PRIME5;
+    }
+
+    hash += (uint64_t) size;
+
+    while(bytes + 8 <= end)
+    {
+        hash ^= xxHashRound(0, read64(bytes));
+        hash = rotateLeft(hash, 27)*XXHASH_PRIME1 + XXHASH_PRIME4;
+        bytes += 8;
+    }
+
+    if(bytes + 4 <= end)
+    {
+        hash ^= (uint64_t) read32(bytes)*XXHASH_PRIME1;
+        hash = rotateLeft(hash, 23)*XXHASH_PRIME2 + XXHASH_PRIME3;
+        bytes += 4;
+    }
+
+    while(bytes < end)
+    {
+        hash ^= (*bytes)*XXHASH_PRIME5;
+        hash = rotateLeft(hash, 11)*XXHASH_PRIME1;
+        bytes++;
+    }
+
+    //Avalanche
+    hash ^= hash >> 33;
+    hash *= XXHASH_PRIME2;
+    hash ^= hash >> 29;
+    hash *= XXHASH_PRIME3;
+    hash ^= hash >> 32;
+
+    return hash;
+}
+
+/**
+ * Returns the hash of the content of a file (0 if the file cannot be read).
+ * The hash is kept in memory with the size and modification date of the file : a file that did not change is hashed once.
+ * @brief hashFile
+ * @param filePath
+ * @return
+ */
+uint64_t hashFile(const string filePath)
+{
+    static map<string, HashedFile> hashedFiles;
+    static mutex hashedFilesMutex;
+
+    HashedFile hashedFile;
+
+    if(!fileStatus(filePath, hashedFile.size, hashedFile.modificationTime))
+    {
+        return 0;
+    }
+
+    {
+        lock_guard<mutex> lock(hashedFilesMutex);
+        map<string, HashedFile>::const_iterator it = hashedFiles.find(filePath);
+
+        if(it != hashedFiles.end() && it->second.size == hashedFile.size && it->second.modificationTime == hashedFile.modificationTime)
+        {
+            return it->second.hash;
+        }
+    }
+
+    size_t size = 0;
+    void* mapping = mapFile(filePath, size);
+
+    if(mapping == NULL && hashedFile.size > 0)
+    {
+        cerr << "Could not hash the file : " << filePath << endl;
+        return 0;
+    }
+
+    hashedFile.hash = hashData(mapping, size);
+    unmapFile(mapping, size);
+
+    lock_guard<mutex> lock(hashedFilesMutex);
+    hashedFiles[filePath] = hashedFile;
+
+    return hashedFile.hash;
+}
+
+/**
+ * Returns the key of a cache entry generated from a source file of hash sourceHash with the given parameters.
+ * The parameters must describe everything that changes the images generated (generator name, sizes, number of samples...).
+ * @brief cacheKey
+ * @param sourceHash
+ * @param parameters
+ * @return
+ */
+uint64_t cacheKey(uint64_t sourceHash, const string parameters)
+{
+    return hashData(parameters.data(), parameters.size(), sourceHash + DATA_CACHE_VERSION);
+}
+
+/**
+ * Default constructor. No file is mapped.
+ * @brief DataCacheEntry
+ */
+DataCacheEntry::DataCacheEntry(): m_mapping(NULL), m_mappingSize(0)
+{
+
+}
+
+/**
+  * Destructor. Unmaps the file.
+  */
+DataCacheEntry::~DataCacheEntry()
+{
+    close();
+}
+
+/**
+ * Maps the cache file filePath in memory. Any previously mapped file is unmapped.
+ * Returns true if the file is a valid cache file of the current version for the key.
+ * @brief open
+ * @param filePath
+ * @param key
+ * @return
+ */
+bool DataCacheEntry::open(const string filePath, uint64_t key)
+{
+    close();
+
+    size_t size = 0;
+    void* mapping = mapFile(filePath, size);
+
+    if(mapping == NULL)
+    {
+        return false;
+    }
+
+    const DataCacheHeader* header = (const DataCacheHeader*) mapping;
+
+    bool valid = size >= sizeof(DataCacheHeader)
+            && memcmp(header->magic, "R3DCACHE", 8) == 0
+            && header->version == DATA_CACHE_VERSION
+            && header->byteOrderMark == DATA_CACHE_BYTE_ORDER_MARK
+            && header->key == key
+            && header->fileSize == (uint64_t) size
+            && header->numberOfLevels >= 1 && header->numberOfLevels <= DATA_CACHE_MAXIMUM_LEVELS
+            && (header->numberOfComponents == 1 || header->numberOfComponents == 3);
+
+    for(uint32_t l = 0 ; valid && l<header->numberOfLevels ; ++l)
+    {
+        uint64_t levelSize = (uint64_t) header->width[l]*header->height[l]*header->numberOfComponents*sizeof(float);
+
+        valid = header->offset[l] % DATA_CACHE_ALIGNMENT == 0 && header->offset[l] >= sizeof(DataCacheHeader)
+                && header->offset[l] + levelSize <= header->fileSize && levelSize > 0;
+    }
+
+    if(!valid)
+    {
+        unmapFile(mapping, size);
+        return false;
+    }
+
+    m_mapping = mapping;
+    m_mappingSize = size;
+
+    return true;
+}
+
+/**
+ * Unmaps the file.
+ * @brief close
+ */
+void DataCacheEntry::close()
+{
+    unmapFile(m_mapping, m_mappingSize);
+
+    m_mapping = NULL;
+    m_mappingSize = 0;
+}
+
+/**
+ * Returns true if a file is mapped.
+ * @brief isOpen
+ * @return
+ */
+bool DataCacheEntry::isOpen() const
+{
+    return m_mapping != NULL;
+}
+
+/**
+ * Returns the number of levels of the entry.
+ * @brief getNumberOfLevels
+ * @return
+ */
+int DataCacheEntry::getNumberOfLevels() const
+{
+    if(m_mapping == NULL)
+        return 0;
+
+    return (int) ((const DataCacheHeader*) m_mapping)->numberOfLevels;
+}
+
+/**
+ * Returns the number of color channels of the entry (1 or 3).
+ * @brief getNumberOfComponents
+ * @return
+ */
+int DataCacheEntry::getNumberOfComponents() const
+{
+    if(m_mapping == NULL)
+        return 0;
+
+    return (int) ((const DataCacheHeader*) m_mapping)->numberOfComponents;
+}
+
+/**
+ * Returns the width of a level.
+ * @brief getWidth
+ * @param level
+ * @return
+ */
+int DataCacheEntry::getWidth(int level) const
+{
+    if(level < 0 || level >= getNumberOfLevels())
+        return 0;
+
+    return (int) ((const DataCacheHeader*) m_mapping)->width[level];
+}
+
+/**
+ * Returns the height of a level.
+ * @brief getHeight
+ * @param level
+ * @return
+ */
+int DataCacheEntry::getHeight(int level) const
+{
+    if(level < 0 || level >= getNumberOfLevels())
+        return 0;
+
+    return (int) ((const DataCacheHeader*) m_mapping)->height[level];
+}
+
+/**
+ * Returns a pointer to the first pixel of a level (bottom left corner of the image, RGB order).
+ * @brief getPixels
+ * @param level
+ * @return
+ */
+const float* DataCacheEntry::getPixels(int level) const
+{
+    if(level < 0 || level >= getNumberOfLevels())
+        return NULL;
+
+    return (const float*) ((const char*) m_mapping + ((const DataCacheHeader*) m_mapping)->offset[level]);
+}
+
+/**
+ * Returns a copy of a level as an OpenCV image (CV_32FC3 in BGR order or CV_32FC1, rows from the top to the bottom).
+ * @brief getImage
+ * @param level
+ * @return
+ */
+Mat DataCacheEntry::getImage(int level) const
+{
+    const float* pixels = getPixels(level);
+
+    if(pixels == NULL)
+    {
+        return Mat();
+    }
+
+    const int width = getWidth(level);
+    const int height = getHeight(level);
+    const int numberOfComponents = getNumberOfComponents();
+
+    Mat image(height, width, CV_MAKETYPE(CV_32F, numberOfComponents));
+
+    for(int i = 0 ; i<height ; ++i)
+    {
+        const float* source = pixels + (size_t) (height-1-i)*width*numberOfComponents;
+        float* destination = image.ptr<float>(i);
+
+        if(numberOfComponents == 3)
+        {
+            for(int j = 0 ; j<width ; ++j)
+            {
+                destination[3*j] = source[3*j+2];
+                destination[3*j+1] = source[3*j+1];
+                destination[3*j+2] = source[3*j];
+            }
+        }
+        else
+        {
+            memcpy(destination, source, width*sizeof(float));
+        }
+    }
+
+    return image;
+}
+
+/**
+ * Creates a cache in the directory (created if it does not exist) with a maximum size in bytes.
+ * @brief DataCache
+ * @param directory
+ * @param maximumSize
+ */
+DataCache::DataCache(const string directory, uint64_t maximumSize): m_directory(directory), m_maximumSize(maximumSize)
+{
+#ifdef _WIN32
+    CreateDirectoryA(m_directory.c_str(), NULL);
+#else
+    mkdir(m_directory.c_str(), 0755);
+#endif
+}
+
+/**
+ * Maps the entry of the key in memory and marks it as recently used.
+ * Returns false if the cache does not contain the key.
+ * @brief load
+ * @param key
+ * @param entry
+ * @return
+ */
+bool DataCache::load(uint64_t key, DataCacheEntry& entry)
+{
+    string filePath = entryFilePath(key);
+
+    if(!entry.open(filePath, key))
+    {
+        //Files of another version or incomplete files are replaced by the next store
+        return false;
+    }
+
+    //The modification date is the date of the last use
+    touchFile(filePath);
+
+    return true;
+}
+
+/**
+ * Stores images (CV_32FC3 in BGR order or CV_32FC1, same number of channels) as the entry of the key
+ * then removes the least recently used entries if the cache is larger than its maximum size.
+ * Returns true if the entry was stored.
+ * @brief store
+ * @param key
+ * @param levels
+ * @return
+ */
+bool DataCache::store(uint64_t key, const vector<Mat>& levels)
+{
+    if(levels.empty() || levels.size() > DATA_CACHE_MAXIMUM_LEVELS)
+    {
+        cerr << "A cache entry must have between 1 and " << DATA_CACHE_MAXIMUM_LEVELS << " levels." << endl;
+        return false;
+    }
+
+    const int numberOfComponents = levels[0].channels();
+
+    for(unsigned int l = 0 ; l<levels.size() ; ++l)
+    {
+        if(levels[l].empty() || levels[l].depth() != CV_32F || levels[l].channels() != numberOfComponents || (numberOfComponents != 1 && numberOfComponents != 3))
+        {
+            cerr << "The levels of a cache entry must be CV_32FC3 or CV_32FC1 images." << endl;
+            return false;
+        }
+    }
+
+    DataCacheHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, "R3DCACHE", 8);
+    header.version = DATA_CACHE_VERSION;
+    header.byteOrderMark = DATA_CACHE_BYTE_ORDER_MARK;
+    header.key = key;
+    header.numberOfLevels = (uint32_t) levels.size();
+    header.numberOfComponents = (uint32_t) numberOfComponents;
+
+    uint64_t offset = alignedSize(sizeof(DataCacheHeader));
+
+    for(unsigned int l = 0 ; l<levels.size() ; ++l)
+    {
+        header.width[l] = (uint32_t) levels[l].cols;
+        header.height[l] = (uint32_t) levels[l].rows;
+        header.offset[l] = offset;
+        offset += alignedSize((uint64_t) levels[l].cols*levels[l].rows*numberOfComponents*sizeof(float));
+    }
+
+    header.fileSize = offset;
+
+    //The file is written under another name then renamed : an entry is either complete or missing
+    string filePath = entryFilePath(key);
+    string temporaryFilePath = filePath + string(".tmp");
+
+    ofstream file(temporaryFilePath.c_str(), ios::out | ios::binary | ios::trunc);
+
+    if(!file)
+    {
+        cerr << "Could not write the cache file : " << temporaryFilePath << endl;
+        return false;
+    }
+
+    file.write((const char*) &header, sizeof(header));
+
+    vector<char> padding(DATA_CACHE_ALIGNMENT, 0);
+    vector<float> row;
+    uint64_t position = sizeof(header);
+
+    for(unsigned int l = 0 ; l<levels.size() ; ++l)
+    {
+        file.write(&padding[0], header.offset[l]-position);
+
+        const Mat& level = levels[l];
+        const size_t rowSize = (size_t) level.cols*numberOfComponents;
+        row.resize(rowSize);
+
+        //Rows from the bottom to the top in RGB order
+        for(int i = level.rows-1 ; i >= 0 ; --i)
+        {
+            const float* source = level.ptr<float>(i);
+
+            if(numberOfComponents == 3)
+            {
+                for(int j = 0 ; j<level.cols ; ++j)
+                {
+                    row[3*j] = source[3*j+2];
+                    row[3*j+1] = source[3*j+1];
+                    row[3*j+2] = source[3*j];
+                }
+
+                file.write((const char*) &row[0], rowSize*sizeof(float));
+            }
+            else
+            {
+                file.write((const char*) source, rowSize*sizeof(float));
+            }
+        }
+
+        position = header.offset[l] + (uint64_t) level.rows*rowSize*sizeof(float);
+    }
+
+    file.write(&padding[0], header.fileSize-position);
+    file.close();
+
+    if(!file)
+    {
+        cerr << "Could not write the cache file : " << temporaryFilePath << endl;
+        remove(temporaryFilePath.c_str());
+        return false;
+    }
+
+    remove(filePath.c_str());
+
+    if(rename(temporaryFilePath.c_str(), filePath.c_str()) != 0)
+    {
+        cerr << "Could not write the cache file : " << filePath << endl;
+        remove(temporaryFilePath.c_str());
+        return false;
+    }
+
+    evict();
+
+    return true;
+}
+
+/**
+ * Removes the least recently used entries until the cache is smaller than its maximum size.
+ * @brief evict
+ */
+void DataCache::evict()
+{
+    vector<CacheFile> files = listCacheFiles(m_directory);
+
+    uint64_t totalSize = 0;
+    for(unsigned int k = 0 ; k<files.size() ; ++k)
+    {
+        totalSize += files[k].size;
+    }
+
+    if(totalSize <= m_maximumSize)
+    {
+        return;
+    }
+
+    //Least recently used first
+    sort(files.begin(), files.end(), [](const CacheFile& a, const CacheFile& b)
+    {
+        return a.modificationTime < b.modificationTime;
+    });
+
+    for(unsigned int k = 0 ; k<files.size() && totalSize > m_maximumSize ; ++k)
+    {
+        if(remove(files[k].filePath.c_str()) == 0)
+        {
+            totalSize -= files[k].size;
+        }
+    }
+}
+
+/**
+ * Returns the directory of the cache.
+ * @brief getDirectory
+ * @return
+ */
+string DataCache::getDirectory() const
+{
+    return m_directory;
+}
+
+/**
+ * Returns the path of the file of the entry of the key.
+ * @brief entryFilePath
+ * @param key
+ * @return
+ */
+string DataCache::entryFilePath(uint64_t key) const
+{
+    char name[17];
+    snprintf(name, sizeof(name), "%016llx", (unsigned long long) key);
+
+    return m_directory + string("/") + string(name) + string(DATA_CACHE_EXTENSION);
+}
@@ -0,0 +1,293 @@
+/*
+ *     Real3D
+ *
+ *     Author:  Antoine TOISOUL LE CANN
+ *
+ *     Copyright © 2016 Antoine TOISOUL LE CANN, Imperial College London
+ *              All rights reserved
+ *
+ *
+ * Real3D is free software: you can redistribute it and/or modify
+ *
+ * it under the terms of the GNU Lesser General Public License as published by
+ *
+ * the Free Software Foundation, either version 3 of the License, or
+ *
+ * (at your option) any later version.
+ *
+ * Real3D is distributed in the hope that it will be useful,
+ *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ *
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * \file datacache.h
+ * \brief On disk cache of the images derived from source files.
+ * \author Antoine Toisoul Le Cann
+ * \date October, 16th, 2026
+ *
+ * Content addressed cache : the entries are keyed by a hash of the content of the source file and of the parameters
+ * used to generate the images. Each entry is a binary file that is mapped in memory and sent directly to OpenGL.
+ * The least recently used entries are removed when the cache exceeds its maximum size.
+ */
+
+#ifndef DATACACHE_H
+#define DATACACHE_H
+
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <cstring>
+#include <stdint.h>
+
+#include <opencv2/core/core.hpp>
+
+#define DATA_CACHE_VERSION 1 /*!< Version of the layout of the cache files. The files of other versions are ignored. */
+#define DATA_CACHE_MAXIMUM_SIZE 1073741824ULL /*!< Default maximum size of the cache in bytes (1 GB). */
+#define DATA_CACHE_MAXIMUM_LEVELS 16 /*!< Maximum number of levels (images) of a cache entry. */
+#define DATA_CACHE_ALIGNMENT 64 /*!< Alignment in bytes of the levels in the cache files. */
+#define DATA_CACHE_EXTENSION ".cache" /*!< Extension of the cache files. */
+
+/**
+ * Header at the beginning of each cache file. The file is stored in the byte order of the machine.
+ * The levels are stored after the header at the given offsets : floats in RGB order (or grayscale),
+ * rows stored from the bottom to the top of the image as OpenGL expects.
+ */
+struct DataCacheHeader
+{
+    char magic[8]; /*!< "R3DCACHE". */
+    uint32_t version; /*!< DATA_CACHE_VERSION. */
+    uint32_t byteOrderMark; /*!< 0x01020304 in the byte order of the machine that wrote the file. */
+    uint64_t key; /*!< Key of the entry. */
+    uint64_t fileSize; /*!< Size of the file in bytes. */
+    uint32_t numberOfLevels; /*!< Number of levels. */
+    uint32_t numberOfComponents; /*!< Number of color channels (1 or 3). */
+    uint32_t width[DATA_CACHE_MAXIMUM_LEVELS]; /*!< Width of each level. */
+    uint32_t height[DATA_CACHE_MAXIMUM_LEVELS]; /*!< Height of each level. */
+    uint64_t offset[DATA_CACHE_MAXIMUM_LEVELS]; /*!< Offset of each level from the beginning of the file in bytes. */
+};
+
+/**
+ * Maps a whole file in memory (read only). Returns NULL if the file cannot be mapped or is empty.
+ * The mapping must be released with unmapFile.
+ * @brief mapFile
+ * @param filePath
+ * @param size
+ * @return
+ */
+void* mapFile(const std::string filePath, size_t& size);
+
+/**
+ * Unmaps a file mapped by mapFile.
+ * @brief unmapFile
+ * @param mapping
+ * @param size
+ */
+void unmapFile(void* mapping, size_t size);
+
+/**
+ * Reads the size and the modification date of a file. Returns false if the file does not exist.
+ * @brief fileStatus
+ * @param filePath
+ * @param size
+ * @param modificationTime
+ * @return
+ */
+bool fileStatus(const std::string filePath, uint64_t& size, int64_t& modificationTime);
+
+/**
+ * Returns the 64 bits xxHash of size bytes of data.
+ * @brief hashData
+ * @param data
+ * @param size
+ * @param seed
+ * @return
+ */
+uint64_t hashData(const void* data, size_t size, uint64_t seed = 0);
+
+/**
+ * Returns the hash of the content of a file (0 if the file cannot be read).
+ * The hash is kept in memory with the size and modification date of the file : a file that did not change is hashed once.
+ * @brief hashFile
+ * @param filePath
+ * @return
+ */
+uint64_t hashFile(const std::string filePath);
+
+/**
+ * Returns the key of a cache entry generated from a source file of hash sourceHash with the given parameters.
+ * The parameters must describe everything that changes the images generated (generator name, sizes, number of samples...).
+ * @brief cacheKey
+ * @param sourceHash
+ * @param parameters
+ * @return
+ */
+uint64_t cacheKey(uint64_t sourceHash, const std::string parameters);
+
+/**
+ * Read only memory mapping of a cache file.
+ * The levels are exposed directly from the file without any copy.
+ */
+class DataCacheEntry
+{
+    public:
+        /**
+         * Default constructor. No file is mapped.
+         * @brief DataCacheEntry
+         */
+        DataCacheEntry();
+
+        /**
+          * Destructor. Unmaps the file.
+          */
+        ~DataCacheEntry();
+
+        /**
+         * Maps the cache file filePath in memory. Any previously mapped file is unmapped.
+         * Returns true if the file is a valid cache file of the current version for the key.
+         * @brief open
+         * @param filePath
+         * @param key
+         * @return
+         */
+        bool open(const std::string filePath, uint64_t key);
+
+        /**
+         * Unmaps the file.
+         * @brief close
+         */
+        void close();
+
+        /**
+         * Returns true if a file is mapped.
+         * @brief isOpen
+         * @return
+         */
+        bool isOpen() const;
+
+        /**
+         * Returns the number of levels of the entry.
+         * @brief getNumberOfLevels
+         * @return
+         */
+        int getNumberOfLevels() const;
+
+        /**
+         * Returns the number of color channels of the entry (1 or 3).
+         * @brief getNumberOfComponents
+         * @return
+         */
+        int getNumberOfComponents() const;
+
+        /**
+         * Returns the width of a level.
+         * @brief getWidth
+         * @param level
+         * @return
+         */
+        int getWidth(int level) const;
+
+        /**
+         * Returns the height of a level.
+         * @brief getHeight
+         * @param level
+         * @return
+         */
+        int getHeight(int level) const;
+
+        /**
+         * Returns a pointer to the first pixel of a level (bottom left corner of the image, RGB order).
+         * @brief getPixels
+         * @param level
+         * @return
+         */
+        const float* getPixels(int level) const;
+
+        /**
+         * Returns a copy of a level as an OpenCV image (CV_32FC3 in BGR order or CV_32FC1, rows from the top to the bottom).
+         * @brief getImage
+         * @param level
+         * @return
+         */
+        cv::Mat getImage(int level) const;
+
+    private:
+        DataCacheEntry(const DataCacheEntry&) = delete;
+        DataCacheEntry& operator=(const DataCacheEntry&) = delete;
+
+        void* m_mapping; /*!< Address of the mapping. */
+        size_t m_mappingSize; /*!< Size of the mapping in bytes. */
+};
+
+/**
+ * Directory of cache files with a maximum size.
+ * The modification date of a file is the date of its last use : the oldest files are removed first.
+ */
+class DataCache
+{
+    public:
+        /**
+         * Creates a cache in the directory (created if it does not exist) with a maximum size in bytes.
+         * @brief DataCache
+         * @param directory
+         * @param maximumSize
+         */
+        DataCache(const std::string directory, uint64_t maximumSize = DATA_CACHE_MAXIMUM_SIZE);
+
+        /**
+         * Maps the entry of the key in memory and marks it as recently used.
+         * Returns false if the cache does not contain the key.
+         * @brief load
+         * @param key
+         * @param entry
+         * @return
+         */
+        bool load(uint64_t key, DataCacheEntry& entry);
+
+        /**
+         * Stores images (CV_32FC3 in BGR order or CV_32FC1, same number of channels) as the entry of the key
+         * then removes the least recently used entries if the cache is larger than its maximum size.
+         * Returns true if the entry was stored.
+         * @brief store
+         * @param key
+         * @param levels
+         * @return
+         */
+        bool store(uint64_t key, const std::vector<cv::Mat>& levels);
+
+        /**
+         * Removes the least recently used entries until the cache is smaller than its maximum size.
+         * @brief evict
+         */
+        void evict();
+
+        /**
+         * Returns the directory of the cache.
+         * @brief getDirectory
+         * @return
+         */
+        std::string getDirectory() const;
+
+    private:
+        /**
+         * Returns the path of the file of the entry of the key.
+         * @brief entryFilePath
+         * @param key
+         * @return
+         */
+        std::string entryFilePath(uint64_t key) const;
+
+        std::string m_directory; /*!< Directory of the cache files. */
+        uint64_t m_maximumSize; /*!< Maximum size of the cache in bytes. */
+};
+
+#endif // DATACACHE_H
@@ -0,0 +1,105 @@
+/*
+ *     Real3D
+ *
+ *     Author:  Antoine TOISOUL LE CANN
+ *
+ *     Copyright © 2016 Antoine TOISOUL LE CANN, Imperial College London
+ *              All rights reserved
+ *
+ *
+ * Real3D is free software: you can redistribute it and/or modify
+ *
+ * it under the terms of the GNU Lesser General Public License as published by
+ *
+ * the Free Software Foundation, either version 3 of the License, or
+ *
+ * (at your option) any later version.
+ *
+ * Real3D is distributed in the hope that it will be useful,
+ *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ *
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * \file parallel.h
+ * \brief Splits a loop over several threads.
+ * \author Antoine Toisoul Le Cann
+ * \date October, 16th, 2026
+ *
+ * Implementation of a parallel for loop with the standard library threads.
+ */
+
+#ifndef PARALLEL_H
+#define PARALLEL_H
+
+#include <algorithm>
+#include <thread>
+#include <vector>
+
+/**
+ * Returns the number of threads that can run at the same time on the machine (at least 1).
+ * @brief numberOfCores
+ * @return
+ */
+inline int numberOfCores()
+{
+    int cores = (int) std::thread::hardware_concurrency();
+    return std::max(cores, 1);
+}
+
+/**
+ * Splits [begin ; end) in numberOfThreads ranges of the same size and calls function(first, last) on each range
+ * in parallel. Returns once every range has been processed. The calling thread processes the first range.
+ * If numberOfThreads <= 0, the number of cores of the machine is used.
+ * @brief parallelFor
+ * @param begin
+ * @param end
+ * @param function
+ * @param numberOfThreads
+ */
+template<typename Function>
+void parallelFor(const int begin, const int end, Function function, int numberOfThreads = 0)
+{
+    if(numberOfThreads <= 0)
+    {
+        numberOfThreads = numberOfCores();
+    }
+
+    numberOfThreads = std::min(numberOfThreads, end-begin);
+
+    if(numberOfThreads <= 1)
+    {
+        if(begin < end)
+            function(begin, end);
+
+        return;
+    }
+
+    const long long size = end-begin;
+    std::vector<std::thread> threads;
+
+    for(int k = 1 ; k<numberOfThreads ; ++k)
+    {
+        int first = begin + (int) (size*k/numberOfThreads);
+        int last = begin + (int) (size*(k+1)/numberOfThreads);
+
+        threads.push_back(std::thread(function, first, last));
+    }
+
+    function(begin, begin + (int) (size/numberOfThreads));
+
+    for(size_t k = 0 ; k<threads.size() ; ++k)
+    {
+        threads[k].join();
+    }
+}
+
+#endif // PARALLEL_H
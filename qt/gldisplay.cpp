@@ -48,11 +48,11 @@ using namespace cv;
  * @param parent
  */
 GLDisplay::GLDisplay(QWidget *parent) : QGLWidget(QGLFormat(), parent),
-    m_cameraScene(Camera()), m_cameraQuad(Camera()),
+    m_screenQuad(), m_cameraScene(Camera()), m_cameraQuad(Camera()),
     m_mousePos(0,0),
     m_shaderName(SHADER_NAME), m_backgroundProgram(), m_shaderProgram(), m_shaderProgramDisplay(),
     m_timeFPS(QTime()), m_lastFPSUpdate(0), m_frameCounter(0), m_FPS(0),
-    m_environmentMapping(false), m_exposure(0.0),
+    m_environmentMapping(false), m_compactVertices(false), m_exposure(0.0),
     m_animationStarted(false), m_updateDisplayTimer(), m_animationTime(QTime())
 {
     m_scene = Scene();
@@ -72,11 +72,11 @@ GLDisplay::GLDisplay(QWidget *parent) : QGLWidget(QGLFormat(), parent),
  * @param parent
  */
 GLDisplay::GLDisplay(const QGLFormat& glFormat, QWidget *parent) : QGLWidget(glFormat, parent),
-    m_cameraScene(Camera()), m_cameraQuad(Camera()),
+    m_screenQuad(), m_cameraScene(Camera()), m_cameraQuad(Camera()),
     m_mousePos(0,0),
     m_shaderName(SHADER_NAME), m_backgroundProgram(), m_shaderProgram(), m_shaderProgramDisplay(),
     m_timeFPS(QTime()), m_lastFPSUpdate(0), m_frameCounter(0), m_FPS(0),
-    m_environmentMapping(false), m_exposure(0.0),
+    m_environmentMapping(false), m_compactVertices(false), m_exposure(0.0),
     m_animationStarted(false), m_updateDisplayTimer(), m_animationTime(QTime())
 {
     m_scene = Scene();
@@ -94,7 +94,18 @@ GLDisplay::GLDisplay(const QGLFormat& glFormat, QWidget *parent) : QGLWidget(glF
   */
 GLDisplay::~GLDisplay()
 {
+    //The textures and the framebuffer are deleted with the OpenGL functions : the context of the widget must be current
+    makeCurrent();
 
+    //The callbacks of the saves use the widget : wait until they are finished
+    for(size_t k = 0 ; k<m_pendingSaves.size() ; ++k)
+    {
+        m_pendingSaves[k].wait();
+    }
+
+    //Release the meshes and the textures of the registry used by the objects while the context exists
+    m_scene.removeObjects();
+    m_screenQuad = Object();
 }
 
 /**
@@ -119,6 +130,9 @@ void GLDisplay::initializeGL()
     glEnable(GL_CULL_FACE);
     glEnable(GL_MULTISAMPLE);
 
+    //Filter the environment maps across the edges of the faces of the cubemaps
+    glEnable(GL_TEXTURE_CUBE_MAP_SEAMLESS);
+
     qglClearColor(QColor(Qt::black));
 
     QString path = qApp->applicationDirPath();
@@ -178,6 +192,11 @@ void GLDisplay::initializeGL()
     m_framebuffer = FrameBuffer(FRAMEBUFFER_WIDTH, FRAMEBUFFER_HEIGHT);
     m_framebuffer.load_8UC3();
 
+    //The quad covers the entire screen with the aspect ratio of the framebuffer
+    m_screenQuad = Object(string("square"));
+    m_screenQuad.setAspectRatio((float)m_framebuffer.getWidth()/(float)m_framebuffer.getHeight());
+    m_screenQuad.scale(2.0);
+
     /*---- Camera initialisation to render----*/
     //The camera that displays the final square is the moving camera
     //Compute the transformation of the camera
@@ -240,6 +259,9 @@ void GLDisplay::paintGL()
         this->animation();
     }
 
+    //Uploads the batches of samples of the rough specular convolution of the environment map prefiltered on a worker thread
+    bool refiningEnvironmentMap = m_environmentMapping && m_scene.refineEnvironmentMapRough();
+
     //Render the scene
     this->renderScene();
 
@@ -249,12 +271,16 @@ void GLDisplay::paintGL()
     //Draw the number of FPS
     this->drawFPS();
 
-    if(m_animationStarted)
+    if(m_animationStarted || refiningEnvironmentMap)
     {
         //Timer to update the display at each frame
         //Otherwise the animation is not shown on the screen
         m_updateDisplayTimer.start(20);
     }
+    else
+    {
+        m_updateDisplayTimer.stop();
+    }
 
 }
 
@@ -279,19 +305,15 @@ void GLDisplay::renderScene()
     projectionScene =  m_cameraScene.getProjectionMatrix();
 
     //The textures must be loaded at each frame
-    //Send the time of animation in milliseconds
-    m_shaderProgram.setUniformValue("timeMs", m_animationTime.elapsed());
+    //Send the rotation of the environment map at the time of the animation
+    m_shaderProgram.setUniformValue("environmentMapRotation", environmentMapRotation());
 
-    //Load the scene
-    QVector<Object> objectList = m_scene.getObjects();
+    //Load the scene (the objects, their meshes and their textures are not copied)
+    const QVector<Object>& objectList = m_scene.getObjects();
     QVector<Light> pointLights = m_scene.getPointLightSources();
 
     //Repeat that for each object
     QMatrix4x4 modelMatrixObject = QMatrix4x4();
-    QVector<QVector3D> vertices;
-    QVector<QVector3D> normals;
-    QVector<QVector2D> textureCoordinates;
-    QVector<GLuint> indicesArray;
     QVector4D lightPosition = pointLights[0].getLightPosition();
     QMatrix4x4 lightModelMatrix = pointLights[0].getModelMatrix();
 
@@ -300,10 +322,10 @@ void GLDisplay::renderScene()
     {
         //Get the data
         modelMatrixObject = objectList[k].getModelMatrix();
-        vertices =  objectList[k].getMesh().getVertices();
-        normals = objectList[k].getMesh().getVertexNormals();
-        textureCoordinates = objectList[k].getTextureCoordinates();
-        indicesArray = objectList[k].getMesh().getIndicesArray();
+        //The arrays are used without copy (they may be mapped from the mesh cache file)
+        //The level of detail depends on the size of the object on the screen
+        const int level = objectList[k].levelOfDetail(viewMatrixScene, projectionScene, m_framebuffer.getHeight());
+        const Mesh& mesh = objectList[k].getMesh(level);
 
         //Send uniform data to shaders
         //Do the maximum of matrix multiplication on the CPU for better efficiency
@@ -314,6 +336,7 @@ void GLDisplay::renderScene()
         m_shaderProgram.setUniformValue("lightPosition_camSpace", viewMatrixScene*lightModelMatrix*lightPosition); //Light position in the camera space
 
         m_shaderProgram.setUniformValue("environmentMapping", m_environmentMapping); //Is environmentMapping activated
+        m_shaderProgram.setUniformValue("environmentMapRoughLevels", m_scene.getEnvironmentMapRoughLevels()); //Mip levels of the rough specular convolution
 
         //sendData
         this->sendObjectDataToShaders(objectList[k]);
@@ -322,17 +345,61 @@ void GLDisplay::renderScene()
 
         /*---------------- Vertices, texture coordinates and normals ---------------------*/
 
-        m_shaderProgram.setAttributeArray("vertex_worldSpace", vertices.constData());
-        m_shaderProgram.enableAttributeArray("vertex_worldSpace");
+        //The meshes are only compressed when the shader decodes the compact vertex format (see updateCompactVertices)
+        const CompressedMesh* compressedMesh = mesh.getCompressedMesh();
+        m_shaderProgram.setUniformValue("compressedVertices", compressedMesh != NULL);
 
-        m_shaderProgram.setAttributeArray("textureCoordinate_input", textureCoordinates.constData());
-        m_shaderProgram.enableAttributeArray("textureCoordinate_input");
+        if(compressedMesh)
+        {
+            //The integers are normalized by OpenGL, the shader applies the offsets and extents
+            const CompressedVertex* vertices = compressedMesh->getVertexData();
+            m_shaderProgram.setUniformValue("positionOffset", compressedMesh->getPositionOffset());
+            m_shaderProgram.setUniformValue("positionExtent", compressedMesh->getPositionExtent());
+            m_shaderProgram.setUniformValue("textureCoordinateOffset", compressedMesh->getTextureCoordinateOffset());
+            m_shaderProgram.setUniformValue("textureCoordinateExtent", compressedMesh->getTextureCoordinateExtent());
+
+            m_shaderProgram.setAttributeArray("vertex_worldSpace", GL_UNSIGNED_SHORT, vertices->position, 4, sizeof(CompressedVertex));
+            m_shaderProgram.enableAttributeArray("vertex_worldSpace");
+
+            m_shaderProgram.setAttributeArray("textureCoordinate_input", GL_UNSIGNED_SHORT, vertices->textureCoordinate, 2, sizeof(CompressedVertex));
+            m_shaderProgram.enableAttributeArray("textureCoordinate_input");
 
-        m_shaderProgram.setAttributeArray("normal_worldSpace", normals.constData());
-        m_shaderProgram.enableAttributeArray("normal_worldSpace");
+            m_shaderProgram.setAttributeArray("normal_worldSpace", GL_SHORT, vertices->normal, 2, sizeof(CompressedVertex));
+            m_shaderProgram.enableAttributeArray("normal_worldSpace");
 
-        //Draw the current object
-        glDrawElements(GL_TRIANGLES, indicesArray.size(), GL_UNSIGNED_INT, indicesArray.constData());
+            //The sign of the bitangent is the fourth component of the position
+            m_shaderProgram.setAttributeArray("tangent_input", GL_SHORT, vertices->tangent, 2, sizeof(CompressedVertex));
+            m_shaderProgram.enableAttributeArray("tangent_input");
+
+            //Draw the current object
+            glDrawElements(GL_TRIANGLES, compressedMesh->getNumberOfIndices(), compressedMesh->getIndexType(), compressedMesh->getIndexData());
+        }
+        else
+        {
+            m_shaderProgram.setAttributeArray("vertex_worldSpace", mesh.getVertexData());
+            m_shaderProgram.enableAttributeArray("vertex_worldSpace");
+
+            m_shaderProgram.setAttributeArray("textureCoordinate_input", mesh.getTextureCoordinateData());
+            m_shaderProgram.enableAttributeArray("textureCoordinate_input");
+
+            m_shaderProgram.setAttributeArray("normal_worldSpace", mesh.getVertexNormalData());
+            m_shaderProgram.enableAttributeArray("normal_worldSpace");
+
+            //Meshes without tangents use the same tangent for all the vertices
+            if(mesh.getVertexTangentData())
+            {
+                m_shaderProgram.setAttributeArray("tangent_input", mesh.getVertexTangentData());
+                m_shaderProgram.enableAttributeArray("tangent_input");
+            }
+            else
+            {
+                m_shaderProgram.disableAttributeArray("tangent_input");
+                m_shaderProgram.setAttributeValue("tangent_input", QVector4D(1.0, 0.0, 0.0, 1.0));
+            }
+
+            //Draw the current object
+            glDrawElements(GL_TRIANGLES, mesh.getNumberOfIndices(), GL_UNSIGNED_INT, mesh.getIndexData());
+        }
 
         //Unbind the textures
         glBindTexture(GL_TEXTURE_2D, 0);
@@ -341,6 +408,7 @@ void GLDisplay::renderScene()
     m_shaderProgram.disableAttributeArray("vertex_worldSpace");
     m_shaderProgram.disableAttributeArray("normal_worldSpace");
     m_shaderProgram.disableAttributeArray("textureCoordinates_input");
+    m_shaderProgram.disableAttributeArray("tangent_input");
     glFlush();
     m_shaderProgram.release();
 
@@ -380,9 +448,7 @@ void GLDisplay::renderToTexture()
     glBindTexture(GL_TEXTURE_2D, m_framebuffer.getColorBufferID(0));
 
     //Render a quad
-    Object square = Object(string("square"));
-    square.setAspectRatio((float)m_framebuffer.getWidth()/(float)m_framebuffer.getHeight());
-    square.scale(2.0);
+    const Object& square = m_screenQuad;
 
     QMatrix4x4 viewMatrixQuad = m_cameraQuad.getViewMatrix();
     QMatrix4x4 projectionMatrixQuad = m_cameraQuad.getProjectionMatrix();
@@ -390,17 +456,17 @@ void GLDisplay::renderToTexture()
     m_shaderProgramDisplay.setUniformValue("mvMatrix", viewMatrixQuad*square.getModelMatrix());
     m_shaderProgramDisplay.setUniformValue("pMatrix", projectionMatrixQuad);
 
-    m_shaderProgramDisplay.setAttributeArray("vertex_worldSpace", square.getMesh().getVertices().constData());
+    m_shaderProgramDisplay.setAttributeArray("vertex_worldSpace", square.getMesh().getVertexData());
     m_shaderProgramDisplay.enableAttributeArray("vertex_worldSpace");
 
-    m_shaderProgramDisplay.setAttributeArray("textureCoordinate_input", square.getTextureCoordinates().constData());
+    m_shaderProgramDisplay.setAttributeArray("textureCoordinate_input", square.getMesh().getTextureCoordinateData());
     m_shaderProgramDisplay.enableAttributeArray("textureCoordinate_input");
 
-    m_shaderProgramDisplay.setAttributeArray("normal_worldSpace", square.getMesh().getVertexNormals().constData());
+    m_shaderProgramDisplay.setAttributeArray("normal_worldSpace", square.getMesh().getVertexNormalData());
     m_shaderProgramDisplay.enableAttributeArray("normal_worldSpace");
 
     //Draw the current object
-    glDrawElements(GL_TRIANGLES, square.getMesh().getIndicesArray().size(), GL_UNSIGNED_INT, square.getMesh().getIndicesArray().constData());
+    glDrawElements(GL_TRIANGLES, square.getMesh().getNumberOfIndices(), GL_UNSIGNED_INT, square.getMesh().getIndexData());
 
     m_shaderProgramDisplay.disableAttributeArray("vertex_worldSpace");
     m_shaderProgramDisplay.disableAttributeArray("normal_worldSpace");
@@ -429,8 +495,8 @@ void GLDisplay::renderBackground()
         cerr << "m_shaderProgramDisplay not bound" << endl;
     }
 
-    //Send the time to the background shader for environment map rotation
-    m_backgroundProgram.setUniformValue("timeMs", m_animationTime.elapsed());
+    //Send the rotation of the environment map to the background shader
+    m_backgroundProgram.setUniformValue("environmentMapRotation", environmentMapRotation());
 
     GLint environmentMapBackgroundId = glGetUniformLocation(m_backgroundProgram.programId(), "backgroundEnvMap");
 
@@ -439,28 +505,27 @@ void GLDisplay::renderBackground()
 
     //Bind the texture so that it can be used by the shader
     glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D,m_scene.getEnvironmentMapId());
+    glBindTexture(GL_TEXTURE_CUBE_MAP,m_scene.getEnvironmentMapId());
 
     //Display it on a rectangle  with correct aspect ratio
-    Object square = Object(string("square"));
-    square.setAspectRatio((float)m_framebuffer.getWidth()/(float)m_framebuffer.getHeight());
-    square.scale(2.0);//The square covers the entire screen
+    const Object& square = m_screenQuad;
 
     m_backgroundProgram.setUniformValue("mvMatrix", m_cameraQuad.getViewMatrix()*square.getModelMatrix());
     m_backgroundProgram.setUniformValue("vMatrix", m_cameraQuad.getViewMatrix()); //Inverse of the view matrix for environment mapping
     m_backgroundProgram.setUniformValue("pMatrix", m_cameraQuad.getProjectionMatrix());
 
-    m_backgroundProgram.setAttributeArray("vertex_worldSpace", square.getMesh().getVertices().constData());
+    m_backgroundProgram.setAttributeArray("vertex_worldSpace", square.getMesh().getVertexData());
     m_backgroundProgram.enableAttributeArray("vertex_worldSpace");
 
-    m_backgroundProgram.setAttributeArray("textureCoordinate_input", square.getTextureCoordinates().constData());
+    m_backgroundProgram.setAttributeArray("textureCoordinate_input", square.getMesh().getTextureCoordinateData());
     m_backgroundProgram.enableAttributeArray("textureCoordinate_input");
 
-    m_backgroundProgram.setAttributeArray("normal_worldSpace", square.getMesh().getVertexNormals().constData());
+    m_backgroundProgram.setAttributeArray("normal_worldSpace", square.getMesh().getVertexNormalData());
     m_backgroundProgram.enableAttributeArray("normal_worldSpace");
 
     //Draw the current object
-    glDrawElements(GL_TRIANGLES, square.getMesh().getIndicesArray().size(), GL_UNSIGNED_INT, square.getMesh().getIndicesArray().constData());
+    glDrawElements(GL_TRIANGLES, square.getMesh().getNumberOfIndices(), GL_UNSIGNED_INT, square.getMesh().getIndexData());
+    glBindTexture(GL_TEXTURE_CUBE_MAP, 0);
 
     m_backgroundProgram.disableAttributeArray("vertex_worldSpace");
     m_backgroundProgram.disableAttributeArray("normal_worldSpace");
@@ -474,6 +539,25 @@ void GLDisplay::renderBackground()
     glDepthMask(GL_TRUE);
 }
 
+/**
+ * Returns the rotation of the environment map around the y axis at the current time of the animation
+ * (360 degrees in 40 s). The shaders turn their lookup directions in the cubemaps with this matrix.
+ * @brief environmentMapRotation
+ * @return
+ */
+QMatrix3x3 GLDisplay::environmentMapRotation() const
+{
+    //0.018 degrees/ms = 360 degrees in 20 s, slowed down by a factor 2
+    float timeScale = 0.5;
+    float angle = m_animationTime.elapsed()*0.018*timeScale;
+
+    //Same direction as an increase of the angle phi of the latitude longitude maps
+    QMatrix4x4 rotation;
+    rotation.rotate(angle, 0.0, 1.0, 0.0);
+
+    return rotation.toGenericMatrix<3,3>();
+}
+
 /**
  * Draws the number of frame per second on the OpenGL window.
  * @brief drawFPS
@@ -504,7 +588,7 @@ void GLDisplay::drawFPS()
  * @brief sendObjectDataToShaders
  * @param object
  */
-void GLDisplay::sendObjectDataToShaders(Object &object)
+void GLDisplay::sendObjectDataToShaders(const Object &object)
 {
     Material material = Material();
     material = object.getMaterial();
@@ -524,6 +608,7 @@ void GLDisplay::sendObjectDataToShaders(Object &object)
     GLint envMapId = glGetUniformLocation(m_shaderProgram.programId(), "environmentMap");
     GLint envMapRoughId = glGetUniformLocation(m_shaderProgram.programId(), "environmentMapRough");
     GLint envMapDiffuseId = glGetUniformLocation(m_shaderProgram.programId(), "environmentMapDiffuse");
+    GLint brdfLUTId = glGetUniformLocation(m_shaderProgram.programId(), "brdfLUT");
 
     glActiveTexture(GL_TEXTURE0);
     glUniform1i(diffuseMapId, 0); // 0 is the texture number
@@ -546,6 +631,9 @@ void GLDisplay::sendObjectDataToShaders(Object &object)
     glActiveTexture(GL_TEXTURE0+6);
     glUniform1i(envMapDiffuseId, 6); // 6 is the texture number
 
+    glActiveTexture(GL_TEXTURE0+7);
+    glUniform1i(brdfLUTId, 7); // 7 is the texture number
+
     glActiveTexture(GL_TEXTURE0);
     glBindTexture(GL_TEXTURE_2D, object.getDiffuseTexture().getTextureId());
 
@@ -559,13 +647,16 @@ void GLDisplay::sendObjectDataToShaders(Object &object)
     glBindTexture(GL_TEXTURE_2D, object.getRoughnessMap().getTextureId());
 
     glActiveTexture(GL_TEXTURE0+4);
-    glBindTexture(GL_TEXTURE_2D, m_scene.getEnvironmentMapId());
+    glBindTexture(GL_TEXTURE_CUBE_MAP, m_scene.getEnvironmentMapId());
 
     glActiveTexture(GL_TEXTURE0+5);
-    glBindTexture(GL_TEXTURE_2D, m_scene.getEnvironmentMapRoughId());
+    glBindTexture(GL_TEXTURE_CUBE_MAP, m_scene.getEnvironmentMapRoughId());
 
     glActiveTexture(GL_TEXTURE0+6);
-    glBindTexture(GL_TEXTURE_2D, m_scene.getEnvironmentMapDiffuseId());
+    glBindTexture(GL_TEXTURE_CUBE_MAP, m_scene.getEnvironmentMapDiffuseId());
+
+    glActiveTexture(GL_TEXTURE0+7);
+    glBindTexture(GL_TEXTURE_2D, m_scene.getBRDFLUTId());
 
 }
 
@@ -795,27 +886,33 @@ void GLDisplay::updateDisplay()
 
 /**
  * Takes a screenshot and saves it to the folder /screenshot/.
+ * The floating point rendering is also saved as a PFM file without blocking the interface.
  * @brief takeScreenshot
  */
 void GLDisplay::takeScreenshot()
 {
     int width = m_framebuffer.getWidth();
     int height = m_framebuffer.getHeight();
-    float *data = new float[width*height*3];
+    vector<float> data(width*height*3);
     glBindFramebuffer(GL_FRAMEBUFFER, m_framebuffer.getFramebufferID());
 
     //Read all the pixels
-    glReadPixels(0,0, width,height, GL_RGB, GL_FLOAT, data);
+    glReadPixels(0,0, width,height, GL_RGB, GL_FLOAT, &data[0]);
 
     //Convert to an openCV matrix
     Mat picture = Mat(height, width, CV_32FC3);
+    Mat pictureFloat = Mat(height, width, CV_32FC3);
     for(int i = 0 ; i<height ; i++)
     {
         for(int j = 0 ; j<width ; j++)
         {
-            picture.at<Vec3f>(i,j).val[2] = floor(255.0*data[3*((height-1-i)*width+j)]);
-            picture.at<Vec3f>(i,j).val[1] = floor(255.0*data[3*((height-1-i)*width+j)+1]);
-            picture.at<Vec3f>(i,j).val[0] = floor(255.0*data[3*((height-1-i)*width+j)+2]);
+            pictureFloat.at<Vec3f>(i,j).val[2] = data[3*((height-1-i)*width+j)];
+            pictureFloat.at<Vec3f>(i,j).val[1] = data[3*((height-1-i)*width+j)+1];
+            pictureFloat.at<Vec3f>(i,j).val[0] = data[3*((height-1-i)*width+j)+2];
+
+            picture.at<Vec3f>(i,j).val[2] = floor(255.0*pictureFloat.at<Vec3f>(i,j).val[2]);
+            picture.at<Vec3f>(i,j).val[1] = floor(255.0*pictureFloat.at<Vec3f>(i,j).val[1]);
+            picture.at<Vec3f>(i,j).val[0] = floor(255.0*pictureFloat.at<Vec3f>(i,j).val[0]);
         }
     }
 
@@ -826,6 +923,27 @@ void GLDisplay::takeScreenshot()
     QString log;
     log = QString("Screenshot saved : %1").arg(qApp->applicationDirPath()+"/screenshot/screenshot.jpg");
     updateLog(log);
+
+    //The floating point rendering is saved as a PFM file on a background thread.
+    //The log is updated from that thread once the file is written (queued signal).
+    QString pfmPath = qApp->applicationDirPath()+"/screenshot/screenshot.pfm";
+
+    m_pendingSaves.push_back(savePFMAsync(pictureFloat, pfmPath.toStdString(), [this, pfmPath](bool saved)
+    {
+        if(saved)
+            emit updateLog(QString("Screenshot saved : %1").arg(pfmPath));
+        else
+            emit updateLog(QString("Could not save the screenshot : %1").arg(pfmPath));
+    }));
+
+    //Forget the saves that are finished
+    for(size_t k = m_pendingSaves.size() ; k-- > 0 ;)
+    {
+        if(m_pendingSaves[k].wait_for(chrono::seconds(0)) == future_status::ready)
+        {
+            m_pendingSaves.erase(m_pendingSaves.begin()+k);
+        }
+    }
 }
 
 /**
@@ -875,7 +993,7 @@ void GLDisplay::chooseDiffuseMap()
     QString chosenFile = QFileDialog::getOpenFileName(this,
                             tr("Choose diffuse map"),
                             QDir::currentPath(),
-                            QString(tr("All Images files (*.jpg *.jpeg *.png *.bmp *.tif *.pfm);;JPEG (*.jpg *.jpeg);;PNG (*.png);;BMP (*.bmp);;TIFF (*.tif);;PFM (*.pfm)")));
+                            QString(tr("All Images files (*.jpg *.jpeg *.png *.bmp *.tif *.pfm *.hdr);;JPEG (*.jpg *.jpeg);;PNG (*.png);;BMP (*.bmp);;TIFF (*.tif);;PFM (*.pfm);;Radiance HDR (*.hdr)")));
 
     if (!chosenFile.isEmpty()){
         emit updateDiffuseMapPath(chosenFile);
@@ -921,7 +1039,7 @@ void GLDisplay::chooseSpecularMap()
     QString chosenFile = QFileDialog::getOpenFileName(this,
                             tr("Choose specular map"),
                             QDir::currentPath(),
-                            QString(tr("All Images files (*.jpg *.jpeg *.png *.bmp *.tif *.pfm);;JPEG (*.jpg *.jpeg);;PNG (*.png);;BMP (*.bmp);;TIFF (*.tif);;PFM (*.pfm)")));
+                            QString(tr("All Images files (*.jpg *.jpeg *.png *.bmp *.tif *.pfm *.hdr);;JPEG (*.jpg *.jpeg);;PNG (*.png);;BMP (*.bmp);;TIFF (*.tif);;PFM (*.pfm);;Radiance HDR (*.hdr)")));
 
     if (!chosenFile.isEmpty()){
         emit updateSpecularMapPath(chosenFile);
@@ -966,7 +1084,7 @@ void GLDisplay::chooseNormalMap()
     QString chosenFile = QFileDialog::getOpenFileName(this,
                             tr("Choose normal map"),
                             QDir::currentPath(),
-                            QString(tr("All Images files (*.jpg *.jpeg *.png *.bmp *.tif *.pfm);;JPEG (*.jpg *.jpeg);;PNG (*.png);;BMP (*.bmp);;TIFF (*.tif);;PFM (*.pfm)")));
+                            QString(tr("All Images files (*.jpg *.jpeg *.png *.bmp *.tif *.pfm *.hdr);;JPEG (*.jpg *.jpeg);;PNG (*.png);;BMP (*.bmp);;TIFF (*.tif);;PFM (*.pfm);;Radiance HDR (*.hdr)")));
 
     if (!chosenFile.isEmpty()){
         emit updateNormalMapPath(chosenFile);
@@ -1011,7 +1129,7 @@ void GLDisplay::chooseRoughnessMap()
     QString chosenFile = QFileDialog::getOpenFileName(this,
                             tr("Choose roughness map"),
                             QDir::currentPath(),
-                            QString(tr("All Images files (*.jpg *.jpeg *.png *.bmp *.tif *.pfm);;JPEG (*.jpg *.jpeg);;PNG (*.png);;BMP (*.bmp);;TIFF (*.tif);;PFM (*.pfm)")));
+                            QString(tr("All Images files (*.jpg *.jpeg *.png *.bmp *.tif *.pfm *.hdr);;JPEG (*.jpg *.jpeg);;PNG (*.png);;BMP (*.bmp);;TIFF (*.tif);;PFM (*.pfm);;Radiance HDR (*.hdr)")));
 
     if (!chosenFile.isEmpty()){
         emit updateRoughnessMapPath(chosenFile);
@@ -1045,6 +1163,73 @@ void GLDisplay::loadRoughnessMap(QString filePath)
   }
 }
 
+/**
+ * Opens a QFileDialog to choose the mesh of the object.
+ * The mesh can be a .off, .ply or .obj file.
+ * @brief chooseMesh
+ */
+void GLDisplay::chooseMesh()
+{
+    //Let the user choose a file
+    QString chosenFile = QFileDialog::getOpenFileName(this,
+                            tr("Choose mesh"),
+                            QDir::currentPath(),
+                            QString(tr("All mesh files (*.off *.ply *.obj);;OFF (*.off);;PLY (*.ply);;OBJ (*.obj)")));
+
+    if (!chosenFile.isEmpty()){
+        emit updateMeshPath(chosenFile);
+    }
+}
+
+/**
+ * Loads the mesh given in the file path as the mesh of the object.
+ * The mesh can be a .off, .ply or .obj file.
+ * @brief loadMesh
+ * @param filePath
+ */
+void GLDisplay::loadMesh(QString filePath)
+{
+  if(filePath.size()>0)
+  {
+       bool loaded = m_scene.loadMesh(filePath.toStdString(), 0);
+
+       if(!loaded)
+       {
+           QString error = QString("Could not load mesh : \n%1\n\n").arg(filePath);
+           emit updateLog(error);
+       }
+       else
+       {
+           QString text = QString("Mesh correctly loaded : \n%1\n\n").arg(filePath);
+           emit updateLog(text);
+       }
+
+       updateGL();
+  }
+}
+
+/**
+ * Enables and disables the compact vertex format (see CompressedMesh) : 20 bytes per vertex decoded by the vertex shader.
+ * @brief enableCompactVertices
+ * @param enable
+ */
+void GLDisplay::enableCompactVertices(bool enable)
+{
+    m_compactVertices = enable;
+    updateCompactVertices();
+    updateGL();
+}
+
+/**
+ * Compresses the meshes of the scene for the compact vertex format if it is enabled and if the shader decodes it.
+ * The float meshes are used otherwise.
+ * @brief updateCompactVertices
+ */
+void GLDisplay::updateCompactVertices()
+{
+    m_scene.setCompactVertices(m_compactVertices && m_shaderProgram.uniformLocation("compressedVertices") != -1);
+}
+
 /**
  * Opens a QFileDialog to choose the vertex shader.
  * @brief chooseVertexShader
@@ -1113,21 +1298,23 @@ void GLDisplay::loadShaders(QString vertexShaderPath, QString fragmentShaderPath
         emit updateLog(QString("Shaders could not be loaded : \n%1\n%2\n\n").arg(vertexShaderPath).arg(fragmentShaderPath));
     }
 
+    //The new shaders may not decode the compact vertex format
+    updateCompactVertices();
     updateGL();
 }
 
 /**
- * Loads an environment map given its path (without the file extension assumed to be PFM).
+ * Loads an environment map given its path (without the file extension : Radiance HDR or PFM).
  * @brief loadEnvironmentMap
  * @param environmentMapPathNoExtension
  * @return
  */
 bool GLDisplay::loadEnvironmentMap(QString environmentMapPathNoExtension)
 {
-    //Assumes .pfm extension
-    string EMDiffuse = environmentMapPathNoExtension.toStdString() + string("_diffuse.pfm");
-    string EMRough = environmentMapPathNoExtension.toStdString() + string("_rough.pfm");
-    environmentMapPathNoExtension += QString(".pfm");
+    //Uses the .hdr files if they exist, the .pfm files otherwise
+    string EMDiffuse = Scene::environmentMapFilePath(environmentMapPathNoExtension.toStdString() + string("_diffuse"));
+    string EMRough = Scene::environmentMapFilePath(environmentMapPathNoExtension.toStdString() + string("_rough"));
+    environmentMapPathNoExtension = QString::fromStdString(Scene::environmentMapFilePath(environmentMapPathNoExtension.toStdString()));
 
     bool correctlyLoaded = m_scene.loadEnvironmentMap(environmentMapPathNoExtension.toStdString(), EMDiffuse, EMRough);
 
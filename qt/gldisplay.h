@@ -58,6 +58,8 @@
 #include <QGLShaderProgram>
 #include <QGLWidget>
 #include <QMatrix>
+#include <QMatrix3x3>
+#include <QMatrix4x4>
 #include <QVector>
 #include <QVector2D>
 #include <QSize>
@@ -72,6 +74,8 @@
 #include <string>
 #include <sstream>
 #include <iostream>
+#include <vector>
+#include <future>
 
 class GLDisplay : public QGLWidget
 {
@@ -116,6 +120,14 @@ class GLDisplay : public QGLWidget
          */
         void renderBackground();
 
+        /**
+         * Returns the rotation of the environment map around the y axis at the current time of the animation
+         * (360 degrees in 40 s). The shaders turn their lookup directions in the cubemaps with this matrix.
+         * @brief environmentMapRotation
+         * @return
+         */
+        QMatrix3x3 environmentMapRotation() const;
+
         /**
          * Draws the number of frame per second on the OpenGL window.
          * @brief drawFPS
@@ -127,7 +139,7 @@ class GLDisplay : public QGLWidget
          * @brief sendObjectDataToShaders
          * @param object
          */
-        void sendObjectDataToShaders(Object &object);
+        void sendObjectDataToShaders(const Object &object);
 
         /**
          * Creates an animation of the scene.
@@ -143,6 +155,13 @@ class GLDisplay : public QGLWidget
          */
         void loadShaders(QString vertexShaderPath, QString fragmentShaderPath);
 
+        /**
+         * Compresses the meshes of the scene for the compact vertex format if it is enabled and if the shader decodes it.
+         * The float meshes are used otherwise.
+         * @brief updateCompactVertices
+         */
+        void updateCompactVertices();
+
         /**
          * Loads an environment map given its path (without the file extension assumed to be PFM).
          * @brief loadEnvironmentMap
@@ -232,6 +251,12 @@ class GLDisplay : public QGLWidget
          */
         void updateRoughnessMapPath(QString);
 
+        /**
+         * Sends the path of the mesh.
+         * @brief updateMeshPath
+         */
+        void updateMeshPath(QString);
+
         /**
          * Sends the path of the vertex shader.
          * @brief updateVertexShaderPath
@@ -259,6 +284,7 @@ class GLDisplay : public QGLWidget
 
         /**
          * Takes a screenshot and saves it to the folder /screenshot/.
+         * The floating point rendering is also saved as a PFM file without blocking the interface.
          * @brief takeScreenshot
          */
         void takeScreenshot();
@@ -336,6 +362,28 @@ class GLDisplay : public QGLWidget
          */
         void loadRoughnessMap(QString filePath);
 
+        /**
+         * Opens a QFileDialog to choose the mesh of the object.
+         * The mesh can be a .off, .ply or .obj file.
+         * @brief chooseMesh
+         */
+        void chooseMesh();
+
+        /**
+         * Loads the mesh given in the file path as the mesh of the object.
+         * The mesh can be a .off, .ply or .obj file.
+         * @brief loadMesh
+         * @param filePath
+         */
+        void loadMesh(QString filePath);
+
+        /**
+         * Enables and disables the compact vertex format (see CompressedMesh) : 20 bytes per vertex decoded by the vertex shader.
+         * @brief enableCompactVertices
+         * @param enable
+         */
+        void enableCompactVertices(bool enable);
+
         /**
          * Opens a QFileDialog to choose the vertex shader.
          * @brief chooseVertexShader
@@ -353,6 +401,7 @@ class GLDisplay : public QGLWidget
 
         //Framebuffer for highres rendering
         FrameBuffer m_framebuffer;  /*!< Framebuffer. */
+        Object m_screenQuad;  /*!< Quad covering the screen to display the framebuffer and the background. */
 
         //Camera
         Camera m_cameraScene;  /*!< Scene camera. */
@@ -376,12 +425,16 @@ class GLDisplay : public QGLWidget
         //Scene
         Scene m_scene; /*!< Scene. */
         bool m_environmentMapping; /*!< Boolean that is true if the environment mapping is on. */
+        bool m_compactVertices; /*!< Boolean that is true if the meshes are rendered with the compact vertex format. */
         float m_exposure; /*!< Exposure of the rendering. */
 
         //Animation
         bool m_animationStarted; /*!< Boolean that is true if the animation is on.  */
         QTimer m_updateDisplayTimer; /*!< Timer that starts during the animation. Required to update the display during the animation.  */
         QTime m_animationTime; /*!< Time to make the animation */
+
+        //Saves
+        std::vector<std::future<bool> > m_pendingSaves; /*!< PFM files being saved on a background thread. */
 };
 
 #endif // GLDISPLAY_H
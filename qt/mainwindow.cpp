@@ -41,6 +41,8 @@
 #include "qt/mainwindow.h"
 #include "ui_mainwindow.h"
 
+#include <sstream>
+
 using namespace std;
 
 /**
@@ -57,6 +59,7 @@ MainWindow::MainWindow(QWidget *parent) : QMainWindow(parent), ui(new Ui::MainWi
     format.setSamples(16);
     ui->m_glWidget->setFormat(format);
 
+    updateEnvironmentMapPreview(ui->m_EMComboBox->currentText());
 }
 
 /**
@@ -110,6 +113,88 @@ QString MainWindow::EMNameToFilePath(QString environmentMapName)
     return QString("");
 }
 
+/**
+ * Shows a low resolution version of the environment map in the user interface.
+ * @brief updateEnvironmentMapPreview
+ * @param environmentMapName
+ */
+void MainWindow::updateEnvironmentMapPreview(QString environmentMapName)
+{
+    string filePath = Scene::environmentMapFilePath(EMNameToFilePath(environmentMapName).toStdString());
+    cv::Mat preview;
+
+    //The previews are kept in the cache of the environment maps
+    DataCache cache(Scene::cacheDirectory(filePath));
+    ostringstream parameters;
+    parameters << "preview " << ui->m_EMPreviewLabel->width();
+    uint64_t key = cacheKey(hashFile(filePath), parameters.str());
+
+    DataCacheEntry entry;
+
+    if(key != 0 && cache.load(key, entry))
+    {
+        preview = entry.getImage(0);
+    }
+    else
+    {
+        if(filePath.substr(filePath.size()-3, 3) == string("hdr"))
+        {
+            //RLE scanlines cannot be skipped : the whole HDR file is decoded and resized
+            cv::Mat environmentMap = loadHDR(filePath);
+
+            if(!environmentMap.empty())
+            {
+                int previewWidth = min(environmentMap.cols, ui->m_EMPreviewLabel->width());
+                int previewHeight = max(1, environmentMap.rows*previewWidth/environmentMap.cols);
+                cv::resize(environmentMap, preview, cv::Size(previewWidth, previewHeight), 0, 0, cv::INTER_AREA);
+            }
+        }
+        else
+        {
+            ifstream file(filePath.c_str(), ios::in | ios::binary);
+            PFMHeader header;
+
+            if(!file || !readPFMHeader(file, header) || header.numberOfComponents != 3)
+            {
+                ui->m_EMPreviewLabel->clear();
+                return;
+            }
+
+            file.close();
+
+            //The environment map is halved until it is about the size of the preview
+            int levels = 0;
+            while((header.width >> (levels+1)) >= ui->m_EMPreviewLabel->width())
+            {
+                levels++;
+            }
+
+            preview = loadPFMDownsampled(filePath, levels);
+        }
+
+        if(!preview.empty() && key != 0)
+        {
+            cache.store(key, vector<cv::Mat>(1, preview));
+        }
+    }
+
+    if(preview.empty())
+    {
+        ui->m_EMPreviewLabel->clear();
+        return;
+    }
+
+    //Apply the gamma and convert to 8 bits (values above 1 are saturated)
+    cv::Mat previewWithGamma, preview8U;
+    gammaCorrection(preview, previewWithGamma, 2.2);
+    previewWithGamma.convertTo(preview8U, CV_8UC3, 255.0);
+
+    //OpenCV stores the color as BGR
+    QImage previewImage = QImage(preview8U.data, preview8U.cols, preview8U.rows, preview8U.step, QImage::Format_RGB888).rgbSwapped();
+
+    ui->m_EMPreviewLabel->setPixmap(QPixmap::fromImage(previewImage));
+}
+
 /**
  * Loads the vertex and fragment shaders.
  * @brief loadShaders
@@ -155,6 +240,8 @@ void MainWindow::loadEnvironmentMap()
  */
 void MainWindow::loadEnvironmentMap(QString environmentMapName)
 {
+    updateEnvironmentMapPreview(environmentMapName);
+
     bool isEMEnabled = ui->m_EMCheckbox->isChecked();
 
     //If environment mapping is enable
@@ -43,6 +43,8 @@
 #include "qt/gldisplay.h"
 
 #include <QMainWindow>
+#include <QImage>
+#include <QPixmap>
 
 namespace Ui {
 class MainWindow;
@@ -73,6 +75,13 @@ class MainWindow : public QMainWindow
          */
         QString EMNameToFilePath(QString environmentMapName);
 
+        /**
+         * Shows a low resolution version of the environment map in the user interface.
+         * @brief updateEnvironmentMapPreview
+         * @param environmentMapName
+         */
+        void updateEnvironmentMapPreview(QString environmentMapName);
+
     public slots:
 
         /**